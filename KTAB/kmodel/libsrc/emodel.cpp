@@ -22,7 +22,10 @@
 // --------------------------------------------
 
 #include <assert.h>
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 #include "emodel.h"
 
@@ -43,9 +46,16 @@ EModel<PT>::EModel(PRNG * r, string desc) : Model(r, desc) {
 
 template <class PT>
 void EModel<PT>::setOptions() {
-    assert(nullptr != enumOptions);
     assert(0 == theta.size());
-    theta = enumOptions();
+    if (nullptr != enumOptions) {
+        theta = enumOptions();
+        numOpt = theta.size();
+    }
+    else {
+        assert(nullptr != makeOption);
+        assert(0 < optionCount);
+        numOpt = optionCount;
+    }
     return;
 }
 
@@ -62,8 +72,8 @@ EModel<PT>::~EModel() {
 
 
 template <class PT>
-unsigned int EModel<PT>::numOptions() const {
-    return theta.size();
+uint64_t EModel<PT>::numOptions() const {
+    return numOpt;
 }
 
 
@@ -76,13 +86,70 @@ PT* EModel<PT>::nthOption(unsigned int i) const {
 }
 
 
+template <class PT>
+PT EModel<PT>::option(uint64_t i) const {
+    assert(i < numOpt);
+    if (0 < theta.size()) {
+        return *(theta[i]);
+    }
+    return makeOption(i);
+}
+
+
+template <class PT>
+void EModel<PT>::forEachChunk(function<void(uint64_t j0, const vector<PT> & opts)> f, unsigned int nt) const {
+    assert(0 < chunkLen);
+    const uint64_t numChunk = (numOpt + chunkLen - 1) / chunkLen;
+    if (0 == nt) {
+        nt = std::thread::hardware_concurrency();
+    }
+    if (0 == nt) { // not computable or not well defined
+        nt = 1;
+    }
+    if (numChunk < nt) {
+        nt = numChunk;
+    }
+
+    // Each worker has its own buffer, and claims the next unclaimed chunk
+    std::atomic<uint64_t> nextChunk(0);
+    auto worker = [this, &f, &nextChunk, numChunk]() {
+        auto opts = vector<PT>();
+        opts.reserve((numOpt < chunkLen) ? numOpt : chunkLen);
+        uint64_t c = nextChunk++;
+        while (c < numChunk) {
+            const uint64_t j0 = c * chunkLen;
+            const uint64_t j1 = (numOpt < j0 + chunkLen) ? numOpt : (j0 + chunkLen);
+            opts.clear();
+            for (uint64_t j = j0; j < j1; j++) {
+                opts.push_back(option(j));
+            }
+            f(j0, opts);
+            c = nextChunk++;
+        }
+        return;
+    };
+
+    if (nt <= 1) {
+        worker();
+        return;
+    }
+    auto ts = vector<std::thread>();
+    for (unsigned int t = 0; t < nt; t++) {
+        ts.push_back(std::thread(worker));
+    }
+    for (auto& t : ts) {
+        t.join();
+    }
+    return;
+}
+
+
 
 // --------------------------------------------
 template <class PT>
-EPosition<PT>::EPosition(EModel<PT>* m, int n) : Position() {
+EPosition<PT>::EPosition(EModel<PT>* m, uint64_t n) : Position() {
     assert(nullptr != m);
     eMod = m;
-    assert(0 <= n);
     assert(n < eMod->numOptions());
     ndx = n;
 }
@@ -90,7 +157,6 @@ EPosition<PT>::EPosition(EModel<PT>* m, int n) : Position() {
 template <class PT>
 EPosition<PT>::~EPosition() {
     eMod = nullptr;
-    ndx = -1;
 }
 
 // --------------------------------------------
@@ -104,29 +170,149 @@ EState<PT>::~EState() {
     // nothing yet
 }
 
+template <class PT>
+uint64_t EState<PT>::posNdx(unsigned int i) const {
+    assert(i < pstns.size());
+    auto ep = (const EPosition<PT>*) pstns[i];
+    assert(nullptr != ep);
+    return ep->index();
+}
+
+
 template <class PT>
 void EState<PT>::setAllAUtil(ReportingLevel rl) {
-    // nothing yet
+    if (nullptr != getAUtils) {
+        aUtil = getAUtils();
+        return;
+    }
+
+    // Everyone knows everyone's values, so all the estimates are the same.
+    // Each position's values are one row of optVals, read straight across.
+    const KMatrix & vs = values();
+    const unsigned int na = model->numAct;
+    assert(na == pstns.size());
+    auto u = KMatrix(na, na);
+    for (unsigned int j = 0; j < na; j++) {
+        const uint64_t nj = posNdx(j);
+        assert(nj < vs.numR()); // kept values are few enough to index by unsigned int
+        for (unsigned int i = 0; i < na; i++) {
+            u(i, j) = vs(nj, i);
+        }
+    }
+    aUtil = vector<KMatrix>(na, u);
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        klogf("Utility to actors of positions: \n");
+        u.mPrintf(" %+8.3f ");
+        klogf("\n");
+    }
     return;
 }
 
+
+template <class PT>
+KMatrix EState<PT>::optionProbs(const VUI & opts, const KMatrix & w, VotingRule vr, VPModel vpm) const {
+    const KMatrix & vs = values();
+    const unsigned int na = vs.numC();
+    const unsigned int no = opts.size();
+    assert(0 < no);
+    assert(na == w.numC());
+    assert(1 == w.numR());
+    auto vfn = [vr, &w, &vs, &opts](unsigned int k, unsigned int i, unsigned int j) {
+        return Model::vote(vr, w(0, k), vs(opts[i], k), vs(opts[j], k));
+    };
+    auto pv = Model::vProbPairs(vpm, vfn, na, no);
+    return Model::probCE(PCEModel::ConditionalPCM, pv);
+}
+
 template <class PT>
 void EState<PT>::setValues() {
     auto eMod = (EModel<PT>*) model;
     const unsigned int numAct = eMod->numAct;
-    const unsigned int numOpt = eMod->theta.size();
-    assert(numOpt == eMod->numOptions());
+    const uint64_t numOpt = eMod->numOptions();
+    assert(0 < numAct);
     assert(0 < numOpt);
-    auto actorVals = KMatrix(numAct, numOpt);
-    for (unsigned int j = 0; j < numOpt; j++) {
-        vector<double> vp = actorVFn(j, this);
-        assert(numAct == vp.size());
+    assert((nullptr != actorVFn) || (nullptr != optionVFn) || (nullptr != chunkVFn));
+
+    // Values are written straight into their rows of optVals, if it is kept,
+    // or else into a buffer for just that chunk.
+    const bool keep = (numAct * numOpt <= eMod->maxStoredValues);
+    optVals = keep ? KMatrix(numOpt, numAct) : KMatrix();
+    bestOpt = vector<uint64_t>(numAct, numOpt); // numOpt means none yet
+    bestVal = vector<double>(numAct, 0.0);
+    std::mutex bestMtx;
+
+    auto evalChunk = [this, eMod, numAct, numOpt, keep, &bestMtx](uint64_t j0, const vector<PT> & opts) {
+        const unsigned int nc = opts.size();
+        KMatrix buff = keep ? KMatrix() : KMatrix(nc, numAct);
+        KView cv = keep ? optVals.block(j0, 0, nc, numAct) : buff.view();
+
+        if (nullptr != chunkVFn) {
+            chunkVFn(j0, opts, cv);
+        }
+        else if (nullptr != optionVFn) {
+            for (unsigned int k = 0; k < nc; k++) {
+                optionVFn(j0 + k, opts[k], cv.row(k));
+            }
+        }
+        else {
+            for (unsigned int k = 0; k < nc; k++) {
+                vector<double> vp = actorVFn(j0 + k, eMod);
+                assert(numAct == vp.size());
+                for (unsigned int i = 0; i < numAct; i++) {
+                    cv(k, i) = vp[i];
+                }
+            }
+        }
+
+        // best in this chunk, then merged. Ties go to the lower index,
+        // so the result does not depend on which thread got which chunk.
+        auto cb = vector<unsigned int>(numAct, 0);
+        for (unsigned int k = 1; k < nc; k++) {
+            for (unsigned int i = 0; i < numAct; i++) {
+                cb[i] = (cv(cb[i], i) < cv(k, i)) ? k : cb[i];
+            }
+        }
+        std::lock_guard<std::mutex> lk(bestMtx);
         for (unsigned int i = 0; i < numAct; i++) {
-            actorVals(i, j) = vp[i];
+            const double v = cv(cb[i], i);
+            const uint64_t j = j0 + cb[i];
+            if ((numOpt == bestOpt[i]) || (bestVal[i] < v) || ((v == bestVal[i]) && (j < bestOpt[i]))) {
+                bestOpt[i] = j;
+                bestVal[i] = v;
+            }
         }
-    }
+        if (nullptr != useValues) {
+            useValues(j0, cv);
+        }
+        return;
+    };
+
+    eMod->forEachChunk(evalChunk, eMod->numThreads);
     return;
 }
+
+
+template <class PT>
+uint64_t EState<PT>::bestOption(unsigned int i) const {
+    assert(i < bestOpt.size());
+    return bestOpt[i];
+}
+
+
+template <class PT>
+double EState<PT>::bestValue(unsigned int i) const {
+    assert(i < bestVal.size());
+    return bestVal[i];
+}
+
+
+template <class PT>
+const KMatrix & EState<PT>::values() const {
+    if (!valuesKept()) {
+        throw KException("EState<PT>::values: too many values were computed to keep");
+    }
+    return optVals;
+}
 // --------------------------------------------
 // These functions do not need to used outside this file.
 // They are just here to prompt the linker. Another approach is
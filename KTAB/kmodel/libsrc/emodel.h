@@ -59,6 +59,10 @@ using std::vector;
 // this model relies on an explicit enumeration of all possible
 // outcomes/positions: a few tens of thousands of discrete choices.
 // PT is the position-type
+//
+// Larger spaces need not be held in memory at all: if each option can be
+// made from its index, then options are made on demand, a chunk at a time,
+// and only one chunk exists at once.
 
 template <class PT>
 class EModel : public Model {
@@ -67,17 +71,41 @@ public:
     virtual ~EModel();
 
     void setOptions();
-    unsigned int numOptions() const;
-    PT* nthOption(unsigned int i) const;
+    uint64_t numOptions() const;
+    PT* nthOption(unsigned int i) const; // only if theta was enumerated
+
+    // the i-th option, whether enumerated or made on demand
+    PT option(uint64_t i) const;
+
+    // Call f on each chunk of up to chunkLen options, made into a contiguous
+    // buffer which is reused from chunk to chunk. j0 is the index of the first
+    // option in the chunk. With nt threads (0 means one per core), f is called
+    // concurrently on different chunks, in no particular order, so it must
+    // be safe to do so; makeOption must be too.
+    void forEachChunk(function<void(uint64_t j0, const vector<PT> & opts)> f, unsigned int nt = 1) const;
+
+    uint64_t chunkLen = 4096;
+    // for EState::setValues; 0 means one per core. More than one thread is
+    // opt-in, as actorVFn and makeOption are then called concurrently.
+    unsigned int numThreads = 1;
 
+    // EState::setValues keeps every actor's value for every option only if
+    // there are no more than this many of them.
+    uint64_t maxStoredValues = ((uint64_t)1) << 24;
 
     // you have to provide these λ-fns
 
     // Enumerate theta, the set of options
     function <vector <PT*>()> enumOptions = nullptr;
 
+    // Or, instead of enumOptions, set the number of options and
+    // provide a function to make the i-th one.
+    uint64_t optionCount = 0;
+    function <PT(uint64_t i)> makeOption = nullptr;
+
 protected:
     vector <PT*> theta = {}; // the enumerated space of all possible positions/outcomes
+    uint64_t numOpt = 0;
 
 
 private:
@@ -90,12 +118,20 @@ private:
 template <class PT>
 class EPosition : public Position {
 public:
-    EPosition(EModel<PT>* m, int n);
+    EPosition(EModel<PT>* m, uint64_t n);
     virtual ~EPosition();
+    // the model is not owned, so copies may simply share it
+    EPosition(const EPosition&) = default;
+    EPosition& operator=(const EPosition&) = default;
+    uint64_t index() const { return ndx; };
 
 protected:
+    virtual void print(std::ostream& os) const {
+        os << "Option " << ndx;
+        return;
+    };
     EModel<PT>* eMod = nullptr;
-    int ndx = -1;
+    uint64_t ndx = 0;
 
 private:
 
@@ -107,8 +143,28 @@ class EState : public State {
 public:
     EState(EModel<PT>* mod);
     virtual ~EState();
+
+    // Evaluate every option for every actor, a chunk at a time on each of
+    // EModel::numThreads threads, keeping each actor's best option.
+    // The full matrix of values is kept only if it is small enough
+    // (see EModel::maxStoredValues).
     void setValues();
 
+    uint64_t bestOption(unsigned int i) const;
+    double bestValue(unsigned int i) const;
+    bool valuesKept() const { return (0 < optVals.numC()); };
+
+    // Values are kept option-major: optVals(j,i) is the value to actor i of option j,
+    // so the values of one option are contiguous.
+    const KMatrix & values() const;
+
+    // Probability of each of the given options, by scalar PCE, when the actors
+    // with strengths w (a row-vector) vote over them. Needs the kept values.
+    KMatrix optionProbs(const VUI & opts, const KMatrix & w, VotingRule vr, VPModel vpm) const;
+
+    // index of the option held by actor i
+    uint64_t posNdx(unsigned int i) const;
+
 protected:
     
     void setAllAUtil(ReportingLevel rl);
@@ -118,6 +174,7 @@ protected:
     // probably using the EModel's raw-value matrix, actorVFn,
     // compute and set the aUtils vector of matrices,
     // where (aUtils[h])(i,j) = h's estimate of the utility to actor i of position held by actor j.
+    // If this is not provided, every actor's estimate is taken from the kept values.
     function <vector<KMatrix>()> getAUtils = nullptr;
 
     // Calculate the values to the actors of the j-th option, theta[j].
@@ -128,7 +185,26 @@ protected:
     // Of course, you might do it that way, but you are not required to do so.
     //
     // This has to be lambda-bound to the relevant parameters. Maybe EState, not EModel?
-    function <vector<double>(unsigned int j, const EModel<PT>*)> actorVFn = nullptr;
+    function <vector<double>(uint64_t j, const EModel<PT>*)> actorVFn = nullptr;
+
+    // Better, as nothing is allocated per option: write the actors' values of
+    // option j into the row vals, in place.
+    function <void(uint64_t j, const PT & opt, KView vals)> optionVFn = nullptr;
+
+    // Or calculate the values of a whole chunk of options at once, writing
+    // the values of option j0+k into row k of vals.
+    function <void(uint64_t j0, const vector<PT> & opts, KView vals)> chunkVFn = nullptr;
+
+    // Whichever is used may be called on several threads at once.
+
+    // If set, this sees the values of each chunk (one row per option) as they are
+    // calculated, e.g. to accumulate statistics over an option space too large to keep.
+    // Calls are never concurrent, but chunks come in no particular order.
+    function <void(uint64_t j0, KCView vals)> useValues = nullptr;
+
+    KMatrix optVals = KMatrix();
+    vector<uint64_t> bestOpt = {};
+    vector<double> bestVal = {};
 
 private:
 };
@@ -80,20 +80,200 @@ Model::~Model() {
 
 
 void Model::run() {
-    assert(1 == history.size());
-    State* s0 = history[0];
+    KPROF_SCOPE("Model::run");
+    assert(0 < history.size()); // more than one if restored from a checkpoint
+    assert((HistoryPolicy::Spill != histPolicy) || (nullptr != spill));
+    assert((HistoryPolicy::KeepAll == histPolicy) || (0 < histLast)); // the newest state steps next
+    State* s0 = history[history.size() - 1];
     bool done = false;
-    unsigned int iter = 0;
+    unsigned int iter = history.size() - 1;
+    if (0 == iter) {
+        turnProfile = vector<ProbeStats>(1);
+        notifyObservers(0);
+    }
+    turnProfile.resize(history.size());
     while (!done) {
         assert(nullptr != s0);
         assert(nullptr != s0->step);
         iter++;
-        cout << "Starting Model::run iteration " << iter << endl;
+        KLOG(ReportingLevel::Low, rptLvl, "Starting Model::run iteration %u \n", iter);
+        const bool profP = Profiler::enabled();
+        auto ps0 = profP ? Profiler::threadStats() : ProbeStats();
         auto s1 = s0->step();
         addState(s1);
         done = stop(iter, s1);
         s0 = s1;
+        if (profP) {
+            turnProfile.push_back(Profiler::diff(Profiler::threadStats(), ps0));
+            sqlTurnProfile(turnProfile.size() - 1);
+        }
+        else {
+            turnProfile.push_back(ProbeStats());
+        }
+        notifyObservers(iter);
+        trimHistory();
+        if ((0 < ckptEvery) && (0 == iter % ckptEvery)) {
+            saveCheckpoint(ckptFile);
+        }
+    }
+    return;
+}
+
+
+namespace {
+const char ckptTag[8] = { 'K', 'T', 'A', 'B', 'C', 'K', 'P', 'T' };
+const uint32_t ckptVersion = 1;
+}; // end of anonymous namespace
+
+
+void Model::saveCheckpoint(string fName) const {
+    KPROF_SCOPE("Model::saveCheckpoint");
+    assert(0 < history.size());
+    assert(nullptr != history[history.size() - 1]);
+    BinWriter bw(fName, ckptTag, ckptVersion);
+    bw.u32(history.size());
+    bw.str(scenName);
+    bw.str(sqlFileName());
+    bw.str(rng->getState());
+    writeCkptModel(bw);
+
+    unsigned int nSaved = 0;
+    for (auto s : history) {
+        nSaved = nSaved + ((nullptr != s) ? 1 : 0);
+    }
+    bw.u32(nSaved);
+    for (unsigned int t = 0; t < history.size(); t++) {
+        if (nullptr != history[t]) {
+            bw.u32(t);
+            writeCkptState(bw, history[t]);
+        }
+    }
+    bw.close();
+    KLOG(ReportingLevel::Low, rptLvl, "Saved checkpoint of turn %u to %s \n",
+         (unsigned int) history.size() - 1, fName.c_str());
+    return;
+}
+
+
+tuple<string, string> Model::ckptNames(string fName) {
+    BinReader br(fName, ckptTag, ckptVersion);
+    br.u32();
+    const string sn = br.str();
+    const string dn = br.str();
+    return tuple<string, string>(sn, dn);
+}
+
+
+void Model::loadCheckpoint(string fName) {
+    assert(0 == history.size());
+    assert(0 == actrs.size());
+    BinReader br(fName, ckptTag, ckptVersion);
+    const unsigned int nTurns = br.u32();
+    br.str(); // names are for ckptNames
+    br.str();
+    rng->setState(br.str());
+    readCkptModel(br);
+
+    history = vector<State*>(nTurns, nullptr);
+    const unsigned int nSaved = br.u32();
+    for (unsigned int k = 0; k < nSaved; k++) {
+        const unsigned int t = br.u32();
+        if ((nTurns <= t) || (nullptr != history[t])) {
+            throw KException("Model::loadCheckpoint: bad turn number in " + fName);
+        }
+        State* s = readCkptState(br);
+        assert(this == s->model);
+        history[t] = s;
+    }
+    if ((0 == nTurns) || (nullptr == history[nTurns - 1]) || !br.atEnd()) {
+        throw KException("Model::loadCheckpoint: incomplete checkpoint " + fName);
+    }
+    turnProfile = vector<ProbeStats>(nTurns);
+    KLOG(ReportingLevel::Low, rptLvl, "Loaded checkpoint of turn %u from %s \n",
+         nTurns - 1, fName.c_str());
+    return;
+}
+
+
+void Model::writeCkptModel(BinWriter & bw) const {
+    throw KException("Model::writeCkptModel: checkpoints are not supported by this model");
+}
+
+
+void Model::readCkptModel(BinReader & br) {
+    throw KException("Model::readCkptModel: checkpoints are not supported by this model");
+}
+
+
+void Model::writeCkptState(BinWriter & bw, const State* s) const {
+    throw KException("Model::writeCkptState: checkpoints are not supported by this model");
+}
+
+
+State* Model::readCkptState(BinReader & br) {
+    throw KException("Model::readCkptState: checkpoints are not supported by this model");
+}
+
+
+void Model::addObserver(TurnObserver obs) {
+    assert(nullptr != obs);
+    observers.push_back(obs);
+    return;
+}
+
+
+void Model::notifyObservers(unsigned int t) const {
+    assert(t < history.size());
+    for (auto& obs : observers) {
+        obs(t, history[t]);
+    }
+    return;
+}
+
+
+void Model::trimHistory() {
+    if (HistoryPolicy::KeepAll == histPolicy) {
+        return;
+    }
+    // Normally just one state leaves the window each turn. Find the oldest
+    // one not yet dropped, so that states are always spilled in turn order.
+    const unsigned int n = history.size();
+    if (n <= histFirst + histLast) {
+        return;
+    }
+    const unsigned int tHi = n - histLast - 1;
+    unsigned int tLo = tHi;
+    while ((histFirst < tLo) && (nullptr != history[tLo - 1])) {
+        tLo--;
+    }
+    for (unsigned int t = tLo; (t <= tHi) && (nullptr != history[t]); t++) {
+        if (HistoryPolicy::Spill == histPolicy) {
+            spill(t, history[t]);
+        }
+        delete history[t];
+        history[t] = nullptr;
+    }
+    return;
+}
+
+
+void Model::csvTurnProfile(string fName) const {
+    FILE* f = fopen(fName.c_str(), "w");
+    if (nullptr == f) {
+        throw KException("Model::csvTurnProfile: could not open " + fName);
+    }
+    fprintf(f, "Scenario,Turn_t,Probe,Calls,NSec,Allocs\n");
+    for (unsigned int t = 0; t < turnProfile.size(); t++) {
+        const ProbeStats & ps = turnProfile[t];
+        for (unsigned int i = 0; i < ps.size(); i++) {
+            if (0 < ps[i].calls) {
+                fprintf(f, "%s,%u,%s,%llu,%llu,%llu\n", scenName.c_str(), t,
+                        Profiler::probeName(i).c_str(), (unsigned long long) ps[i].calls,
+                        (unsigned long long) ps[i].nsec, (unsigned long long) ps[i].allocs);
+            }
+        }
     }
+    fclose(f);
     return;
 }
 
@@ -157,17 +337,17 @@ KMatrix Model::bigRfromProb(const KMatrix & p, BigRRange rr) {
     function<double(unsigned int, unsigned int)> rfn = nullptr;
     switch (rr) {
     case BigRRange::Min:
-        rfn = [pMin, pMax, p](unsigned int i, unsigned int j) {
+        rfn = [pMin, pMax, &p](unsigned int i, unsigned int j) {
             return (p(i, j) - pMin) / (pMax - pMin);
         };
         break;
     case BigRRange::Mid:
-        rfn = [pMin, pMax, p](unsigned int i, unsigned int j) {
+        rfn = [pMin, pMax, &p](unsigned int i, unsigned int j) {
             return (3 * p(i, j) - (pMax + 2 * pMin)) / (2 * (pMax - pMin));
         };
         break;
     case BigRRange::Max:
-        rfn = [pMin, pMax, p](unsigned int i, unsigned int j) {
+        rfn = [pMin, pMax, &p](unsigned int i, unsigned int j) {
             return (2 * p(i, j) - (pMax + pMin)) / (pMax - pMin);
         };
         break;
@@ -546,6 +726,7 @@ KMatrix Model::vProb(VotingRule vr, VPModel vpm, const KMatrix & w, const KMatri
 
 // Given square matrix of Prob[i>j] returns a column vector for Prob[i]
 KMatrix Model::probCE(PCEModel pcm, const KMatrix & pv) {
+    KPROF_SCOPE("Model::probCE");
     const double pTol = 1E-6;
     unsigned int numOpt = pv.numR();
     assert(numOpt == pv.numC()); // must be square
@@ -595,7 +776,7 @@ KMatrix Model::markovPCE(const KMatrix & pv) {
             double c = fabs(q(i, 0) - p(i, 0));
             change = (c > change) ? c : change;
         }
-        p = q;
+        std::swap(p, q); // q is overwritten in the next pass
         iter++;
         assert(fabs(sum(p) - 1.0) < pTol); // double-check
     }
@@ -629,25 +810,24 @@ KMatrix Model::condPCE(const KMatrix & pv) {
 // Model::vProb(VotingRule vr, const KMatrix & w, const KMatrix & u)
 KMatrix Model::scalarPCE(unsigned int numAct, unsigned int numOpt, const KMatrix & w, const KMatrix & u,
                          VotingRule vr, VPModel vpm, ReportingLevel rl) {
+    KPROF_SCOPE("Model::scalarPCE");
 
-    auto pv = Model::vProb(vr, vpm, w, u);
+    auto pv = Model::vProbPairs(vr, vpm, w, u);
     auto p = Model::probCE(PCEModel::ConditionalPCM, pv);
 
-    if (ReportingLevel::Low < rl) {
-        printf("Num actors: %i \n", numAct);
-        printf("Num options: %i \n", numOpt);
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        klogf("Num actors: %i \n", numAct);
+        klogf("Num options: %i \n", numOpt);
 
 
         if ((numAct <= 20) && (numOpt <= 20)) {
-            cout << "Actor strengths: " << endl;
+            klogf("Actor strengths: \n");
             w.mPrintf(" %6.2f ");
-            cout << endl << flush;
-            cout << "Voting rule: " << vr << endl;
-            // printf("         aka %s \n", KBase::vrName(vr).c_str());
-            cout << flush;
-            cout << "Utility to actors of options: " << endl;
+            klogf("\n");
+            klogf("Voting rule: %s \n", vrName(vr).c_str());
+            klogf("Utility to actors of options: \n");
             u.mPrintf(" %+8.3f ");
-            cout << endl;
+            klogf("\n");
 
             auto vfn = [vr, &w, &u](unsigned int k, unsigned int i, unsigned int j) {
                 double vkij = vote(vr, w(0, k), u(k, i), u(k, j));
@@ -657,18 +837,18 @@ KMatrix Model::scalarPCE(unsigned int numAct, unsigned int numOpt, const KMatrix
             auto c = coalitions(vfn, numAct, numOpt); // c(i,j) = strength of coaltion for i against j
             KMatrix p2 = vProb(vpm, c);  // p(i,j) = prob Ai defeats Aj
 
-            cout << "Coalition strengths of (i:j): " << endl;
+            klogf("Coalition strengths of (i:j): \n");
             c.mPrintf(" %8.3f ");
-            cout << endl;
+            klogf("\n");
 
-            assert(norm(pv - p2) < 1E-8); // better be close
+            assert(norm(pv.toMatrix() - p2) < 1E-8); // better be close
 
-            cout << "Probability Opt_i > Opt_j" << endl;
-            pv.mPrintf(" %.4f ");
-            cout << "Probability Opt_i" << endl;
+            klogf("Probability Opt_i > Opt_j \n");
+            pv.toMatrix().mPrintf(" %.4f ");
+            klogf("Probability Opt_i \n");
             p.mPrintf(" %.4f ");
         }
-        cout << "Found stable PCE distribution" << endl << flush;
+        klogf("Found stable PCE distribution \n");
     }
     return p;
 }
@@ -42,8 +42,11 @@
 #include <sqlite3.h>
 
 #include "kutils.h"
+#include "klog.h"
+#include "kprof.h"
 #include "kmatrix.h"
 #include "prng.h"
+#include "kserial.h"
 
 namespace KBase {
 using std::ostream;
@@ -54,7 +57,6 @@ using std::vector;
 using KBase::KMatrix;
 using KBase::ReportingLevel;
 
-class KMatrix;
 class PRNG;
 class State;
 class Actor;
@@ -112,6 +114,39 @@ enum class BigRAdjust {
 string bigRAName(const BigRAdjust & rAdj);
 ostream& operator << (ostream& os, const BigRAdjust& rAdj);
 
+// How much of its history Model::run keeps in memory. States dropped from
+// memory leave a nullptr in Model::history, so turn t is still history[t].
+enum class HistoryPolicy {
+    KeepAll,       // every state, until the Model is deleted
+    KeepFirstLast, // only the first histFirst and last histLast states
+    Spill          // as KeepFirstLast, but each state goes to Model::spill before it is deleted
+};
+
+// -------------------------------------------------
+// The pairwise victory probabilities pv(i,j) = P[option i beats option j]
+// always satisfy pv(j,i) = 1 - pv(i,j), and pv(i,i) = 1/2. This stores
+// only the strict lower triangle, n(n-1)/2 values instead of n^2, and
+// derives the rest, so the complement relation holds by construction.
+class PairProb {
+public:
+    explicit PairProb(unsigned int n = 0);
+    unsigned int numOpt() const;
+    double operator() (unsigned int i, unsigned int j) const;
+    void set(unsigned int i, unsigned int j, double pij); // sets pv(j,i) as well
+
+    KMatrix toMatrix() const;
+    static PairProb fromMatrix(const KMatrix & pv); // throws KException unless pv(i,j) + pv(j,i) = 1
+    uint64_t memBytes() const; // the object plus its values
+
+protected:
+    // position of pv(i,j), for j < i, in lower
+    static unsigned int ndx(unsigned int i, unsigned int j) {
+        return ((i * (i - 1)) / 2) + j;
+    };
+    unsigned int n = 0;
+    vector<double> lower = {};
+};
+
 // -------------------------------------------------
 // There is not much to say about abstract positions, even
 // though the set of possible positions/outcomes is key
@@ -144,6 +179,11 @@ public:
     VctrPstn();
     VctrPstn(unsigned int nr, unsigned int nc);
     explicit VctrPstn(const KMatrix & m); // copy constructor
+    explicit VctrPstn(KMatrix && m); // takes over m's elements
+    VctrPstn(const VctrPstn & vp) = default;
+    VctrPstn(VctrPstn && vp) = default;
+    VctrPstn & operator=(const VctrPstn & vp) = default;
+    VctrPstn & operator=(VctrPstn && vp) = default;
     virtual ~VctrPstn();
 protected:
     virtual void print(ostream& os) const;
@@ -167,6 +207,9 @@ public:
     virtual vector<MtchPstn> neighbors(unsigned int nVar) const;
     // assumes no interaction between items (permutation requires interaction)
 
+    // e.g. to key an EvalCache; equal matchings have equal hashes
+    uint64_t hash() const;
+
     unsigned int numItm = 0;
     unsigned int numCat = 0;
     VUI match = {}; // must be of length numItm
@@ -178,10 +221,22 @@ private:
 };
 
 
+// What all the genes in one GA have in common: links to the State,
+// which are necessary to evaluate the net support, EU, etc.
+// Genes share one copy of it (a flyweight), rather than each copying the vectors.
+class MtchGeneCtx {
+public:
+    MtchGeneCtx(const vector<Actor*> & as, const vector<MtchPstn*> & ps);
+    const vector<Actor*> actrs;
+    const vector<MtchPstn*> pstns;
+};
+
+
 // bundle up methods relevant to GA over MtchPstn
 class MtchGene : public MtchPstn {
 public:
     MtchGene();
+    explicit MtchGene(shared_ptr<const MtchGeneCtx> c);
     ~MtchGene();
 
     void randomize(PRNG* rng);
@@ -190,14 +245,20 @@ public:
     //void show() const;
     bool equiv(const MtchGene * g2) const;
 
+    // Same as mutate and cross, but overwriting existing genes (e.g. from a GenePool)
+    // instead of allocating new ones. Once the match vectors are the right length,
+    // this does no heap allocation at all.
+    void mutateInto(PRNG * rng, MtchGene * out) const;
+    void crossInto(const MtchGene * g2, PRNG * rng, MtchGene * gA, MtchGene * gB) const;
+
     void setState(vector<Actor*> as, vector<MtchPstn*> ps);
+    void setContext(shared_ptr<const MtchGeneCtx> c);
+    shared_ptr<const MtchGeneCtx> context() const { return ctx; }
 
 protected:
     virtual void print(ostream& os) const;
     void copySelf(MtchGene*) const;
-    // links to the State are necessary to evaluate the net support, EU, etc.
-    vector<Actor*> actrs = {};
-    vector<MtchPstn*> pstns = {};
+    shared_ptr<const MtchGeneCtx> ctx = nullptr;
 };
 
 
@@ -241,6 +302,15 @@ public:
     // calculate column vector P[i] from square matrix pv[i>j]
     static KMatrix probCE(PCEModel pcm, const KMatrix & pv);
 
+    // As above, but the probabilities are packed, and each pair of options is
+    // done once: the coalitions for and against come from one pass over the
+    // actors, and are never stored as a matrix.
+    static PairProb vProbPairs(VPModel vpm, function<double(unsigned int ak, unsigned int pi, unsigned int pj)> vfn,
+                               unsigned int numAct, unsigned int numOpt);
+    static PairProb vProbPairs(VPModel vpm, const KMatrix & c);
+    static PairProb vProbPairs(VotingRule vr, VPModel vpm, const KMatrix & w, const KMatrix & u);
+    static KMatrix probCE(PCEModel pcm, const PairProb & pv);
+
     static KMatrix scalarPCE(unsigned int numAct, unsigned int numOpt, const KMatrix & w,
                              const KMatrix & u, VotingRule vr, VPModel vpm, ReportingLevel rl);
 
@@ -252,6 +322,39 @@ public:
     function <bool(unsigned int iter, const State* s)> stop = nullptr;
     // you have to provide this λ-fn
 
+    // Streaming consumers see each state once, in order: state 0 when run()
+    // starts, then each new state after stop() has looked at it. A new state
+    // has its positions, but its aUtil are not set until it is stepped.
+    typedef function<void(unsigned int t, const State* s)> TurnObserver;
+    void addObserver(TurnObserver obs);
+
+    // The stop λ-fns usually look at states 0 and 1, and at the last two,
+    // which is what is kept by default when the whole history is not.
+    // Code that walks the whole history must allow for nullptr entries
+    // unless the policy is KeepAll.
+    HistoryPolicy histPolicy = HistoryPolicy::KeepAll;
+    unsigned int histFirst = 2;
+    unsigned int histLast = 2;
+    function<void(unsigned int t, const State* s)> spill = nullptr; // required for Spill
+
+    // Binary checkpoints, to resume a long run after a crash, or to fork
+    // what-if runs from a later turn. If ckptEvery is positive, run() saves
+    // a checkpoint to ckptFile after every ckptEvery turns.
+    unsigned int ckptEvery = 0;
+    string ckptFile = "";
+
+    // Saves the number of turns, the PRNG state, the names of the scenario
+    // and database, and each state still in memory, with its turn.
+    // Sub-classes provide the actors and states, see writeCkptModel.
+    void saveCheckpoint(string fName) const;
+
+    // scenario and database names recorded in a checkpoint
+    static tuple<string, string> ckptNames(string fName);
+
+    // How much each step of the run reports to the console. Models run
+    // in bulk (e.g. many runs of an ensemble, in parallel) should be Silent.
+    ReportingLevel rptLvl = ReportingLevel::Medium;
+
     // these should probably be less public and more protected
     vector<Actor*> actrs = {};
     unsigned int numAct = 0;
@@ -259,8 +362,19 @@ public:
     vector<State*> history = {};
 
 
-    // output an existing actor util table, for the given turn, to SQLite
+    // output an existing actor util table, for the given turn, to SQLite.
+    // Does nothing if no database is attached.
     void sqlAUtil(unsigned int t);
+
+    // When profiling is enabled, run() records what this thread's probes
+    // measured during each turn: turnProfile[t] is for the step to history[t],
+    // so turnProfile[0] is empty.
+    vector<ProbeStats> turnProfile = {};
+    void sqlTurnProfile(unsigned int t); // does nothing if no database is attached
+
+    // current size of the attached database (0 if none), i.e. pages times page size
+    uint64_t sqlBytes() const;
+    void csvTurnProfile(string fName) const;
     static void demoSQLite();
 
     static KMatrix bigRfromProb(const KMatrix & p, BigRRange rr);
@@ -279,11 +393,37 @@ protected:
     sqlite3 *smpDB = nullptr; // keep this protected, to ease later multi-threading
     string scenName = "Scen"; // default is set from UTC time
 
+    vector<TurnObserver> observers = {};
+
+    // Restore a checkpoint into this model, which must not have any actors or
+    // states yet. The scenario name and database are left as constructed.
+    // Sub-classes provide a static entry point which builds the model and
+    // calls this (e.g. SMPModel::resume). A restored run() carries on from
+    // the last turn in the checkpoint.
+    void loadCheckpoint(string fName);
+
+    // Sub-classes which support checkpoints override these four. By default,
+    // they throw KException.
+    virtual void writeCkptModel(BinWriter & bw) const; // actors, and anything else not in a State
+    virtual void readCkptModel(BinReader & br);
+    virtual void writeCkptState(BinWriter & bw, const State* s) const;
+    virtual State* readCkptState(BinReader & br);
+
+    // Delete the rows recorded for this scenario at turn t and later, so
+    // that a resumed run does not record them twice.
+    void sqlTruncate(unsigned int t);
+    string sqlFileName() const; // empty if no database is attached
+    void notifyObservers(unsigned int t) const;
+    // drop (or spill) states which the policy no longer keeps
+    void trimHistory();
+
     // this is the basic model of victory dependent on strength-ratio
     static tuple<double, double> vProb(VPModel vpm, const double s1, const double s2);
     
     static KMatrix markovPCE(const KMatrix & pv);
     static KMatrix condPCE(const KMatrix & pv);
+    static KMatrix markovPCE(const PairProb & pv);
+    static KMatrix condPCE(const PairProb & pv);
 private:
 };
 
@@ -318,6 +458,10 @@ public:
 
     void setUENdx();
 
+    // Approximate bytes held by this state, to see how the history grows.
+    // Positions count only as pointers here, as only sub-classes know what is in them.
+    virtual uint64_t memBytes() const;
+
 protected:
     VUI uIndices = {}; // which positions occupied postions are unique, generated by KBase::ueIndices
     VUI eIndices = {}; // to which unique position each occupied postions matches, generated by KBase::ueIndices
@@ -144,7 +144,7 @@ string Model::createTableSQL(unsigned int tn) {
     case 0:
         // position-utility table
         // the estimated utility to each actor of each other's position
-        sql = "create table PosUtil ("  \
+        sql = "create table if not exists PosUtil ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -156,7 +156,7 @@ string Model::createTableSQL(unsigned int tn) {
 
     case 1: // pos-vote table
         // estimated vote of each actor between each pair of positions
-        sql = "create table PosVote ("  \
+        sql = "create table if not exists PosVote ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -168,7 +168,7 @@ string Model::createTableSQL(unsigned int tn) {
         break;
 
     case 2: // pos-prob table. Note that there may be duplicates, unless we limit it to unique positions
-        sql = "create table PosProb ("  \
+        sql = "create table if not exists PosProb ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -178,7 +178,7 @@ string Model::createTableSQL(unsigned int tn) {
         break;
 
     case 3: // pos-equiv table. E(i)= lowest j s.t. Pos(i) ~ Pos(j). if j < i, it is not unique.
-        sql = "create table PosEquiv ("  \
+        sql = "create table if not exists PosEquiv ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Pos_i	INTEGER NOT NULL DEFAULT 0, "\
@@ -189,7 +189,7 @@ string Model::createTableSQL(unsigned int tn) {
     case 4:
         // Utilities are evaluated so that UtilSQ, UtilVict, UtilChlg, UtilContest,
         // UtilTPVict, UtilTPLoss are comparable, i.e. the differences are meaningful
-        sql = "create table UtilContest ("  \
+        sql = "create table if not exists UtilContest ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -203,7 +203,7 @@ string Model::createTableSQL(unsigned int tn) {
     case 5:
         // Utilities are evaluated so that UtilSQ, UtilVict, UtilChlg, UtilContest,
         // UtilTPVict, UtilTPLoss are comparable, i.e. the differences are meaningful
-        sql = "create table UtilChlg ("  \
+        sql = "create table if not exists UtilChlg ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -217,7 +217,7 @@ string Model::createTableSQL(unsigned int tn) {
     case 6:
         // Utilities are evaluated so that UtilSQ, UtilVict, UtilChlg, UtilContest,
         // UtilTPVict, UtilTPLoss are comparable, i.e. the differences are meaningful
-        sql = "create table UtilVict ("  \
+        sql = "create table if not exists UtilVict ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -230,7 +230,7 @@ string Model::createTableSQL(unsigned int tn) {
 
     case 7:
         // h's estimate that i will defeat j, including third party contributions
-        sql = "create table ProbVict ("  \
+        sql = "create table if not exists ProbVict ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -244,7 +244,7 @@ string Model::createTableSQL(unsigned int tn) {
         // h's estimate of utility to k of status quo.
         // Utilities are evaluated so that UtilSQ, UtilVict, UtilChlg, UtilContest,
         // UtilTPVict, UtilTPLoss are comparable, i.e. the differences are meaningful
-        sql = "create table UtilSQ ("  \
+        sql = "create table if not exists UtilSQ ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -254,7 +254,7 @@ string Model::createTableSQL(unsigned int tn) {
         break;
 
     case 9:  // probability ik > j
-        sql = "create table ProbTPVict ("  \
+        sql = "create table if not exists ProbTPVict ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -268,7 +268,7 @@ string Model::createTableSQL(unsigned int tn) {
     case 10: // utility to k of ik>j
         // Utilities are evaluated so that UtilSQ, UtilVict, UtilChlg, UtilContest,
         // UtilTPVict, UtilTPLoss are comparable, i.e. the differences are meaningful
-        sql = "create table UtilTPVict ("  \
+        sql = "create table if not exists UtilTPVict ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -282,7 +282,7 @@ string Model::createTableSQL(unsigned int tn) {
     case 11: // utility to k of i>jk
         // Utilities are evaluated so that UtilSQ, UtilVict, UtilChlg, UtilContest,
         // UtilTPVict, UtilTPLoss are comparable, i.e. the differences are meaningful
-        sql = "create table UtilTPLoss ("  \
+        sql = "create table if not exists UtilTPLoss ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
               "Est_h	INTEGER NOT NULL DEFAULT 0, "\
@@ -293,6 +293,17 @@ string Model::createTableSQL(unsigned int tn) {
               ");";
         break;
 
+    case 12: // what the profiling probes measured during each turn
+        sql = "create table if not exists TurnProfile ("  \
+              "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
+              "Turn_t	INTEGER NOT NULL DEFAULT 0, "\
+              "Probe	TEXT NOT NULL DEFAULT '', "\
+              "Calls	INTEGER NOT NULL DEFAULT 0, "\
+              "NSec	INTEGER NOT NULL DEFAULT 0, "\
+              "Allocs	INTEGER NOT NULL DEFAULT 0"\
+              ");";
+        break;
+
     default:
         throw(KException("Model::createTableSQL unrecognized table number"));
     }
@@ -302,7 +313,10 @@ string Model::createTableSQL(unsigned int tn) {
 
 
 void Model::sqlAUtil(unsigned int t) {
-    assert(nullptr != smpDB);
+    KPROF_SCOPE("Model::sqlAUtil");
+    if (nullptr == smpDB) {
+        return;
+    }
     assert(t < history.size());
     State* st = history[t];
     assert(nullptr != st);
@@ -332,7 +346,7 @@ void Model::sqlAUtil(unsigned int t) {
 
     sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &zErrMsg);
     for (unsigned int h = 0; h < numAct; h++) { // estimator is h
-        KMatrix uij = st->aUtil[h]; // utility to actor i of the position held by actor j
+        const KMatrix & uij = st->aUtil[h]; // utility to actor i of the position held by actor j
         for (unsigned int i = 0; i < numAct; i++) {
             for (unsigned int j = 0; j < numAct; j++) {
                 int rslt = 0;
@@ -356,7 +370,7 @@ void Model::sqlAUtil(unsigned int t) {
         }
     }
     sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &zErrMsg);
-    printf("Stored SQL for turn %u of all estimators, actors, and positions \n", t);
+    KLOG(ReportingLevel::Low, rptLvl, "Stored SQL for turn %u of all estimators, actors, and positions \n", t);
 
     delete sqlBuff;
     sqlBuff = nullptr;
@@ -366,6 +380,133 @@ void Model::sqlAUtil(unsigned int t) {
     return;
 }
 
+
+uint64_t Model::sqlBytes() const {
+    if (nullptr == smpDB) {
+        return 0;
+    }
+    uint64_t pc = 0;
+    uint64_t ps = 0;
+    sqlite3_stmt *stmt;
+    if (SQLITE_OK == sqlite3_prepare_v2(smpDB, "PRAGMA page_count", -1, &stmt, NULL)) {
+        if (SQLITE_ROW == sqlite3_step(stmt)) {
+            pc = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (SQLITE_OK == sqlite3_prepare_v2(smpDB, "PRAGMA page_size", -1, &stmt, NULL)) {
+        if (SQLITE_ROW == sqlite3_step(stmt)) {
+            ps = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    return pc * ps;
+}
+
+
+void Model::sqlTurnProfile(unsigned int t) {
+    if (nullptr == smpDB) {
+        return;
+    }
+    assert(t < turnProfile.size());
+    const ProbeStats & ps = turnProfile[t];
+
+    char* zErrMsg = nullptr;
+    auto sqlBuff = newChars(200);
+    sprintf(sqlBuff,
+            "INSERT INTO TurnProfile (Scenario, Turn_t, Probe, Calls, NSec, Allocs) VALUES ('%s', ?1, ?2, ?3, ?4, ?5)",
+            scenName.c_str());
+    const char* insStr = sqlBuff;
+    sqlite3_stmt *insStmt;
+    sqlite3_prepare_v2(smpDB, insStr, strlen(insStr), &insStmt, NULL);
+
+    sqlite3_exec(smpDB, "BEGIN TRANSACTION", NULL, NULL, &zErrMsg);
+    for (unsigned int i = 0; i < ps.size(); i++) {
+        if (0 == ps[i].calls) {
+            continue;
+        }
+        const string pn = Profiler::probeName(i);
+        int rslt = 0;
+        rslt = sqlite3_bind_int(insStmt, 1, t);
+        assert(SQLITE_OK == rslt);
+        rslt = sqlite3_bind_text(insStmt, 2, pn.c_str(), -1, SQLITE_TRANSIENT);
+        assert(SQLITE_OK == rslt);
+        rslt = sqlite3_bind_int64(insStmt, 3, ps[i].calls);
+        assert(SQLITE_OK == rslt);
+        rslt = sqlite3_bind_int64(insStmt, 4, ps[i].nsec);
+        assert(SQLITE_OK == rslt);
+        rslt = sqlite3_bind_int64(insStmt, 5, ps[i].allocs);
+        assert(SQLITE_OK == rslt);
+        rslt = sqlite3_step(insStmt);
+        assert(SQLITE_DONE == rslt);
+        sqlite3_clear_bindings(insStmt);
+        rslt = sqlite3_reset(insStmt);
+        assert(SQLITE_OK == rslt);
+    }
+    sqlite3_exec(smpDB, "END TRANSACTION", NULL, NULL, &zErrMsg);
+    sqlite3_finalize(insStmt);
+
+    delete[] sqlBuff;
+    sqlBuff = nullptr;
+    return;
+}
+
+
+string Model::sqlFileName() const {
+    if (nullptr == smpDB) {
+        return "";
+    }
+    const char* fn = sqlite3_db_filename(smpDB, "main");
+    return (nullptr == fn) ? string("") : string(fn);
+}
+
+
+void Model::sqlTruncate(unsigned int t) {
+    if (nullptr == smpDB) {
+        return;
+    }
+    // every table with both Scenario and Turn_t columns, whichever sub-class made it
+    auto tNames = vector<string>();
+    sqlite3_stmt *selStmt;
+    const char* selStr = "SELECT name FROM sqlite_master WHERE type = 'table'";
+    sqlite3_prepare_v2(smpDB, selStr, strlen(selStr), &selStmt, NULL);
+    while (SQLITE_ROW == sqlite3_step(selStmt)) {
+        tNames.push_back((const char*)sqlite3_column_text(selStmt, 0));
+    }
+    sqlite3_finalize(selStmt);
+
+    char* zErrMsg = nullptr;
+    sqlite3_exec(smpDB, "BEGIN TRANSACTION", NULL, NULL, &zErrMsg);
+    for (auto& tn : tNames) {
+        bool scenP = false;
+        bool turnP = false;
+        const string infoStr = "PRAGMA table_info(" + tn + ")";
+        sqlite3_prepare_v2(smpDB, infoStr.c_str(), infoStr.length(), &selStmt, NULL);
+        while (SQLITE_ROW == sqlite3_step(selStmt)) {
+            const string cn = (const char*)sqlite3_column_text(selStmt, 1);
+            scenP = scenP || ("Scenario" == cn);
+            turnP = turnP || ("Turn_t" == cn);
+        }
+        sqlite3_finalize(selStmt);
+        if (!(scenP && turnP)) {
+            continue;
+        }
+        const string delStr = "DELETE FROM " + tn + " WHERE Scenario = ?1 AND Turn_t >= ?2";
+        sqlite3_stmt *delStmt;
+        sqlite3_prepare_v2(smpDB, delStr.c_str(), delStr.length(), &delStmt, NULL);
+        int rslt = 0;
+        rslt = sqlite3_bind_text(delStmt, 1, scenName.c_str(), -1, SQLITE_TRANSIENT);
+        assert(SQLITE_OK == rslt);
+        rslt = sqlite3_bind_int(delStmt, 2, t);
+        assert(SQLITE_OK == rslt);
+        rslt = sqlite3_step(delStmt);
+        assert(SQLITE_DONE == rslt);
+        sqlite3_finalize(delStmt);
+    }
+    sqlite3_exec(smpDB, "END TRANSACTION", NULL, NULL, &zErrMsg);
+    return;
+}
+
 } // end of namespace
 
 // --------------------------------------------
@@ -0,0 +1,247 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+//
+// Packed pairwise victory probabilities, and the PCE solvers which use them.
+// The solvers do exactly the arithmetic of their KMatrix counterparts,
+// except that pv(j,i) is computed as 1 - pv(i,j) rather than stored.
+//
+// --------------------------------------------
+
+#include <assert.h>
+
+#include "kmodel.h"
+
+namespace KBase {
+using std::get;
+using std::tuple;
+
+// --------------------------------------------
+
+PairProb::PairProb(unsigned int nOpt) : n(nOpt), lower() {
+    const unsigned int nl = (0 < n) ? ((n * (n - 1)) / 2) : 0;
+    lower = vector<double>(nl, 0.5);
+}
+
+
+unsigned int PairProb::numOpt() const {
+    return n;
+}
+
+
+double PairProb::operator() (unsigned int i, unsigned int j) const {
+    assert(i < n);
+    assert(j < n);
+    double pij = 0.5;
+    if (j < i) {
+        pij = lower[ndx(i, j)];
+    }
+    else if (i < j) {
+        pij = 1.0 - lower[ndx(j, i)];
+    }
+    return pij;
+}
+
+
+void PairProb::set(unsigned int i, unsigned int j, double pij) {
+    assert(i < n);
+    assert(j < n);
+    assert(i != j); // the diagonal is always 1/2
+    assert(0.0 <= pij);
+    assert(pij <= 1.0);
+    if (j < i) {
+        lower[ndx(i, j)] = pij;
+    }
+    else {
+        lower[ndx(j, i)] = 1.0 - pij;
+    }
+    return;
+}
+
+
+KMatrix PairProb::toMatrix() const {
+    auto pv = KMatrix(n, n);
+    for (unsigned int i = 0; i < n; i++) {
+        for (unsigned int j = 0; j < n; j++) {
+            pv(i, j) = (*this)(i, j);
+        }
+    }
+    return pv;
+}
+
+
+PairProb PairProb::fromMatrix(const KMatrix & pv) {
+    const double pTol = 1E-6; // as in Model::probCE
+    const unsigned int nOpt = pv.numR();
+    if (nOpt != pv.numC()) {
+        throw KException("PairProb::fromMatrix: matrix is not square");
+    }
+    auto pp = PairProb(nOpt);
+    for (unsigned int i = 0; i < nOpt; i++) {
+        for (unsigned int j = 0; j < i; j++) {
+            const double pij = pv(i, j);
+            if ((pij < 0.0) || (1.0 < pij) || (pTol < fabs(pij + pv(j, i) - 1.0))) {
+                throw KException("PairProb::fromMatrix: pv(i,j) + pv(j,i) is not 1");
+            }
+            pp.set(i, j, pij);
+        }
+    }
+    return pp;
+}
+
+
+uint64_t PairProb::memBytes() const {
+    return sizeof(PairProb) + (sizeof(double) * lower.size());
+}
+
+// --------------------------------------------
+
+PairProb Model::vProbPairs(VPModel vpm, function<double(unsigned int ak, unsigned int pi, unsigned int pj)> vfn,
+                           unsigned int numAct, unsigned int numOpt) {
+    const double minC = 1E-8; // as in Model::coalitions
+    auto pv = PairProb(numOpt);
+    for (unsigned int i = 0; i < numOpt; i++) {
+        for (unsigned int j = 0; j < i; j++) {
+            double cij = minC;
+            double cji = minC;
+            for (unsigned int k = 0; k < numAct; k++) {
+                double vkij = vfn(k, i, j);
+                if (vkij > 0) {
+                    cij = cij + vkij;
+                }
+                if (vkij < 0) {
+                    cji = cji - vkij;
+                }
+            }
+            auto ppr = vProb(vpm, cij, cji);
+            pv.set(i, j, get<0>(ppr));
+        }
+    }
+    return pv;
+}
+
+
+PairProb Model::vProbPairs(VPModel vpm, const KMatrix & c) {
+    const unsigned int numOpt = c.numR();
+    assert(numOpt == c.numC());
+    auto pv = PairProb(numOpt);
+    for (unsigned int i = 0; i < numOpt; i++) {
+        for (unsigned int j = 0; j < i; j++) {
+            double cij = c(i, j);
+            assert(0 <= cij);
+            double cji = c(j, i);
+            assert(0 <= cji);
+            assert((0 < cij) || (0 < cji));
+            auto ppr = vProb(vpm, cij, cji);
+            pv.set(i, j, get<0>(ppr));
+        }
+    }
+    return pv;
+}
+
+
+PairProb Model::vProbPairs(VotingRule vr, VPModel vpm, const KMatrix & w, const KMatrix & u) {
+    const unsigned int numAct = u.numR();
+    const unsigned int numOpt = u.numC();
+    assert(numAct == w.numC()); // require 1-to-1 matching of actors and strengths
+    assert(1 == w.numR()); // weights must be a row-vector
+
+    auto vfn = [vr, &w, &u](unsigned int k, unsigned int i, unsigned int j) {
+        double vkij = vote(vr, w(0, k), u(k, i), u(k, j));
+        return vkij;
+    };
+    return vProbPairs(vpm, vfn, numAct, numOpt);
+}
+
+
+// No need to check pv(i,j) + pv(j,i) = 1, as PairProb can not violate it.
+KMatrix Model::probCE(PCEModel pcm, const PairProb & pv) {
+    KPROF_SCOPE("Model::probCE");
+    const double pTol = 1E-6;
+    auto p = KMatrix();
+    switch (pcm) {
+    case PCEModel::MarkovPCM:
+        p = markovPCE(pv);
+        break;
+    case PCEModel::ConditionalPCM:
+        p = condPCE(pv);
+        break;
+    default:
+        throw KException("Model::probCE unrecognized PCEModel");
+        break;
+    }
+    assert(fabs(sum(p) - 1.0) < pTol);
+    return p;
+}
+
+
+KMatrix Model::markovPCE(const PairProb & pv) {
+    const double pTol = 1E-6;
+    const unsigned int numOpt = pv.numOpt();
+    auto p = KMatrix(numOpt, 1, 1.0) / numOpt;  // all 1/n
+    auto q = p;
+    unsigned int iMax = 1000;  // 10-30 is typical
+    unsigned int iter = 0;
+    double change = 1.0;
+    while (pTol < change) {
+        change = 0;
+        for (unsigned int i = 0; i < numOpt; i++) {
+            double pi = 0.0;
+            for (unsigned int j = 0; j < numOpt; j++) {
+                pi = pi + pv(i, j)*(p(i, 0) + p(j, 0));
+            }
+            assert(0 <= pi); // double-check
+            q(i, 0) = pi / numOpt;
+            double c = fabs(q(i, 0) - p(i, 0));
+            change = (c > change) ? c : change;
+        }
+        std::swap(p, q); // q is overwritten in the next pass
+        iter++;
+        assert(fabs(sum(p) - 1.0) < pTol); // double-check
+    }
+    assert(iter < iMax); // no way to recover
+    return p;
+}
+
+
+KMatrix Model::condPCE(const PairProb & pv) {
+    const unsigned int numOpt = pv.numOpt();
+    auto p = KMatrix(numOpt, 1);
+    for (unsigned int i = 0; i < numOpt; i++) {
+        double pi = 1.0;
+        for (unsigned int j = 0; j < numOpt; j++) {
+            pi = pi * pv(i, j);
+        }
+        assert(0 <= pi);
+        assert(pi <= 1);
+        p(i, 0) = pi; // probability that i beats all alternatives
+    }
+    double probOne = sum(p); // probability that one option, any option, beats all alternatives
+    p = (p / probOne); // conditional probability that i is that one.
+    return p;
+}
+
+} // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -22,7 +22,9 @@
 // --------------------------------------------
 
 #include <iostream>
+#include <memory>
 
+#include "evalcache.h"
 #include "gaopt.h"
 #include "kmodel.h"
 
@@ -50,6 +52,7 @@ Position::~Position() {}
 VctrPstn::VctrPstn() : Position(), KMatrix() {}
 VctrPstn::VctrPstn(unsigned int nr, unsigned int nc) : Position(), KMatrix(nr, nc) {}
 VctrPstn::VctrPstn(const KMatrix & m) : KMatrix(m) {} // copy constructor
+VctrPstn::VctrPstn(KMatrix && m) : KMatrix(std::move(m)) {}
 VctrPstn::~VctrPstn() {}
 
 void VctrPstn::print(ostream& os) const {  
@@ -145,21 +148,35 @@ vector< MtchPstn > MtchPstn::neighbors(unsigned int nVar) const {
     return nghbrs;
 }
 
+uint64_t MtchPstn::hash() const {
+    assert(numItm == match.size());
+    return hashMix(hashMix(numCat, numItm), hashVUI(match));
+}
+
+// --------------------------------------------
+MtchGeneCtx::MtchGeneCtx(const vector<Actor*> & as, const vector<MtchPstn*> & ps) :
+    actrs(as), pstns(ps) {
+    assert(as.size() == ps.size());
+}
+
 // --------------------------------------------
 // MtchGene inherits these data members:
-// actrs: vector of the Actor* in this state (really TActor3*)
-// pstns: vector of the MtchPstn of those actors.
-// numA: the number of actors ( == actrs.size())
-// numI: the number of items (sweets)
+// numCat: the number of categories (for sweets, the number of actors)
+// numItm: the number of items (sweets)
 // match: this particular gene, from {0 ... numCat-1}^numItm
+// It shares with its parents and children the context,
+// ctx: the Actor* in this state (really TActor3*), and the MtchPstn of those actors.
 MtchGene::MtchGene() : MtchPstn() {
     assert(0 == numCat);
     assert(0 == numItm);
-    actrs = vector<Actor*>();
-    pstns = vector<MtchPstn*>();
+    ctx = nullptr;
     match = VUI();
 }
 
+MtchGene::MtchGene(shared_ptr<const MtchGeneCtx> c) : MtchGene() {
+    ctx = c;
+}
+
 MtchGene::~MtchGene() {};
 
 
@@ -191,16 +208,21 @@ void  MtchGene::copySelf(MtchGene* mg2) const {
 
     mg2->numCat = numCat;
     mg2->numItm = numItm;
-    mg2->actrs = actrs;
-    mg2->pstns = pstns;
-    mg2->match = match;
+    mg2->ctx = ctx;
+    mg2->match = match; // reuses mg2's storage, if it is long enough
 
     return;
 }
 
 MtchGene * MtchGene::mutate(PRNG * rng) const {
-    // because quid-pro-quo can be expected, we mutate two chromosomes
     auto mg2 = new MtchGene();
+    mutateInto(rng, mg2);
+    return mg2;
+}
+
+void MtchGene::mutateInto(PRNG * rng, MtchGene * mg2) const {
+    // because quid-pro-quo can be expected, we mutate two chromosomes
+    assert(this != mg2);
     copySelf(mg2);
 
     unsigned int n1 = ((unsigned int)(rng->uniform() % numItm));
@@ -211,12 +233,18 @@ MtchGene * MtchGene::mutate(PRNG * rng) const {
     unsigned int a2 = ((unsigned int)(rng->uniform() % numCat));
     mg2->match[n2] = a2;
 
-    return mg2;
+    return;
 }
 
 tuple<MtchGene*, MtchGene*>  MtchGene::cross(const MtchGene * mg2, PRNG * rng) const {
     auto gA = new MtchGene();
     auto gB = new MtchGene();
+    crossInto(mg2, rng, gA, gB);
+    return  tuple<MtchGene*, MtchGene*>(gA, gB);
+}
+
+void MtchGene::crossInto(const MtchGene * mg2, PRNG * rng, MtchGene * gA, MtchGene * gB) const {
+    assert((this != gA) && (this != gB) && (mg2 != gA) && (mg2 != gB) && (gA != gB));
     copySelf(gA);
     mg2->copySelf(gB);
     unsigned int nc = crossSite(rng, numItm);
@@ -232,7 +260,7 @@ tuple<MtchGene*, MtchGene*>  MtchGene::cross(const MtchGene * mg2, PRNG * rng) c
             gB->match[i] = c1i;
         }
     }
-    return  tuple<MtchGene*, MtchGene*>(gA, gB);
+    return;
 }
 
 /*
@@ -254,8 +282,12 @@ bool MtchGene::equiv(const MtchGene * mg2) const {
 
 
 void MtchGene::setState(vector<Actor*> as, vector<MtchPstn*> ps)  {
-    actrs = as;
-    pstns = ps;
+    ctx = std::make_shared<const MtchGeneCtx>(as, ps);
+}
+
+
+void MtchGene::setContext(shared_ptr<const MtchGeneCtx> c) {
+    ctx = c;
 }
 
 
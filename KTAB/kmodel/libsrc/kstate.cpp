@@ -88,11 +88,11 @@ void State::setUENdx()  {
     auto ns = KBase::uiSeq(0, na - 1);
     auto uePair = KBase::ueIndices<unsigned int>(ns, efn);
 
-    uIndices = get<0>(uePair);
+    uIndices = std::move(get<0>(uePair));
     assert (0 < uIndices.size());
     assert (uIndices.size() <= na);
 
-    eIndices = get<1>(uePair);
+    eIndices = std::move(get<1>(uePair));
     assert (na == eIndices.size());
 
     return;
@@ -100,6 +100,7 @@ void State::setUENdx()  {
 
 
 void State::setAUtil(int perspH, ReportingLevel rl) {
+  KPROF_SCOPE("State::setAUtil");
   // we want to make sure that data is calculated at most once.
   // This is necessary because some utilities are very expensive to calculate,
   // it is easiest to be precise all the time.
@@ -126,6 +127,17 @@ void State::setAUtil(int perspH, ReportingLevel rl) {
   return;
 }
 
+uint64_t State::memBytes() const {
+    uint64_t nb = sizeof(*this);
+    nb = nb + (pstns.size() * sizeof(Position*));
+    for (auto& u : aUtil) {
+        nb = nb + KBase::memBytes(u);
+    }
+    nb = nb + ((uIndices.size() + eIndices.size()) * sizeof(unsigned int));
+    nb = nb + KBase::memBytes(uProb) - sizeof(KMatrix); // the object itself is in sizeof(*this)
+    return nb;
+}
+
 void State::setOneAUtil(unsigned int perspH, ReportingLevel rl) {
     // TODO: make this non-dummy
     assert (false);
@@ -240,7 +240,7 @@ namespace DemoLeon {
     };
 
 
-    const KMatrix u = aUtil[0]; // all have same beliefs in this demo
+    const KMatrix & u = aUtil[0]; // all have same beliefs in this demo
 
 
     const unsigned int numA = model->numAct;
@@ -251,7 +251,7 @@ namespace DemoLeon {
 
       // again, I could do a complex vote, but I'll do the easy one.
       // BTW, be sure to lambda-bind uh *after* it is modified.
-      auto vkij = [this, uMat](unsigned int k, unsigned int i, unsigned int j) {  // vote_k ( i : j )
+      auto vkij = [this, &uMat](unsigned int k, unsigned int i, unsigned int j) {  // vote_k ( i : j )
         auto ak = (LeonActor*)(eMod->actrs[k]);
         auto ck = KBase::sum(ak->vCap);
         auto v_kij = Model::vote(ak->vr, ck, uMat(k, i), uMat(k, j));
@@ -264,49 +264,49 @@ namespace DemoLeon {
       const KMatrix eu = uMat*p;
 
 
-      if (ReportingLevel::Low < rl) {
-        cout << "Assessing EU from util matrix: " << endl;
+      if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        KBase::klogf("Assessing EU from util matrix: \n");
         uMat.mPrintf(" %.6f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
 
-        cout << "Coalition strength matrix" << endl;
+        KBase::klogf("Coalition strength matrix\n");
         c.mPrintf(" %12.6f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
 
-        cout << "Probability Opt_i > Opt_j" << endl;
+        KBase::klogf("Probability Opt_i > Opt_j\n");
         pv.mPrintf(" %.6f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
 
-        cout << "Probability Opt_i" << endl;
+        KBase::klogf("Probability Opt_i\n");
         p.mPrintf(" %.6f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
 
-        cout << "Expected utility to actors: " << endl;
+        KBase::klogf("Expected utility to actors: \n");
         eu.mPrintf(" %.6f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
       }
 
       return eu;
     }; // end of euMat
 
-    if (ReportingLevel::Low < rl) {
-      printf("--------------------------------------- \n");
-      printf("Assessing utility of actual state to all actors \n");
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
+      KBase::klogf("--------------------------------------- \n");
+      KBase::klogf("Assessing utility of actual state to all actors \n");
       for (unsigned int h = 0; h < numA; h++) {
         auto aPos = ((VctrPstn*)(pstns[h]));
-        printf("Actual vector-position (possibly non-neutral) of actor %2u: ", h);
-        trans(*aPos).mPrintf(" %+.6f ");
+        KBase::klogf("Actual vector-position (possibly non-neutral) of actor %2u: ", h);
+        aPos->tView().mPrintf(" %+.6f ");
       }
-      cout << endl << flush;
+      KBase::klogf("\n");
     }
     const KMatrix eu0 = euMat(u);
 
     // end of setup?
 
-    auto assessEU = [rl, this, u, assertSimilar, euMat](unsigned int h, const KMatrix & hPos) {
+    auto assessEU = [rl, this, &u, &assertSimilar, &euMat](unsigned int h, const KMatrix & hPos) {
       // build the hypothetical utility matrix by modifying the h-column
       // of h's matrix (his expectation of the util to everyone else of changing his own position).
-      const KMatrix uh0 = aUtil[h];
+      const KMatrix & uh0 = aUtil[h];
       assertSimilar(u, uh0);  // all have same beliefs in this demo
       auto uh = uh0;
       bool normP = false;
@@ -321,15 +321,15 @@ namespace DemoLeon {
       }
 
 
-      if (ReportingLevel::Low < rl) {
-        printf("--------------------------------------- \n");
-        printf("Assessing utility to %2i of hypo-pos: ", h);
-        trans(hPos).mPrintf(" %+.6f ");
-        cout << endl << flush;
+      if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        KBase::klogf("--------------------------------------- \n");
+        KBase::klogf("Assessing utility to %2i of hypo-pos: ", h);
+        hPos.tView().mPrintf(" %+.6f ");
+        KBase::klogf("\n");
 
-        printf("Hypo-util minus base util: \n");
+        KBase::klogf("Hypo-util minus base util: \n");
         (uh - uh0).mPrintf(" %+.4E ");
-        cout << endl << flush;
+        KBase::klogf("\n");
       }
 
       const KMatrix eu = euMat(uh);
@@ -341,7 +341,7 @@ namespace DemoLeon {
 
     for (unsigned int h = 0; h < numA; h++) {
       auto vhc = new KBase::VHCSearch();
-      vhc->eval = [this, h, assessEU](const KMatrix & m1) {
+      vhc->eval = [this, h, &assessEU](const KMatrix & m1) {
         auto m2 = eMod->makeFTax(m1); // make it feasible
         return assessEU(h, m2);
       };
@@ -374,10 +374,10 @@ namespace DemoLeon {
       printf("Iter: %u  Stable: %u \n", in, sn);
       printf("Best value for %2u: %+.6f \n", h, vBest);
       cout << "Best point:    ";
-      trans(pBest).mPrintf(" %+.6f ");
+      pBest.tView().mPrintf(" %+.6f ");
       KMatrix rBest = eMod->makeFTax(pBest);
       printf("Best rates for %2u: ", h);
-      trans(rBest).mPrintf(" %+.6f ");
+      rBest.tView().mPrintf(" %+.6f ");
 
       VctrPstn * posBest = new VctrPstn(rBest);
       s2->pstns.push_back(posBest);
@@ -430,7 +430,7 @@ namespace DemoLeon {
     acMat.mPrintf(" %+0.4f ");
 
     cout << "Mean policy" << endl;
-    trans(meanP).mPrintf(" %+0.4f ");
+    meanP.tView().mPrintf(" %+0.4f ");
 
     cout << "Euclidean distance to mean policy: " << endl;
     for (unsigned int i = 0; i < numA; i++) {
@@ -464,11 +464,10 @@ namespace DemoLeon {
       return uij;
     };
     auto u = KMatrix::map(uFn1, numA, numA);
-    if (KBase::ReportingLevel::Low < rl) {
-      cout << "Raw actor-pos util matrix" << endl;
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
+      KBase::klogf("Raw actor-pos util matrix\n");
       u.mPrintf(" %.4f ");
-      cout << endl << flush;
-      cout << flush;
+      KBase::klogf("\n");
     }
 
     // for the purposes of this demo, I consider each actor to know exactly what the others value.
@@ -1123,11 +1122,10 @@ namespace DemoLeon {
     using KBase::makePerp;
     auto srl = ReportingLevel::Silent;
 
-    if (ReportingLevel::Silent < srl) {
-      cout << "Raw Tax: ";
-      trans(tax).mPrintf(" %+0.6f ");
-      cout << endl;
-      cout << flush;
+    if (KLOG_ON(ReportingLevel::Low, srl)) {
+      KBase::klogf("Raw Tax: ");
+      tax.tView().mPrintf(" %+0.6f ");
+      KBase::klogf("\n");
     }
 
 
@@ -1139,8 +1137,8 @@ namespace DemoLeon {
     for (unsigned int i = 0; i < N; i++) {
       double pi = 1.0 + tax(i, 0);
       if (pi <= 0) {
-        if (ReportingLevel::Silent < srl) {
-          printf("%s\n", keNeg.c_str());
+        if (KLOG_ON(ReportingLevel::Low, srl)) {
+          KBase::klogf("%s\n", keNeg.c_str());
         }
         throw KBase::KException(keNeg);
       }
@@ -1169,12 +1167,12 @@ namespace DemoLeon {
       }
       d = infsDegree(tau);
       iter = iter + 1;
-      if (ReportingLevel::Low < srl) {
-        printf("%3u/%3u: %.3E \n", iter, iterMax, d);
+      if (KLOG_ON(ReportingLevel::Medium, srl)) {
+        KBase::klogf("%3u/%3u: %.3E \n", iter, iterMax, d);
       }
       if (iter > iterMax) {
-        if (ReportingLevel::Silent < srl) {
-          printf("%s\n", keItr.c_str());
+        if (KLOG_ON(ReportingLevel::Low, srl)) {
+          KBase::klogf("%s\n", keItr.c_str());
         }
         throw KBase::KException(keItr);
       }
@@ -1288,7 +1286,7 @@ namespace DemoLeon {
         runs(i, j) = shr(0, j);
       }
 
-      if (KBase::ReportingLevel::Medium <= rl) {
+      if (KLOG_ON(ReportingLevel::Medium, rl)) {
         printf("MC tax policy %4u \n", i);
         tau.mPrintf(" %+.4f ");
         cout << endl << flush;
@@ -1468,9 +1466,9 @@ namespace DemoLeon {
       printf("%2u: %s , %s \n", i, ai->name.c_str(), ai->desc.c_str());
       cout << "voting rule: " << ai->vr << endl;
       cout << "Pos vector: ";
-      trans(*pi).mPrintf(" %+7.3f ");
+      pi->tView().mPrintf(" %+7.3f ");
       cout << "Cap vector: ";
-      trans(ai->vCap).mPrintf(" %7.2f ");
+      ai->vCap.tView().mPrintf(" %7.2f ");
       printf("minS: %.3f \n", ai->minS);
       printf("refS: %.3f \n", ai->refS);
       printf("maxS: %.3f \n", ai->maxS);
@@ -1568,7 +1566,7 @@ namespace DemoLeon {
       KMatrix r = eMod0->makeFTax(m);
       assert(eMod0->infsDegree(r) < TolIFD); // make sure it is a feasible tax
       printf("Rates: ");
-      trans(r).mPrintf(" %+.6f ");
+      r.tView().mPrintf(" %+.6f ");
       return;
     };
 
@@ -1599,10 +1597,10 @@ namespace DemoLeon {
     printf("Iter: %u  Stable: %u \n", in, sn);
     printf("Best value : %+.6f \n", vBest);
     cout << "Best point:    ";
-    trans(pBest).mPrintf(" %+.6f ");
+    pBest.tView().mPrintf(" %+.6f ");
     KMatrix rBest = eMod0->makeFTax(pBest);
     printf("Best rates: ");
-    trans(rBest).mPrintf(" %+.6f ");
+    rBest.tView().mPrintf(" %+.6f ");
 
     delete vhc;
     vhc = nullptr;
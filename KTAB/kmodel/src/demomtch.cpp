@@ -61,11 +61,11 @@ namespace DemoMtch {
   }
 
   void showMtchPstn(const MtchPstn & mp) { 
-    cout << "[MtchPstn ";
+    KBase::klogf("[MtchPstn ");
     for (auto m : mp.match) {
-      cout << m << " ";
+      KBase::klogf("%u ", m);
     }
-    cout << "]";
+    KBase::klogf("]");
     return;
   }
 
@@ -502,42 +502,74 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
     }
 
     // Now we setup a GAOpt to look for the position which maximizes zeta.
-    unsigned int gps = 20;
-    printf("gpool: %u   \n", gps);
-    auto gOpt = new KBase::GAOpt<MtchGene>(gps);
-
-    gOpt->cross = [](const MtchGene* g1, const MtchGene* g2, PRNG* rng) {
-      return g1->cross(g2, rng);
-    };
-
-    gOpt->mutate = [](const MtchGene* g1, PRNG* rng) {
-      return g1->mutate(rng);
-    };
-
-    gOpt->eval = [numC, numI, as, zeta](const MtchGene* mg) {
-      assert(numC == mg->numCat);
-      assert(numI == mg->numItm);
-      double z = zeta(as, mg);
-      return z;
-    };
-
-    gOpt->showGene = [](const MtchGene* mg){ 
-      cout << (*mg);
-      return;
+    // Every gene shares one copy of the actors and positions, and
+    // offspring are written into recycled genes, so that the turnover of
+    // the population does no heap allocation once the pool has filled.
+    auto ctx = std::make_shared<const KBase::MtchGeneCtx>(as, ps);
+
+    // Many offspring duplicate genes already scored, so remember zeta by hash.
+    // All the GAs below evaluate the same zeta, so they can share one cache.
+    auto gaCache = new KBase::EvalCache(1 << 14);
+
+    auto makeGA = [numC, numI, as, zeta, ctx, gaCache](unsigned int gps) {
+      auto gOpt = new KBase::GAOpt<MtchGene>(gps);
+
+      gOpt->cache = gaCache;
+      gOpt->hashGene = [](const MtchGene* mg) {
+        return mg->hash();
+      };
+
+      gOpt->cross = [](const MtchGene* g1, const MtchGene* g2, PRNG* rng) {
+        return g1->cross(g2, rng);
+      };
+
+      gOpt->mutate = [](const MtchGene* g1, PRNG* rng) {
+        return g1->mutate(rng);
+      };
+
+      gOpt->mutateInto = [](const MtchGene* g1, PRNG* rng, MtchGene* out) {
+        g1->mutateInto(rng, out);
+        return;
+      };
+
+      gOpt->crossInto = [](const MtchGene* g1, const MtchGene* g2, PRNG* rng, MtchGene* gA, MtchGene* gB) {
+        g1->crossInto(g2, rng, gA, gB);
+        return;
+      };
+
+      gOpt->pool.makeBlank = [ctx]() {
+        return new MtchGene(ctx);
+      };
+
+      gOpt->eval = [numC, numI, as, zeta](const MtchGene* mg) {
+        assert(numC == mg->numCat);
+        assert(numI == mg->numItm);
+        double z = zeta(as, mg);
+        return z;
+      };
+
+      gOpt->showGene = [](const MtchGene* mg){ 
+        cout << (*mg);
+        return;
+      };
+
+      gOpt->equiv = [](const MtchGene* mg1, const MtchGene* mg2) {
+        return mg1->equiv(mg2);
+      };
+
+      gOpt->makeGene = [numC, numI, ctx](PRNG * rng) {
+        MtchGene* m = new MtchGene(ctx);
+        m->numCat = numC;
+        m->numItm = numI;
+        m->randomize(rng);
+        return m;
+      };
+      return gOpt;
     };
 
-    gOpt->equiv = [](const MtchGene* mg1, const MtchGene* mg2) {
-      return mg1->equiv(mg2);
-    };
-
-    gOpt->makeGene = [numC, numI, as, ps](PRNG * rng) {
-      MtchGene* m = new MtchGene();
-      m->setState(as, ps);
-      m->numCat = numC;
-      m->numItm = numI;
-      m->randomize(rng);
-      return m;
-    };
+    unsigned int gps = 20;
+    printf("gpool: %u   \n", gps);
+    auto gOpt = makeGA(gps);
 
     cout << "Filling gpool ..." << endl;
     gOpt->fill(rng);
@@ -559,6 +591,10 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
     printf("crossFrac: %.2f  mutFrac: %.2f \n", cf, mf);
     auto srl = KBase::ReportingLevel::Low;
     gOpt->run(rng, cf, mf, 1000, 0.2, 50, srl, iter, sIter);
+    printf("Gene pool: %llu genes made, %llu reused, %u free at the end \n",
+           (long long unsigned int) gOpt->pool.numMade,
+           (long long unsigned int) gOpt->pool.numReused, gOpt->pool.numFree());
+    gaCache->stats().show("GA fitness cache");
 
     cout << endl << endl << "Final gpool: " << endl;
     gOpt->show();
@@ -568,23 +604,52 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
     // try the same thing via GHC over MtchPstn
     auto ghc = new KBase::GHCSearch<MtchPstn>();
 
-    auto eFn = [as, zeta](const MtchPstn mp) {
+    auto eFn = [as, zeta](const MtchPstn & mp) {
       double z = zeta(as, &mp);
       return z; };
     ghc->eval = eFn;
 
     unsigned int numVar = 2;
-    function <vector<MtchPstn>(const MtchPstn)> nFn = [numVar](const MtchPstn mg) { return mg.neighbors(numVar); };
+    function <vector<MtchPstn>(const MtchPstn &)> nFn = [numVar](const MtchPstn & mg) { return mg.neighbors(numVar); };
     ghc->nghbrs = nFn;
 
     ghc->show = showMtchPstn;
 
+    // hill-climbers revisit the neighbors of their last few points
+    auto ghcCache = new KBase::EvalCache(1 << 14);
+    ghc->cache = ghcCache;
+    ghc->hashPt = [](const MtchPstn & mp) {
+      return mp.hash();
+    };
+
     // make a random starting point
     auto mgPtr = MtchActor::rPos(numI, numA, rng);
     ghc->run(*mgPtr, KBase::ReportingLevel::Medium, 100, 3, 0.001);
     delete mgPtr;
+    ghcCache->stats().show("GHC fitness cache");
 
     delete ghc;
+    delete ghcCache;
+
+    // try the same thing with several populations, evolving on separate threads
+    const unsigned int numIsl = 4;
+    auto isl = new KBase::GAIslands<MtchGene>(numIsl, rng->uniform());
+    isl->makeIsland = [makeGA, gps](unsigned int k) {
+      return makeGA(gps);
+    };
+    isl->copyGene = [](const MtchGene* g) {
+      return new MtchGene(*g);
+    };
+    isl->topology = KBase::MigrationTopology::Ring;
+    isl->numMigrants = 2;
+    isl->migrationGap = 10;
+    printf("Island model: %u islands of %u genes, top %u migrate around a ring every %u generations \n",
+           numIsl, gps, isl->numMigrants, isl->migrationGap);
+    isl->run(cf, mf, 1000, 0.2, 50, srl, iter, sIter);
+    printf("%llu migrants were accepted \n", (long long unsigned int) isl->numMigrated);
+    gaCache->stats().show("GA fitness cache, after the islands too");
+    delete isl;
+    delete gaCache;
     for (auto a : as) { delete a; }
     for (auto p : ps) { delete p; }
     return;
@@ -830,7 +895,7 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
 
     const unsigned int numA = mst->model->numAct;
     unsigned int ih = mst->model->actrNdx(this);
-    const KMatrix uh = mst->aUtil[ih];
+    const KMatrix & uh = mst->aUtil[ih];
     const KMatrix w = mst->actrCaps();
 
     //auto wFn = [st](unsigned int i, unsigned int j) {
@@ -839,7 +904,7 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
     //};
     //const KMatrix w = KMatrix::map(wFn, 1, numA);
 
-    auto utilH = [mst, uh, ih, numA](const MtchPstn* ph) {
+    auto utilH = [mst, &uh, ih, numA](const MtchPstn* ph) {
       auto u = uh; // copy
       for (unsigned int i = 0; i < numA; i++) {
         auto ai = ((MtchActor*)(mst->model->actrs[i]));
@@ -855,7 +920,7 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
     // Note that, for demo purposes, each actor assess the expected utility or the
     // probability-of-adoptions of their proposal under the assumption that everyone
     // uses the same voting rule as do they.
-    auto assessProbEU = [numA, utilH, w, ih, pm, vpm, this](const MtchPstn  ph) {
+    auto assessProbEU = [numA, &utilH, &w, ih, pm, vpm, this](const MtchPstn & ph) {
       auto u = utilH(&ph);
       auto p = Model::scalarPCE(numA, numA, w, u, vr, vpm, ReportingLevel::Silent);
       auto eu = u*p;
@@ -878,7 +943,7 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
 
     auto ghc = KBase::GHCSearch<MtchPstn>();
     ghc.eval = assessProbEU;
-    ghc.nghbrs = [](MtchPstn mp) { return mp.neighbors(2); };
+    ghc.nghbrs = [](const MtchPstn & mp) { return mp.neighbors(2); };
     ghc.show = showMtchPstn;
 
     auto r0 = ghc.run(*((MtchPstn*)(mst->pstns[ih])), KBase::ReportingLevel::Silent, 100, 1, 0.001);
@@ -932,25 +997,25 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
     const unsigned int numA = model->numAct;
     for (unsigned int ih = 0; ih < numA; ih++) {
       MtchActor* ah = (MtchActor*)(model->actrs[ih]);
-      if (ReportingLevel::Low < rl) {
+      if (KLOG_ON(ReportingLevel::Medium, rl)) {
         switch (ah->pMod) {
         case MtchActor::PropModel::ExpUtil:
-          printf("maxEU search for actor %u ... \n", ih);
+          KBase::klogf("maxEU search for actor %u ... \n", ih);
           break;
         case MtchActor::PropModel::Probability:
-          printf("maxProb search for actor %u ... \n", ih);
+          KBase::klogf("maxProb search for actor %u ... \n", ih);
           break;
         case MtchActor::PropModel::AgreeUtil:
-          printf("maxAgU search for actor %u ... \n", ih);
+          KBase::klogf("maxAgU search for actor %u ... \n", ih);
           break;
         }
       }
       auto evmp = ah->maxProbEUPstn(ah->pMod, this); // all the real action is in this function
 
-      if (ReportingLevel::Low < rl) {
-        printf("Found %.4f at this matching: \n", get<0>(evmp));
+      if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        KBase::klogf("Found %.4f at this matching: \n", get<0>(evmp));
         showMtchPstn(get<1>(evmp));
-        cout << endl;
+        KBase::klogf("\n");
       }
 
       // Expected improvements do not always occur, because other actors also change their positions.
@@ -967,29 +1032,29 @@ bool MtchState::equivNdx(unsigned int i, unsigned int j) const {
       MtchPstn* newPi = new MtchPstn(get<1>(evmp));
       s2->addPstn(newPi);
 
-      if (ReportingLevel::Low < rl) {
-        printf("Old position %2u: ", ih); showMtchPstn(*oldPi); cout << endl;
-        printf("New position %2u: ", ih); showMtchPstn(*newPi); cout << endl;
+      if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        KBase::klogf("Old position %2u: ", ih); showMtchPstn(*oldPi); KBase::klogf("\n");
+        KBase::klogf("New position %2u: ", ih); showMtchPstn(*newPi); KBase::klogf("\n");
       }
     } // end of loop over ih, actors
 
 
-    if (ReportingLevel::Low < rl) {
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
       s2->setAUtil(-1, ReportingLevel::Silent);
       auto u2 = s2->aUtil[0]; // they all have the same aUtil matrix, in this demo.
 
       auto pn2 = pDist(-1); // objective perspective
       auto p2 = std::get<0>(pn2);
-      cout << "Util matrix for U(actor_r, pstn_c) in new state: " << endl;
+      KBase::klogf("Util matrix for U(actor_r, pstn_c) in new state: \n");
       u2.mPrintf(" %.4f ");
 
-      cout << "Probability of outcomes in new state: " << endl;
+      KBase::klogf("Probability of outcomes in new state: \n");
       p2.mPrintf(" %.4f ");
-      cout << endl << flush;
+      KBase::klogf("\n");
 
-      cout << "Expected utility to actors in new state: " << endl;
+      KBase::klogf("Expected utility to actors in new state: \n");
       (u2*p2).mPrintf(" %.4f "); // TODO: may need to modify this to use only unique positions
-      cout << endl << flush;
+      KBase::klogf("\n");
     }
 
     return s2;
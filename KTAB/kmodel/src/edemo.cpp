@@ -26,6 +26,7 @@
 // --------------------------------------------
 
 #include "edemo.h" 
+#include "zactor.h"
 #include "emodel.cpp" 
 
 
@@ -205,6 +206,57 @@ namespace MDemo { // a namespace of which M, A, P, S know nothing
   }
 
 
+  // make the bit vector for option i on demand, rather than all 2^n of them at once
+  function <BVec(uint64_t)> nthBV(unsigned int n) {
+    auto rfn = [n](uint64_t i) {
+      auto bv = BVec(n, false);
+      for (unsigned int j = 0; j < n; j++) {
+        bv[j] = (1 == ((i >> j) & 1));
+      }
+      return bv;
+    };
+    return rfn;
+  }
+
+
+  BVState::BVState(EModel<BVec>* m, const KMatrix & wghts) : EState<BVec>(m) {
+    assert(m->numAct == wghts.numR());
+    optionVFn = [wghts](uint64_t j, const BVec & bv, KBase::KView vs) {
+      assert(bv.size() == wghts.numC());
+      for (unsigned int i = 0; i < wghts.numR(); i++) {
+        double vi = 0.0;
+        for (unsigned int b = 0; b < bv.size(); b++) {
+          vi = vi + (bv[b] ? wghts(i, b) : 0.0);
+        }
+        vs(0, i) = vi;
+      }
+      return;
+    };
+  }
+
+
+  BVState::~BVState() {}
+
+
+  void BVState::takeBest(ReportingLevel rl) {
+    for (unsigned int i = 0; i < model->numAct; i++) {
+      addPstn(new KBase::EPosition<BVec>((EModel<BVec>*) model, bestOption(i)));
+    }
+    setAllAUtil(rl);
+    return;
+  }
+
+
+  tuple<KMatrix, KBase::VUI> BVState::pDist(int persp) const {
+    throw KBase::KException("BVState::pDist: not needed for this demo");
+  }
+
+
+  bool BVState::equivNdx(unsigned int i, unsigned int j) const {
+    return (i == j);
+  }
+
+
   // --------------------------------------------
 
   void demoEMod(uint64_t s, PRNG* rng) {
@@ -230,9 +282,63 @@ namespace MDemo { // a namespace of which M, A, P, S know nothing
     emBV->setOptions();
     cout << "Now have " << emBV->numOptions() << endl;
 
+    // Far too many options to enumerate one by one (2^nb), so make them on demand,
+    // a chunk at a time. Each actor's best option is simply the bits it values positively.
+    const unsigned int nb = 16;
+    string nSV = "EModel-BVec-Streamed";
+    EModel<BVec>* emSV = new EModel<BVec>(rng, nSV);
+    cout << "Populating " << nSV << endl;
+    emSV->optionCount = ((uint64_t)1) << nb;
+    emSV->makeOption = nthBV(nb);
+    emSV->numThreads = 0; // BVState's values are safe to compute concurrently
+    emSV->setOptions();
+    cout << "Now have " << emSV->numOptions() << endl;
+    const unsigned int nsa = 5;
+    for (unsigned int i = 0; i < nsa; i++) {
+      emSV->addActor(new ZActor("Z" + std::to_string(i), "bit-vector actor"));
+    }
+    auto wghts = KMatrix::uniform(rng, nsa, nb, -1.0, 1.0);
+    auto bvs = new BVState(emSV, wghts);
+    bvs->setValues(); // on all cores, keeping the values
+    for (unsigned int i = 0; i < nsa; i++) {
+      uint64_t ideal = 0;
+      for (unsigned int b = 0; b < nb; b++) {
+        ideal = ideal | ((0.0 < wghts(i, b)) ? (((uint64_t)1) << b) : 0);
+      }
+      printf("Actor %u best option is %5llu with value %.4f \n", i,
+             (unsigned long long) bvs->bestOption(i), bvs->bestValue(i));
+      assert(ideal == bvs->bestOption(i));
+    }
+
+    // the same on one thread, as if there were too many values to keep
+    emSV->numThreads = 1;
+    emSV->maxStoredValues = 0;
+    auto bvs1 = new BVState(emSV, wghts);
+    bvs1->setValues();
+    assert(!bvs1->valuesKept());
+    for (unsigned int i = 0; i < nsa; i++) {
+      assert(bvs1->bestOption(i) == bvs->bestOption(i));
+      assert(bvs1->bestValue(i) == bvs->bestValue(i));
+    }
+    delete bvs1;
+
+    // everyone advocates their own best option: how likely is each to win?
+    bvs->takeBest(ReportingLevel::Medium);
+    auto caps = KMatrix::uniform(rng, 1, nsa, 10.0, 100.0);
+    auto opts = KBase::VUI();
+    for (unsigned int i = 0; i < nsa; i++) {
+      opts.push_back(bvs->bestOption(i));
+    }
+    auto p = bvs->optionProbs(opts, caps, VotingRule::Proportional, KBase::VPModel::Linear);
+    cout << "Probability of each actor's best option:" << endl;
+    p.mPrintf(" %.4f ");
+    cout << endl;
+
     printf("Deleting EModel objects ... \n");
+    delete bvs;
     delete em2D;
     delete emBV;
+    delete emSV;
     return;
   }
 
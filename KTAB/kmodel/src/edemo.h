@@ -64,6 +64,20 @@ namespace MDemo {
     unsigned int y = 0;
   };
 
+  // Just enough of a state to evaluate bit-vector options: actor i values
+  // each bit b by wghts(i,b), which may be negative.
+  class BVState : public KBase::EState<BVec> {
+  public:
+    BVState(EModel<BVec>* m, const KMatrix & wghts);
+    virtual ~BVState();
+
+    virtual std::tuple<KMatrix, KBase::VUI> pDist(int persp) const;
+    virtual bool equivNdx(unsigned int i, unsigned int j) const;
+
+    // each actor takes the position of its best option
+    void takeBest(KBase::ReportingLevel rl);
+  };
+
 };
 // -------------------------------------------------
 #endif
@@ -0,0 +1,170 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// Sharded LRU memo of fitness values
+// -------------------------------------------------
+
+#include <math.h>
+
+#include "evalcache.h"
+
+namespace KBase {
+  using std::get;
+
+  uint64_t hashMix(uint64_t h, uint64_t x) {
+    // combine as in boost::hash_combine, then scramble with the splitmix64
+    // finalizer, so that points which differ in one element land in different shards.
+    uint64_t z = h ^ (x + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2));
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+
+  uint64_t hashVUI(const VUI & v) {
+    uint64_t h = v.size();
+    for (auto x : v) {
+      h = hashMix(h, x);
+    }
+    return h;
+  }
+
+
+  uint64_t hashKMatrix(const KMatrix & m, double tol) {
+    assert(0 < tol);
+    const unsigned int n = m.numR() * m.numC();
+    uint64_t h = hashMix(m.numR(), m.numC());
+    const double* x = m.data();
+    for (unsigned int i = 0; i < n; i++) {
+      const int64_t q = llround(x[i] / tol);
+      h = hashMix(h, (uint64_t)q);
+    }
+    return h;
+  }
+
+
+  double EvalCacheStats::hitRate() const {
+    return (0 == lookups) ? 0.0 : ((double)hits) / ((double)lookups);
+  }
+
+
+  void EvalCacheStats::show(const string & name) const {
+    printf("%s: %llu lookups, %llu hits (%.1f%%), %llu inserts, %llu evictions, %u held \n",
+           name.c_str(), (long long unsigned int) lookups, (long long unsigned int) hits,
+           100.0 * hitRate(), (long long unsigned int) inserts,
+           (long long unsigned int) evictions, size);
+    return;
+  }
+
+
+  EvalCache::EvalCache(unsigned int cap, unsigned int ns) :
+    numShards(ns), shardCap(0), shards(ns), numLookups(0), numHits(0), numInserts(0) {
+    assert(0 < ns);
+    assert(ns <= cap);
+    shardCap = (cap + ns - 1) / ns;
+  }
+
+
+  EvalCache::~EvalCache() {}
+
+
+  bool EvalCache::lookup(uint64_t h, double & v) {
+    numLookups++;
+    Shard& s = shardOf(h);
+    std::lock_guard<std::mutex> lk(s.mtx);
+    auto it = s.where.find(h);
+    if (s.where.end() == it) {
+      return false;
+    }
+    // move it to the front, as most recently used
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    v = get<1>(*(it->second));
+    numHits++;
+    return true;
+  }
+
+
+  void EvalCache::insert(uint64_t h, double v) {
+    Shard& s = shardOf(h);
+    std::lock_guard<std::mutex> lk(s.mtx);
+    auto it = s.where.find(h);
+    if (s.where.end() != it) { // someone else got there first
+      get<1>(*(it->second)) = v;
+      s.lru.splice(s.lru.begin(), s.lru, it->second);
+      return;
+    }
+    if (shardCap <= s.where.size()) {
+      // reuse the least recently used node, rather than free one and allocate another
+      auto last = std::prev(s.lru.end());
+      s.where.erase(get<0>(*last));
+      *last = tuple<uint64_t, double>(h, v);
+      s.lru.splice(s.lru.begin(), s.lru, last);
+      s.evictions++;
+    }
+    else {
+      s.lru.push_front(tuple<uint64_t, double>(h, v));
+    }
+    s.where[h] = s.lru.begin();
+    numInserts++;
+    return;
+  }
+
+
+  double EvalCache::value(uint64_t h, function<double()> f) {
+    double v = 0.0;
+    if (!lookup(h, v)) {
+      v = f();
+      insert(h, v);
+    }
+    return v;
+  }
+
+
+  void EvalCache::clear() {
+    for (auto& s : shards) {
+      std::lock_guard<std::mutex> lk(s.mtx);
+      s.lru.clear();
+      s.where.clear();
+    }
+    return;
+  }
+
+
+  EvalCacheStats EvalCache::stats() const {
+    auto cs = EvalCacheStats();
+    cs.lookups = numLookups.load();
+    cs.hits = numHits.load();
+    cs.inserts = numInserts.load();
+    for (auto& s : shards) {
+      // a snapshot: other threads may be changing it as we read
+      std::lock_guard<std::mutex> lk(s.mtx);
+      cs.evictions = cs.evictions + s.evictions;
+      cs.size = cs.size + s.where.size();
+    }
+    return cs;
+  }
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -0,0 +1,122 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// A bounded, thread-safe memo of fitness values, so that search engines
+// need not re-evaluate points they have already scored: GAOpt's duplicate
+// genes, or the neighbors a hill-climber revisits as it oscillates.
+//
+// Points are identified only by a 64-bit hash, which the caller supplies
+// (e.g. MtchPstn::hash, or hashKMatrix for real-valued points). Two different
+// points with the same hash would share a value; with a decent 64-bit hash
+// that is vanishingly unlikely, and it saves storing a copy of every point.
+//
+// The cache is split into shards, each with its own lock and its own
+// least-recently-used list, so threads working on different points seldom
+// wait for each other. One cache may be shared by several searches, as long
+// as they all evaluate the same function.
+// -------------------------------------------------
+#ifndef KTAB_EVALCACHE_H
+#define KTAB_EVALCACHE_H
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "kutils.h"
+#include "kmatrix.h"
+
+namespace KBase {
+
+  // combine x into the running hash h
+  uint64_t hashMix(uint64_t h, uint64_t x);
+  uint64_t hashVUI(const VUI & v);
+
+  // Elements are rounded to the nearest multiple of tol before hashing,
+  // so points within round-off of each other usually share a hash.
+  uint64_t hashKMatrix(const KMatrix & m, double tol);
+
+
+  class EvalCacheStats {
+  public:
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+    unsigned int size = 0;
+    double hitRate() const;
+    void show(const string & name) const;
+  };
+
+
+  class EvalCache {
+  public:
+    // Holds at most cap values in all, spread over ns shards
+    explicit EvalCache(unsigned int cap, unsigned int ns = 16);
+    virtual ~EvalCache();
+
+    // If the hash is known, set v and return true.
+    bool lookup(uint64_t h, double & v);
+    void insert(uint64_t h, double v);
+
+    // Look it up, or else evaluate and remember it. Two threads asking for the
+    // same new point at the same time may both evaluate it, but the lock is never
+    // held during an evaluation.
+    double value(uint64_t h, function<double()> f);
+
+    void clear();
+    EvalCacheStats stats() const;
+    unsigned int capacity() const { return shardCap * numShards; }
+
+  protected:
+    typedef std::list<tuple<uint64_t, double>> LRUList;
+
+    class Shard {
+    public:
+      mutable std::mutex mtx;
+      LRUList lru; // most recently used first
+      std::unordered_map<uint64_t, LRUList::iterator> where;
+      uint64_t evictions = 0;
+      Shard() : mtx(), lru(), where() {}
+    };
+
+    Shard& shardOf(uint64_t h) { return shards[(h >> 32) % numShards]; }
+
+    unsigned int numShards = 0;
+    unsigned int shardCap = 0;
+    vector<Shard> shards;
+    std::atomic<uint64_t> numLookups;
+    std::atomic<uint64_t> numHits;
+    std::atomic<uint64_t> numInserts;
+
+  private:
+    EvalCache(const EvalCache&) = delete;
+    EvalCache& operator=(const EvalCache&) = delete;
+  };
+
+}; // end of namespace
+
+// -------------------------------------------------
+#endif
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -26,15 +26,18 @@
 #define GAOPT_H
 
 #include <assert.h>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
 #include "prng.h"
 #include "kutils.h"
+#include "evalcache.h"
 
 namespace KBase {
   using std::cout;
@@ -46,17 +49,91 @@ namespace KBase {
   using std::vector;
 
   class PRNG;
-  class KMatrix;
+  template <class GAP> class GAIslands;
 
   unsigned int crossSite(PRNG* rng, unsigned int nc);
 
   // -------------------------------------------------
-
+  // A free-list of genes which are no longer in use, so that they can be
+  // filled in place rather than deleted and new'd again. Once the free-list
+  // has grown to the number of genes dropped in one generation, the GA
+  // does no further heap allocation of genes.
   template <class GAP>
-  class GAOpt {
+  class GenePool {
   public:
-    explicit GAOpt(unsigned int s);
-    virtual ~GAOpt();
+    GenePool() {}
+    virtual ~GenePool();
+
+    // Return a gene whose contents are garbage, to be overwritten.
+    GAP* take();
+
+    // Hand a gene back for later reuse. The pool now owns it.
+    void give(GAP* g);
+
+    // create a new gene, when there are none to reuse
+    function <GAP* ()> makeBlank = nullptr;
+
+    unsigned int numFree() const { return spares.size(); }
+    uint64_t numMade = 0;
+    uint64_t numReused = 0;
+
+  protected:
+    vector<GAP*> spares = {};
+  };
+
+  template<class GAP>
+  GenePool<GAP>::~GenePool() {
+    for (auto g : spares) {
+      delete g;
+    }
+    spares.clear();
+  }
+
+  template<class GAP>
+  GAP* GenePool<GAP>::take() {
+    GAP* g = nullptr;
+    if (0 < spares.size()) {
+      g = spares.back();
+      spares.pop_back();
+      numReused++;
+    }
+    else {
+      assert(nullptr != makeBlank);
+      g = makeBlank();
+      numMade++;
+    }
+    assert(nullptr != g);
+    return g;
+  }
+
+  template<class GAP>
+  void GenePool<GAP>::give(GAP* g) {
+    assert(nullptr != g);
+    spares.push_back(g);
+    return;
+  }
+
+  // -------------------------------------------------
+
+  // The GA itself, with its operators supplied by the policy class Ops,
+  // from which it inherits. As the operators are resolved at compile time,
+  // a tight evalGene or equiv (called O(n^2) times by dropDups) can be inlined.
+  // An Ops class must provide these, as member functions or callable members:
+  //   double evalGene(const GAP* g1);
+  //   GAP* mutateGene(const GAP* g1, PRNG* rng);
+  //   tuple<GAP*, GAP*> crossGenes(const GAP* g1, const GAP* g2, PRNG* rng);
+  //   bool equiv(const GAP* g1, const GAP* g2);
+  //   GAP* makeGene(PRNG* rng);
+  //   void showGene(const GAP* g1);
+  //   void dropGene(GAP* g1); // the GA is done with it: delete it, or keep it for reuse
+  // GAOpt uses GAFnOps, which calls std::function members; for lambdas known
+  // at compile time, see GALambdaOps and makeGAOps.
+  template <class GAP, class Ops>
+  class GAOptT : public Ops {
+  public:
+    explicit GAOptT(unsigned int s);
+    GAOptT(unsigned int s, const Ops & ops);
+    virtual ~GAOptT();
 
     void init(vector < GAP* > ipop); 
     void fill(PRNG* rng); 
@@ -67,25 +144,10 @@ namespace KBase {
     tuple<double, GAP* > getNth(unsigned int n); 
     void show();   
 
-    // lambda functions that must be supplied to define your particular problem
-    function <tuple<GAP*, GAP*>(const GAP* g1, const GAP* g2, PRNG* rng)> cross = nullptr;
-    function <GAP* (const GAP* g1, PRNG* rng)> mutate = nullptr;
-    function <double(const GAP* g1)> eval = nullptr;
-    function <void(const GAP*)> showGene = nullptr;
-    function <GAP* (PRNG* rng)> makeGene = nullptr;
-    function <bool(const GAP* g1, const GAP* g2)> equiv = nullptr;
-
-    // If you provide the appropriate methods in a GAP class,
-    // the lambdas can be quite simple:
-    // cross = [](const GAP* g1, const GAP* g2, PRNG* rng) { return g1->cross(g2, rng); };
-    // mutate = [](const GAP* g1, PRNG* rng)               { return (g1->mutate(rng));  };
-    // equiv = [](const GAP* g1, const GAP* g2)            { return g1->equiv(g2);      };
-    // showGene = [](const GAP* g1)                        { g1->show(); return;        };
-    // makeGene = [](const GAP* g1, PRNG* rng)             { return (GAP::random(rng)); };
-
     void sortPop(); 
     
   protected:
+    friend class GAIslands<GAP>;
     void step();
     void mutatePop();
     void crossPop();
@@ -95,14 +157,32 @@ namespace KBase {
     unsigned int pSize = 0;
     double cFrac = 1.0;
     double mFrac = 0.5;
-    GAP* mutateOne(const GAP* g1, PRNG* rng);
-    tuple<GAP*, GAP*> crossPair(const GAP* g1, const GAP* g2, PRNG* rng);
-    void cyclicApply(function <void(unsigned int i)> fn, double f);
+    template <class Fn>
+    void cyclicApply(Fn fn, double f);
     PRNG* rng = nullptr;
+    // reused by dropDups, so that a step allocates nothing once they have grown
+    vector < tuple<double, GAP* >> scratch = {};
+    vector<bool> unique = {};
+
+  private:
+    void setSize(unsigned int s);
+    // the population's genes are owned, and deleted, by this GA
+    GAOptT(const GAOptT&) = delete;
+    GAOptT& operator=(const GAOptT&) = delete;
   };
 
-  template<class GAP>
-  GAOpt<GAP>::GAOpt(unsigned int s) {
+  template <class GAP, class Ops>
+  GAOptT<GAP, Ops>::GAOptT(unsigned int s) : Ops() {
+    setSize(s);
+  }
+
+  template <class GAP, class Ops>
+  GAOptT<GAP, Ops>::GAOptT(unsigned int s, const Ops & ops) : Ops(ops) {
+    setSize(s);
+  }
+
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::setSize(unsigned int s) {
     assert(1 < s); // long enough to do a crossover
     pSize = s;
     cFrac = 0;
@@ -114,34 +194,22 @@ namespace KBase {
     for (unsigned int i = 0; i < pSize; i++) {
       gpool[i] = tuple <double, GAP*>(0, nullptr);
     }
-
-    cross = nullptr;
-    mutate = nullptr;
-    eval = nullptr;
-    showGene = nullptr;
-    makeGene = nullptr;
-    equiv = nullptr;
+    return;
   }
 
-  template<class GAP>
-  GAOpt<GAP>::~GAOpt() {
+  template <class GAP, class Ops>
+  GAOptT<GAP, Ops>::~GAOptT() {
     for (auto pr : gpool) {
       delete get<1>(pr);
     }
   }
 
 
-  template<class GAP>
-  void GAOpt<GAP>::run(PRNG* rng, double c, double m,
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::run(PRNG* rng, double c, double m,
     unsigned int maxI, double sTh, unsigned int maxS,
     ReportingLevel srl,
     unsigned int & iter, unsigned int &sIter) {
-    assert(cross != nullptr);
-    assert(mutate != nullptr);
-    assert(eval != nullptr);
-    assert(showGene != nullptr);
-    assert(makeGene != nullptr);
-    assert(equiv != nullptr);
     iter = 0;
     sIter = 0;
     //double oldBest = 0.0;
@@ -178,7 +246,7 @@ namespace KBase {
         printf("%u/%u iterations    %u/%u stable \n", iter, maxI, sIter, maxS);
         printf("newBest value: %+.4f up %+.4f  \n", newBest, dv);
         cout << "newBest gene: ";
-        showGene(get<1>(pri));
+        this->showGene(get<1>(pri));
         cout << endl;
         if (ReportingLevel::Medium < srl) {
           show();
@@ -191,21 +259,21 @@ namespace KBase {
       printf("Search completed after %u/%u iterations    %u/%u stable \n", iter, maxI, sIter, maxS);
       printf("best value: %+.4f  \n", get<0>(pri));
       cout << "best gene: ";
-      showGene(get<1>(pri));
+      this->showGene(get<1>(pri));
       cout << endl << endl << flush;
     }
     return;
   }
 
 
-  template<class GAP>
-  tuple<double, GAP* > GAOpt<GAP>::getNth(unsigned int n) {
+  template <class GAP, class Ops>
+  tuple<double, GAP* > GAOptT<GAP, Ops>::getNth(unsigned int n) {
     assert(n < gpool.size()); // check here
     return gpool[n];
   }
 
-  template<class GAP>
-  void GAOpt<GAP>::sortPop() {
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::sortPop() {
     const unsigned int ps = gpool.size();
     for (unsigned int i = 0; i < ps; i++) {
       for (unsigned int j = i + 1; j < ps; j++) {
@@ -222,11 +290,10 @@ namespace KBase {
     return;
   }
 
-  template<class GAP>
-  void GAOpt<GAP>::dropDups() {
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::dropDups() {
     using KBase::popBack;
     unsigned int cSize = gpool.size();
-    auto unique = vector<bool>();
     unique.resize(cSize);
     for (unsigned int i = 0; i < cSize; i++) {
       unique[i] = true;
@@ -235,40 +302,39 @@ namespace KBase {
       GAP* gi = get<1>(getNth(i));
       for (unsigned int j = 0; j < i; j++) {
         GAP* gj = get<1>(getNth(j));
-        if (equiv(gi, gj)) {
+        if (this->equiv(gi, gj)) {
           unique[i] = false;
         }
       }
     }
-    auto newGP = vector<tuple<double, GAP*>>();
+    scratch.clear();
     for (unsigned int i = 0; i < cSize; i++) {
       auto pri = getNth(i);
       if (unique[i]) {
-        newGP.push_back(pri);
+        scratch.push_back(pri);
       }
       else {
         GAP* gi = get<1>(pri);
-        delete gi;
+        this->dropGene(gi);
         get<1>(pri) = nullptr;
       }
     }
     gpool.clear();
-    while (0 < newGP.size()) {
-      auto pr = popBack(newGP);
+    while (0 < scratch.size()) {
+      auto pr = popBack(scratch);
       assert(nullptr != get<1>(pr));
       gpool.push_back(pr);
     }
     return;
   }
 
-  template <class GAP>
-  void GAOpt<GAP>::selectPop() {
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::selectPop() {
     sortPop();
     while (pSize < gpool.size()) {
       auto pr = KBase::popBack(gpool);
       GAP * g = get<1>(pr);
-      assert(nullptr != g);
-      delete g;
+      this->dropGene(g);
     }
     return;
   }
@@ -276,8 +342,9 @@ namespace KBase {
 
 
 
-  template <class GAP>
-  void GAOpt<GAP>::cyclicApply(function <void(unsigned int i)> fn, double f) {
+  template <class GAP, class Ops>
+  template <class Fn>
+  void GAOptT<GAP, Ops>::cyclicApply(Fn fn, double f) {
     while (1 <= f) {
       for (unsigned int i = 0; i < pSize; i++) {
         fn(i);
@@ -299,10 +366,10 @@ namespace KBase {
   }
 
 
-  template <class GAP>
-  void GAOpt<GAP>::crossPop() {
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::crossPop() {
     auto add = [this](GAP* g) {
-      double v = eval(g);
+      double v = this->evalGene(g);
       auto pr = tuple<double, GAP*>(v, g);
       gpool.push_back(pr);
       return;
@@ -312,7 +379,7 @@ namespace KBase {
       unsigned int j = rng->uniform() % gpool.size();
       GAP* gi = get<1>(getNth(i));
       GAP* gj = get<1>(getNth(j));
-      auto pr = cross(gi, gj, rng);
+      auto pr = this->crossGenes(gi, gj, rng);
       add(get<0>(pr));
       add(get<1>(pr));
       return;
@@ -322,12 +389,12 @@ namespace KBase {
   }
 
 
-  template <class GAP>
-  void GAOpt<GAP>::mutatePop() {
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::mutatePop() {
     auto mFn = [this](unsigned int i) {
       GAP* gi = get<1>(getNth(i));
-      GAP* mg = mutate(gi, rng);
-      double mgv = eval(mg);
+      GAP* mg = this->mutateGene(gi, rng);
+      double mgv = this->evalGene(mg);
       auto mpr = tuple<double, GAP*>(mgv, mg);
       gpool.push_back(mpr);
       return;
@@ -336,8 +403,8 @@ namespace KBase {
     return;
   }
 
-  template <class GAP>
-  void GAOpt<GAP>::show() {
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::show() {
     for (unsigned int i = 0; i < gpool.size(); i++) {
       auto pri = gpool[i];
       auto vi = get<0>(pri);
@@ -345,14 +412,14 @@ namespace KBase {
       printf("%4u  %8.3f   ", i, vi);
       cout << flush;
       assert(nullptr != gi);
-      showGene(gi);
+      this->showGene(gi);
       cout << endl << flush;
     }
     return;
   }
 
-  template <class GAP>
-  void GAOpt<GAP>::step() {
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::step() {
     assert(pSize == gpool.size());
     mutatePop();
     crossPop();
@@ -364,18 +431,16 @@ namespace KBase {
   }
 
 
-  template <class GAP>
-  void GAOpt<GAP>::fill(PRNG* r) {
-    assert(eval != nullptr);
-    assert(makeGene != nullptr);
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::fill(PRNG* r) {
     assert(nullptr != r);
     rng = r;
     //const unsigned int ps = gpool.size();
     for (unsigned int i = 0; i < gpool.size(); i++) {
       auto pri = gpool[i];
       if (nullptr == get<1>(pri)) {
-        GAP* gi = makeGene(rng);
-        double vi = eval(gi);
+        GAP* gi = this->makeGene(rng);
+        double vi = this->evalGene(gi);
         gpool[i] = tuple<double, GAP*>(vi, gi);
       }
     }
@@ -383,9 +448,8 @@ namespace KBase {
   }
 
 
-  template <class GAP>
-  void GAOpt<GAP>::init(vector < GAP* > ipop) {
-    assert(eval != nullptr);
+  template <class GAP, class Ops>
+  void GAOptT<GAP, Ops>::init(vector < GAP* > ipop) {
     assert(ipop.size() <= pSize);
     for (unsigned int i = 0; i < ipop.size(); i++) {
       auto pri = getNth(i);
@@ -393,7 +457,7 @@ namespace KBase {
       assert(nullptr == tgi);
       auto gi = ipop[i];
       assert(nullptr != gi);
-      double vi = eval(gi);
+      double vi = this->evalGene(gi);
       auto pvi = tuple<double, GAP*>(vi, gi);
       gpool[i] = pvi;
     }
@@ -401,6 +465,469 @@ namespace KBase {
   }
 
 
+  // -------------------------------------------------
+  // The operators of GAOpt, as std::function members which can be set at run time.
+  template <class GAP>
+  class GAFnOps {
+  public:
+    GAFnOps() {}
+    virtual ~GAFnOps() {}
+
+    // lambda functions that must be supplied to define your particular problem
+    function <tuple<GAP*, GAP*>(const GAP* g1, const GAP* g2, PRNG* rng)> cross = nullptr;
+    function <GAP* (const GAP* g1, PRNG* rng)> mutate = nullptr;
+    function <double(const GAP* g1)> eval = nullptr;
+    function <void(const GAP*)> showGene = nullptr;
+    function <GAP* (PRNG* rng)> makeGene = nullptr;
+    function <bool(const GAP* g1, const GAP* g2)> equiv = nullptr;
+
+    // If you provide the appropriate methods in a GAP class,
+    // the lambdas can be quite simple:
+    // cross = [](const GAP* g1, const GAP* g2, PRNG* rng) { return g1->cross(g2, rng); };
+    // mutate = [](const GAP* g1, PRNG* rng)               { return (g1->mutate(rng));  };
+    // equiv = [](const GAP* g1, const GAP* g2)            { return g1->equiv(g2);      };
+    // showGene = [](const GAP* g1)                        { g1->show(); return;        };
+    // makeGene = [](const GAP* g1, PRNG* rng)             { return (GAP::random(rng)); };
+
+    // Optionally, the offspring can be written into genes taken from the pool,
+    // rather than new'd. If mutateInto and crossInto are both set (along with
+    // pool.makeBlank), they are used instead of mutate and cross, and
+    // every dropped gene goes back to the pool rather than being deleted.
+    function <void(const GAP* g1, PRNG* rng, GAP* out)> mutateInto = nullptr;
+    function <void(const GAP* g1, const GAP* g2, PRNG* rng, GAP* outA, GAP* outB)> crossInto = nullptr;
+    GenePool<GAP> pool = GenePool<GAP>();
+    bool recycling() const { return (nullptr != mutateInto) && (nullptr != crossInto); }
+
+    // Optionally, remember the value of each gene, by its hash, so that
+    // duplicates are not evaluated again. The cache is not owned by GAOpt,
+    // and may be shared (e.g. by all the islands of a GAIslands).
+    EvalCache* cache = nullptr;
+    function <uint64_t(const GAP* g1)> hashGene = nullptr;
+
+    // the operators GAOptT calls
+    double evalGene(const GAP* g);
+    GAP* mutateGene(const GAP* g, PRNG* rng);
+    tuple<GAP*, GAP*> crossGenes(const GAP* g1, const GAP* g2, PRNG* rng);
+    void dropGene(GAP* g);
+
+  private:
+    // a copy would share the pool's spare genes, and the cache
+    GAFnOps(const GAFnOps&) = delete;
+    GAFnOps& operator=(const GAFnOps&) = delete;
+  };
+
+  template<class GAP>
+  double GAFnOps<GAP>::evalGene(const GAP* g) {
+    if ((nullptr == cache) || (nullptr == hashGene)) {
+      return eval(g);
+    }
+    return cache->value(hashGene(g), [this, g]() { return eval(g); });
+  }
+
+  template<class GAP>
+  GAP* GAFnOps<GAP>::mutateGene(const GAP* g, PRNG* rng) {
+    if (!recycling()) {
+      return mutate(g, rng);
+    }
+    GAP* mg = pool.take();
+    mutateInto(g, rng, mg);
+    return mg;
+  }
+
+  template<class GAP>
+  tuple<GAP*, GAP*> GAFnOps<GAP>::crossGenes(const GAP* g1, const GAP* g2, PRNG* rng) {
+    if (!recycling()) {
+      return cross(g1, g2, rng);
+    }
+    GAP* gA = pool.take();
+    GAP* gB = pool.take();
+    crossInto(g1, g2, rng, gA, gB);
+    return tuple<GAP*, GAP*>(gA, gB);
+  }
+
+  template<class GAP>
+  void GAFnOps<GAP>::dropGene(GAP* g) {
+    assert(nullptr != g);
+    if (recycling()) {
+      pool.give(g);
+    }
+    else {
+      delete g;
+    }
+    return;
+  }
+
+
+  // -------------------------------------------------
+  // The original GA, whose operators are std::function members set at run time.
+  template <class GAP>
+  class GAOpt : public GAOptT<GAP, GAFnOps<GAP>> {
+  public:
+    explicit GAOpt(unsigned int s) : GAOptT<GAP, GAFnOps<GAP>>(s) {}
+    virtual ~GAOpt() {}
+
+    // check that the lambdas are set, then run the GA
+    void fill(PRNG* rng);
+    void run(PRNG* rng, double c, double m,
+      unsigned int maxI, double sTh, unsigned int maxS,
+      ReportingLevel srl,
+      unsigned int & iter, unsigned int &sIter);
+  };
+
+  template<class GAP>
+  void GAOpt<GAP>::fill(PRNG* r) {
+    assert(this->eval != nullptr);
+    assert(this->makeGene != nullptr);
+    GAOptT<GAP, GAFnOps<GAP>>::fill(r);
+    return;
+  }
+
+  template<class GAP>
+  void GAOpt<GAP>::run(PRNG* r, double c, double m,
+    unsigned int maxI, double sTh, unsigned int maxS,
+    ReportingLevel srl,
+    unsigned int & iter, unsigned int &sIter) {
+    // either both operators allocate, or both write into pooled genes
+    assert(((this->cross != nullptr) && (this->mutate != nullptr)) || this->recycling());
+    assert(!this->recycling() || (this->pool.makeBlank != nullptr));
+    assert(this->eval != nullptr);
+    assert(this->showGene != nullptr);
+    assert(this->makeGene != nullptr);
+    assert(this->equiv != nullptr);
+    GAOptT<GAP, GAFnOps<GAP>>::run(r, c, m, maxI, sTh, maxS, srl, iter, sIter);
+    return;
+  }
+
+
+  // -------------------------------------------------
+  // The operators as lambdas (or other functors) whose types are known at compile time.
+  // Genes which leave the population are deleted. For example,
+  //   auto ops = makeGAOps<BVec>(evalFn, mutateFn, crossFn, equivFn, makeFn, showFn);
+  //   auto ga = new GAOptT<BVec, decltype(ops)>(n, ops);
+  template <class GAP, class EvalFn, class MutFn, class CrossFn, class EquivFn, class MakeFn, class ShowFn>
+  class GALambdaOps {
+  public:
+    GALambdaOps(EvalFn e, MutFn m, CrossFn c, EquivFn q, MakeFn k, ShowFn s) :
+      evalFn(e), mutateFn(m), crossFn(c), equivFn(q), makeFn(k), showFn(s) {}
+    virtual ~GALambdaOps() {}
+
+    double evalGene(const GAP* g) { return evalFn(g); }
+    GAP* mutateGene(const GAP* g, PRNG* rng) { return mutateFn(g, rng); }
+    tuple<GAP*, GAP*> crossGenes(const GAP* g1, const GAP* g2, PRNG* rng) { return crossFn(g1, g2, rng); }
+    bool equiv(const GAP* g1, const GAP* g2) { return equivFn(g1, g2); }
+    GAP* makeGene(PRNG* rng) { return makeFn(rng); }
+    void showGene(const GAP* g) { showFn(g); return; }
+    void dropGene(GAP* g) { delete g; return; }
+
+  protected:
+    EvalFn evalFn;
+    MutFn mutateFn;
+    CrossFn crossFn;
+    EquivFn equivFn;
+    MakeFn makeFn;
+    ShowFn showFn;
+  };
+
+  template <class GAP, class EvalFn, class MutFn, class CrossFn, class EquivFn, class MakeFn, class ShowFn>
+  GALambdaOps<GAP, EvalFn, MutFn, CrossFn, EquivFn, MakeFn, ShowFn>
+    makeGAOps(EvalFn e, MutFn m, CrossFn c, EquivFn q, MakeFn k, ShowFn s) {
+    return GALambdaOps<GAP, EvalFn, MutFn, CrossFn, EquivFn, MakeFn, ShowFn>(e, m, c, q, k, s);
+  }
+
+
+  // -------------------------------------------------
+  // Island-model GA: several GAOpt populations evolve independently, each on
+  // its own thread and with its own PRNG stream, and every few generations
+  // the best few genes of each island are copied to its neighbors.
+  // Because the islands never share anything while they evolve, and
+  // migration is done by one thread, the result depends on the seed but
+  // not on the number of threads.
+
+  enum class MigrationTopology {
+    Ring,    // island k sends to island k+1 (mod n)
+    AllToAll // every island sends to every other island
+  };
+
+  template <class GAP>
+  class GAIslands {
+  public:
+    GAIslands(unsigned int ni, uint64_t seed);
+    virtual ~GAIslands();
+
+    // Build island k, with all the lambdas of GAOpt set (and its pool, if recycling).
+    // The eval lambdas are called concurrently, from different islands,
+    // so they must be safe to call from several threads at once.
+    function <GAOpt<GAP>* (unsigned int k)> makeIsland = nullptr;
+
+    // A new, independent copy of a gene, to migrate to another island
+    function <GAP* (const GAP* g)> copyGene = nullptr;
+
+    MigrationTopology topology = MigrationTopology::Ring;
+    unsigned int numMigrants = 2;  // top-k genes sent by each island
+    unsigned int migrationGap = 10; // generations between migrations
+    unsigned int numThreads = 0; // 0 means one per core
+
+    // Same stopping rule as GAOpt::run, applied to the best over all islands:
+    // stop after maxI generations, or after maxS generations in a row
+    // in which the best value rose by no more than sTh.
+    void run(double c, double m,
+      unsigned int maxI, double sTh, unsigned int maxS,
+      ReportingLevel srl,
+      unsigned int & iter, unsigned int &sIter);
+
+    // best over all islands; the gene still belongs to its island
+    tuple<double, GAP* > getBest() const;
+    unsigned int numIslands() const { return islands.size(); }
+    GAOpt<GAP>* island(unsigned int k) const { return islands[k]; }
+    uint64_t numMigrated = 0;
+
+  protected:
+    void build();
+    void parallelApply(function <void(unsigned int k)> fn);
+    void migrate();
+    void receive(GAOpt<GAP>* ga, double v, GAP* g);
+    vector<GAOpt<GAP>*> islands = {};
+    vector<PRNG*> rngs = {};
+    uint64_t seed = 0;
+  };
+
+
+  template <class GAP>
+  GAIslands<GAP>::GAIslands(unsigned int ni, uint64_t s) {
+    assert(1 < ni);
+    seed = s;
+    islands = vector<GAOpt<GAP>*>(ni, nullptr);
+    rngs = vector<PRNG*>();
+  }
+
+
+  template <class GAP>
+  GAIslands<GAP>::~GAIslands() {
+    for (auto ga : islands) {
+      delete ga;
+    }
+    for (auto r : rngs) {
+      delete r;
+    }
+  }
+
+
+  template <class GAP>
+  void GAIslands<GAP>::build() {
+    assert(nullptr != makeIsland);
+    if (0 < rngs.size()) {
+      return;
+    }
+    // Draw every island's seed from one master stream
+    auto mr = PRNG();
+    mr.setSeed(seed);
+    for (unsigned int k = 0; k < islands.size(); k++) {
+      auto rk = new PRNG();
+      rk->setSeed(mr.uniform());
+      rngs.push_back(rk);
+      islands[k] = makeIsland(k);
+      assert(nullptr != islands[k]);
+    }
+    return;
+  }
+
+
+  template <class GAP>
+  void GAIslands<GAP>::parallelApply(function <void(unsigned int k)> fn) {
+    const unsigned int ni = islands.size();
+    unsigned int nt = numThreads;
+    if (0 == nt) {
+      nt = std::thread::hardware_concurrency();
+    }
+    if (0 == nt) { // not computable or not well defined
+      nt = 1;
+    }
+    if (ni < nt) {
+      nt = ni;
+    }
+    // each worker claims the next unclaimed island
+    std::atomic<unsigned int> nextK(0);
+    auto worker = [ni, fn, &nextK]() {
+      unsigned int k = nextK++;
+      while (k < ni) {
+        fn(k);
+        k = nextK++;
+      }
+      return;
+    };
+    auto ts = vector<std::thread>();
+    for (unsigned int t = 1; t < nt; t++) {
+      ts.push_back(std::thread(worker));
+    }
+    worker(); // this thread works too
+    for (auto& t : ts) {
+      t.join();
+    }
+    return;
+  }
+
+
+  template <class GAP>
+  void GAIslands<GAP>::receive(GAOpt<GAP>* ga, double v, GAP* g) {
+    // The pool is sorted, best first. Duplicates and migrants no better
+    // than the worst resident are dropped; otherwise the migrant replaces
+    // the worst resident and is moved up to its place.
+    auto& gp = ga->gpool;
+    const unsigned int n = gp.size();
+    bool keep = (get<0>(gp[n - 1]) < v);
+    for (unsigned int i = 0; keep && (i < n); i++) {
+      keep = !(ga->equiv(get<1>(gp[i]), g));
+    }
+    if (!keep) {
+      ga->dropGene(g);
+      return;
+    }
+    ga->dropGene(get<1>(gp[n - 1]));
+    gp[n - 1] = tuple<double, GAP*>(v, g);
+    for (unsigned int i = n - 1; (0 < i) && (get<0>(gp[i - 1]) < v); i--) {
+      auto t = gp[i - 1];
+      gp[i - 1] = gp[i];
+      gp[i] = t;
+    }
+    numMigrated++;
+    return;
+  }
+
+
+  template <class GAP>
+  void GAIslands<GAP>::migrate() {
+    assert(nullptr != copyGene);
+    const unsigned int ni = islands.size();
+    // Take copies of all the emigrants before any island receives any,
+    // so the order in which islands are visited does not matter.
+    auto emig = vector<vector<tuple<double, GAP*>>>(ni);
+    for (unsigned int k = 0; k < ni; k++) {
+      auto ga = islands[k];
+      const unsigned int nm = (numMigrants < ga->gpool.size()) ? numMigrants : ga->gpool.size();
+      for (unsigned int i = 0; i < nm; i++) {
+        auto pr = ga->getNth(i);
+        emig[k].push_back(tuple<double, GAP*>(get<0>(pr), copyGene(get<1>(pr))));
+      }
+    }
+    for (unsigned int k = 0; k < ni; k++) {
+      for (unsigned int d = 1; d < ni; d++) {
+        const unsigned int j = (k + d) % ni;
+        const bool sendTo = (MigrationTopology::AllToAll == topology) || (1 == d);
+        if (sendTo) {
+          for (auto pr : emig[k]) {
+            receive(islands[j], get<0>(pr), copyGene(get<1>(pr)));
+          }
+        }
+      }
+      for (auto pr : emig[k]) {
+        delete get<1>(pr);
+      }
+    }
+    return;
+  }
+
+
+  template <class GAP>
+  tuple<double, GAP* > GAIslands<GAP>::getBest() const {
+    auto best = islands[0]->getNth(0);
+    for (unsigned int k = 1; k < islands.size(); k++) {
+      auto pr = islands[k]->getNth(0);
+      if (get<0>(best) < get<0>(pr)) {
+        best = pr;
+      }
+    }
+    return best;
+  }
+
+
+  template <class GAP>
+  void GAIslands<GAP>::run(double c, double m,
+    unsigned int maxI, double sTh, unsigned int maxS,
+    ReportingLevel srl,
+    unsigned int & iter, unsigned int &sIter) {
+    assert((0 <= c) && (0 <= m) && (0 < c + m));
+    assert(0 < maxS);
+    assert(0 < sTh);
+    assert(maxS < maxI);
+    assert(0 < migrationGap);
+    assert(nullptr != copyGene);
+    iter = 0;
+    sIter = 0;
+
+    build();
+    const unsigned int ni = islands.size();
+    for (auto ga : islands) {
+      assert(((ga->cross != nullptr) && (ga->mutate != nullptr)) || ga->recycling());
+      assert(!ga->recycling() || (ga->pool.makeBlank != nullptr));
+      assert(ga->eval != nullptr);
+      assert(ga->showGene != nullptr);
+      assert(ga->makeGene != nullptr);
+      assert(ga->equiv != nullptr);
+      ga->cFrac = c;
+      ga->mFrac = m;
+    }
+    parallelApply([this](unsigned int k) {
+      islands[k]->fill(rngs[k]);
+      islands[k]->sortPop();
+      return;
+    });
+
+    // bestAt[k][g] is the best on island k after the g-th generation of this epoch
+    auto bestAt = vector<vector<double>>(ni, vector<double>(migrationGap, 0.0));
+    double oldBest = get<0>(getBest());
+    bool runP = true;
+    while (runP) {
+      const unsigned int ng = ((maxI - iter) < migrationGap) ? (maxI - iter) : migrationGap;
+      parallelApply([this, ng, &bestAt](unsigned int k) {
+        auto ga = islands[k];
+        for (unsigned int g = 0; g < ng; g++) {
+          ga->step();
+          bestAt[k][g] = get<0>(ga->getNth(0));
+        }
+        return;
+      });
+
+      // apply GAOpt::run's test to the global best, generation by generation
+      for (unsigned int g = 0; runP && (g < ng); g++) {
+        double newBest = bestAt[0][g];
+        for (unsigned int k = 1; k < ni; k++) {
+          newBest = (newBest < bestAt[k][g]) ? bestAt[k][g] : newBest;
+        }
+        double dv = newBest - oldBest;
+        assert(0.0 <= dv);
+        oldBest = newBest;
+        sIter = (sTh < dv) ? 0 : sIter + 1;
+        iter++;
+        runP = (iter < maxI) && (sIter < maxS);
+      }
+      // islands which ran on past the stopping point have only improved
+
+      if (runP) {
+        migrate();
+      }
+      if (ReportingLevel::Low < srl) {
+        auto pri = getBest();
+        printf("%u/%u iterations    %u/%u stable    %llu migrants accepted \n",
+          iter, maxI, sIter, maxS, (long long unsigned int) numMigrated);
+        printf("newBest value: %+.4f  \n", get<0>(pri));
+        for (unsigned int k = 0; k < ni; k++) {
+          printf("  island %2u best: %+.4f \n", k, get<0>(islands[k]->getNth(0)));
+        }
+        cout << endl << flush;
+      }
+    }
+    if (ReportingLevel::Silent < srl) {
+      auto pri = getBest();
+      printf("Island search completed after %u/%u iterations    %u/%u stable \n", iter, maxI, sIter, maxS);
+      printf("best value: %+.4f  \n", get<0>(pri));
+      cout << "best gene: ";
+      islands[0]->showGene(get<1>(pri));
+      cout << endl << endl << flush;
+    }
+    return;
+  }
+
+
 }; // namespace
 
 // -------------------------------------------------
@@ -35,7 +35,7 @@ namespace KBase {
       for (double si : pms) {
         KMatrix m1 = m0;
         m1(i, 0) = m0(i, 0) + (si*s);
-        nghbrs.push_back(m1);
+        nghbrs.push_back(std::move(m1));
       }
     }
     return nghbrs;
@@ -53,7 +53,7 @@ namespace KBase {
             KMatrix m1 = m0;
             m1(i, 0) = m0(i, 0) + (si*s);
             m1(j, 0) = m0(j, 0) + (sj*s);
-            nghbrs.push_back(m1);
+            nghbrs.push_back(std::move(m1));
           }
         }
       }
@@ -69,6 +69,13 @@ namespace KBase {
 
   VHCSearch::~VHCSearch() { }
 
+  double VHCSearch::evalPt(const KMatrix & p) {
+    if (nullptr == cache) {
+      return eval(p);
+    }
+    return cache->value(hashKMatrix(p, cacheTol), [this, &p]() { return eval(p); });
+  }
+
   tuple<double, KMatrix, unsigned int, unsigned int>
   VHCSearch::run(KMatrix p0,
 		 unsigned int iMax, unsigned int sMax, double sTol,
@@ -76,70 +83,12 @@ namespace KBase {
 		 ReportingLevel rl) {
     assert(eval != nullptr);
     assert(nghbrs != nullptr);
-    unsigned int iter = 0;
-    unsigned int sIter = 0;
-    double currStep = s0; 
-    double v0 = eval(p0); 
-    const double vInitial = v0;
-    
-    auto showFn = [this](string preface, const KMatrix & p,double v) {
-      printf("%s point: \n", preface.c_str());
-      trans(p).mPrintf(" %+0.4f ");
-      printf("%s value: %+.6f \n", preface.c_str(), v);
-      if (nullptr != report) {
-          report(p);
-        }
-      cout << endl << flush;
-      return;};
-    
-    if (ReportingLevel::Low <= rl) {
-      showFn("Initial", p0, v0);
-    }
-
-    while ((iter < iMax) && (sIter < sMax) && (minStep < currStep)) {
-      assert (vInitial <= v0);
-      double vBest = v0;
-      KMatrix pBest = p0;
-
-      for (auto pTmp : nghbrs(p0, currStep)) {
-        double vTmp = eval(pTmp);
-        if (vTmp > vBest) {
-          vBest = vTmp;
-          pBest = pTmp;
-        }
-      }
-
-      if (vBest > v0 + sTol) {
-        sIter = 0;
-        currStep = grow*currStep;
-        v0 = vBest;
-        p0 = pBest;
-      }
-      else {
-        sIter++;
-        currStep = shrink*currStep;
-      }
-      assert (vInitial <= v0);
-      
-      iter++;
-      
-        
-      if (ReportingLevel::Medium <= rl) {
-        printf ("After iteration %u \n", iter);
-	showFn("Best current", p0, v0);
-        if (nullptr != report) {
-          report(p0);
-        }
-      }
-    }
-
-    assert (vInitial <= v0); // either stay at orig point or improve it: never less
-    tuple<double, KMatrix, unsigned int, unsigned int> rslt{ v0, p0, iter, sIter };
-    
-    if (ReportingLevel::Low <= rl) {
-      showFn("Final", p0, v0);
-    }
-    return rslt;
+    auto ef = [this](const KMatrix & p) {
+      return evalPt(p);
+    };
+    auto core = makeVHCSearch(ef, std::cref(nghbrs));
+    core.report = report;
+    return core.run(std::move(p0), iMax, sMax, sTol, s0, shrink, grow, minStep, rl);
   }
 
 
@@ -25,13 +25,23 @@
 #ifndef KBASE_HCSEARCH_H
 #define KBASE_HCSEARCH_H
 
-#include <functional>   // function
+#include <functional>   // function, cref
 #include <iostream>     // cout, etc.
 #include <tuple>        // tuple, get, etc.
+#include <utility>      // move
 #include <vector>
 
 #include "kutils.h"
 #include "kmatrix.h"
+#include "evalcache.h"
+
+
+// ----------------------------------------------
+// GHCSearchT and VHCSearchT are the same searches with their operators
+// as compile-time types (functors or lambdas) rather than std::function,
+// so that a tight eval or nghbrs can be inlined into the search loop.
+// GHCSearch and VHCSearch keep their std::function members for flexibility,
+// and simply run the corresponding template.
 
 
 // ----------------------------------------------
@@ -50,11 +60,40 @@ namespace KBase {
   
   using KBase::ReportingLevel;
 
+  // maximize
+  template <class EvalFn, class NghbrFn>
+  class VHCSearchT {
+  public:
+    VHCSearchT(EvalFn e, NghbrFn n) : eval(e), nghbrs(n) {}
+    tuple<double, KMatrix, unsigned int, unsigned int>
+      run(KMatrix p0,
+          unsigned int iMax, unsigned int sMax, double sTol,
+          double s0, double shrink, double grow, double minStep,
+          ReportingLevel rl
+          );
+
+    EvalFn eval;   // double(const KMatrix &), maximize this function
+    NghbrFn nghbrs; // vector<KMatrix>(const KMatrix &, double step)
+    function <void (const KMatrix &)> report = nullptr; // only used when reporting
+  };
+
+  // so the lambda types can be deduced
+  template <class EvalFn, class NghbrFn>
+  VHCSearchT<EvalFn, NghbrFn> makeVHCSearch(EvalFn e, NghbrFn n) {
+    return VHCSearchT<EvalFn, NghbrFn>(e, n);
+  }
+
+
   // maximize
   class  VHCSearch {
   public:
     VHCSearch();
     virtual ~VHCSearch();
+    // the cache is not owned, so copies may simply share it
+    VHCSearch(const VHCSearch&) = default;
+    VHCSearch(VHCSearch&&) = default;
+    VHCSearch& operator=(const VHCSearch&) = default;
+    VHCSearch& operator=(VHCSearch&&) = default;
     tuple<double, KMatrix, unsigned int, unsigned int>
       run(KMatrix p0,
           unsigned int iMax, unsigned int sMax, double sTol,
@@ -68,8 +107,37 @@ namespace KBase {
     function <double(const KMatrix &)> eval = nullptr; // maximize this function
     function < vector<KMatrix>(const KMatrix &, double)> nghbrs = nullptr;
     function <void (const KMatrix &)> report = nullptr; 
+
+    // Optional memo of eval, not owned. Points are hashed after rounding
+    // to multiples of cacheTol, so it should be well below the minimum step.
+    EvalCache* cache = nullptr;
+    double cacheTol = 1E-12;
+
+  protected:
+    double evalPt(const KMatrix & p);
+  };
+
+
+  // maximize
+  template <class HCP, class EvalFn, class NghbrFn, class ShowFn>
+  class GHCSearchT {
+  public:
+    GHCSearchT(EvalFn e, NghbrFn n, ShowFn s) : eval(e), nghbrs(n), show(s) {}
+
+    tuple<double, HCP, unsigned int, unsigned int>
+      run(HCP p0, ReportingLevel srl, unsigned int iMax, unsigned int sMax, double sTol);
+
+    EvalFn eval;    // double(const HCP &)
+    NghbrFn nghbrs; // vector<HCP>(const HCP &)
+    ShowFn show;    // void(const HCP &), only used when reporting
   };
 
+  // so the lambda types can be deduced, as in makeGHCSearch<MtchPstn>(e, n, s)
+  template <class HCP, class EvalFn, class NghbrFn, class ShowFn>
+  GHCSearchT<HCP, EvalFn, NghbrFn, ShowFn> makeGHCSearch(EvalFn e, NghbrFn n, ShowFn s) {
+    return GHCSearchT<HCP, EvalFn, NghbrFn, ShowFn>(e, n, s);
+  }
+
 
   // maximize
   template <class HCP>
@@ -77,13 +145,26 @@ namespace KBase {
   public:
     GHCSearch();
     virtual ~GHCSearch();
+    // the cache is not owned, so copies may simply share it
+    GHCSearch(const GHCSearch&) = default;
+    GHCSearch(GHCSearch&&) = default;
+    GHCSearch& operator=(const GHCSearch&) = default;
+    GHCSearch& operator=(GHCSearch&&) = default;
 
     tuple<double, HCP, unsigned int, unsigned int>
       run(HCP p0, ReportingLevel srl, unsigned int iMax, unsigned int sMax, double sTol);
 
-    function <double(const HCP)> eval = nullptr;
-    function <vector<HCP>(const HCP)> nghbrs = nullptr;
-    function <void(const HCP)> show = nullptr;
+    // positions are passed by reference, so the search does not copy one per call
+    function <double(const HCP &)> eval = nullptr;
+    function <vector<HCP>(const HCP &)> nghbrs = nullptr;
+    function <void(const HCP &)> show = nullptr;
+
+    // Optional memo of eval, not owned, so that revisited neighbors are not re-evaluated
+    EvalCache* cache = nullptr;
+    function <uint64_t(const HCP &)> hashPt = nullptr;
+
+  protected:
+    double evalPt(const HCP & p);
   };
 
   template<class HCP>
@@ -100,12 +181,31 @@ namespace KBase {
     show = nullptr;
   }
 
+  template<class HCP>
+    double GHCSearch<HCP>::evalPt(const HCP & p) {
+    if ((nullptr == cache) || (nullptr == hashPt)) {
+      return eval(p);
+    }
+    return cache->value(hashPt(p), [this, &p]() { return eval(p); });
+  }
+
   template<class HCP>
     tuple<double, HCP, unsigned int, unsigned int>
     GHCSearch<HCP>::run(HCP p0, ReportingLevel srl,
                         unsigned int iMax, unsigned int sMax, double sTol) {
     assert(eval != nullptr);
     assert(nghbrs != nullptr);
+    auto ef = [this](const HCP & p) {
+      return evalPt(p);
+    };
+    auto core = makeGHCSearch<HCP>(ef, std::cref(nghbrs), std::cref(show));
+    return core.run(std::move(p0), srl, iMax, sMax, sTol);
+  }
+
+  template <class HCP, class EvalFn, class NghbrFn, class ShowFn>
+    tuple<double, HCP, unsigned int, unsigned int>
+    GHCSearchT<HCP, EvalFn, NghbrFn, ShowFn>::run(HCP p0, ReportingLevel srl,
+                        unsigned int iMax, unsigned int sMax, double sTol) {
     unsigned int iter = 0;
     unsigned int sIter = 0;
     double v0 = eval(p0);
@@ -115,7 +215,7 @@ namespace KBase {
       double vBest = v0;
       HCP pBest = p0;
 
-      for (HCP pTmp : nghbrs(p0)) {
+      for (const HCP & pTmp : nghbrs(p0)) {
         double vTmp = eval(pTmp);
         if (vTmp > vBest) {
           vBest = vTmp;
@@ -127,7 +227,7 @@ namespace KBase {
         sIter = 0;
         dv = vBest - v0;
         v0 = vBest;
-        p0 = pBest;
+        p0 = std::move(pBest);
       }
       else {
         sIter++;
@@ -142,7 +242,81 @@ namespace KBase {
         cout << endl << endl;
       }
     }
-    auto rslt = tuple<double, HCP, unsigned int, unsigned int>(v0, p0, iter, sIter);
+    auto rslt = tuple<double, HCP, unsigned int, unsigned int>(v0, std::move(p0), iter, sIter);
+    return rslt;
+  }
+
+  // ----------------------------------------------
+
+  template <class EvalFn, class NghbrFn>
+  tuple<double, KMatrix, unsigned int, unsigned int>
+  VHCSearchT<EvalFn, NghbrFn>::run(KMatrix p0,
+		 unsigned int iMax, unsigned int sMax, double sTol,
+		 double s0, double shrink, double grow, double minStep,
+		 ReportingLevel rl) {
+    unsigned int iter = 0;
+    unsigned int sIter = 0;
+    double currStep = s0; 
+    double v0 = eval(p0); 
+    const double vInitial = v0;
+    
+    auto showFn = [this](string preface, const KMatrix & p,double v) {
+      printf("%s point: \n", preface.c_str());
+      p.tView().mPrintf(" %+0.4f ");
+      printf("%s value: %+.6f \n", preface.c_str(), v);
+      if (nullptr != report) {
+          report(p);
+        }
+      cout << endl << flush;
+      return;};
+    
+    if (ReportingLevel::Low <= rl) {
+      showFn("Initial", p0, v0);
+    }
+
+    while ((iter < iMax) && (sIter < sMax) && (minStep < currStep)) {
+      assert (vInitial <= v0);
+      double vBest = v0;
+      KMatrix pBest = p0;
+
+      for (const auto & pTmp : nghbrs(p0, currStep)) {
+        double vTmp = eval(pTmp);
+        if (vTmp > vBest) {
+          vBest = vTmp;
+          pBest = pTmp;
+        }
+      }
+
+      if (vBest > v0 + sTol) {
+        sIter = 0;
+        currStep = grow*currStep;
+        v0 = vBest;
+        p0 = std::move(pBest);
+      }
+      else {
+        sIter++;
+        currStep = shrink*currStep;
+      }
+      assert (vInitial <= v0);
+      
+      iter++;
+      
+        
+      if (ReportingLevel::Medium <= rl) {
+        printf ("After iteration %u \n", iter);
+	showFn("Best current", p0, v0);
+        if (nullptr != report) {
+          report(p0);
+        }
+      }
+    }
+
+    assert (vInitial <= v0); // either stay at orig point or improve it: never less
+    tuple<double, KMatrix, unsigned int, unsigned int> rslt{ v0, p0, iter, sIter };
+    
+    if (ReportingLevel::Low <= rl) {
+      showFn("Final", p0, v0);
+    }
     return rslt;
   }
 
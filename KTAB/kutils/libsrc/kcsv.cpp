@@ -0,0 +1,345 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "kcsv.h"
+
+namespace KBase {
+
+  MappedFile::MappedFile(const string & fName) {
+    const string errMsg = "MappedFile: could not read " + fName;
+#ifdef _WIN32
+    HANDLE fh = CreateFileA(fName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == fh) {
+      throw KException(errMsg);
+    }
+    LARGE_INTEGER fs;
+    if (!GetFileSizeEx(fh, &fs)) {
+      CloseHandle(fh);
+      throw KException(errMsg);
+    }
+    len = (size_t)fs.QuadPart;
+    if (0 < len) {
+      HANDLE mh = CreateFileMappingA(fh, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (nullptr != mh) {
+        text = (const char*)MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+        if (nullptr != text) {
+          mapped = true;
+          fileH = fh;
+          mapH = mh;
+          return;
+        }
+        CloseHandle(mh);
+      }
+    }
+    CloseHandle(fh);
+#else
+    const int fd = open(fName.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw KException(errMsg);
+    }
+    struct stat sb;
+    if (0 != fstat(fd, &sb)) {
+      close(fd);
+      throw KException(errMsg);
+    }
+    len = (size_t)sb.st_size;
+    if (0 < len) {
+      void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (MAP_FAILED != p) {
+        madvise(p, len, MADV_SEQUENTIAL); // we scan it once, front to back
+        close(fd); // the mapping keeps the file open
+        text = (const char*)p;
+        mapped = true;
+        return;
+      }
+    }
+    close(fd);
+#endif
+
+    // Empty, or not mappable (e.g. a pipe): read it the ordinary way.
+    FILE* f = fopen(fName.c_str(), "rb");
+    if (nullptr == f) {
+      throw KException(errMsg);
+    }
+    string buff = "";
+    char chunk[1 << 16];
+    size_t n = fread(chunk, 1, sizeof(chunk), f);
+    while (0 < n) {
+      buff.append(chunk, n);
+      n = fread(chunk, 1, sizeof(chunk), f);
+    }
+    fclose(f);
+    len = buff.size();
+    auto t = new char[len + 1];
+    memcpy(t, buff.data(), len);
+    t[len] = 0;
+    text = t;
+    mapped = false;
+  }
+
+
+  MappedFile::~MappedFile() {
+    if (mapped) {
+#ifdef _WIN32
+      UnmapViewOfFile(text);
+      CloseHandle((HANDLE)mapH);
+      CloseHandle((HANDLE)fileH);
+#else
+      munmap((void*)text, len);
+#endif
+    }
+    else {
+      delete[] text;
+    }
+    text = nullptr;
+    len = 0;
+  }
+
+  // --------------------------------------------
+
+  CSVTable::CSVTable() {}
+
+
+  CSVTable::CSVTable(const string & fName, char sep) {
+    file = std::make_shared<MappedFile>(fName);
+    tokenize(file->data(), file->size(), sep);
+  }
+
+
+  CSVTable CSVTable::fromText(const string & s, char sep) {
+    auto tbl = CSVTable();
+    tbl.ownText = s;
+    tbl.tokenize(tbl.ownText.data(), tbl.ownText.size(), sep);
+    return tbl;
+  }
+
+
+  CSVTable::~CSVTable() {}
+
+
+  void CSVTable::tokenize(const char* s, size_t n, char sep) {
+    fields.clear();
+    rowStart.clear();
+    unquoted.clear();
+
+    // a rough guess, to avoid most of the reallocation on big files
+    fields.reserve(n / 8 + 1);
+
+    size_t i = 0;
+    bool rowOpen = false;
+    while (i < n) {
+      if (!rowOpen) {
+        // blank lines are not rows
+        if ('\n' == s[i]) {
+          i++;
+          continue;
+        }
+        if (('\r' == s[i]) && (i + 1 < n) && ('\n' == s[i + 1])) {
+          i = i + 2;
+          continue;
+        }
+        rowStart.push_back(fields.size());
+        rowOpen = true;
+      }
+
+      auto fld = Field();
+      fld.unq = -1;
+      if ('"' == s[i]) {
+        // quoted: copy only if there is a doubled quote to collapse
+        const size_t q0 = i + 1;
+        size_t j = q0;
+        bool doubled = false;
+        while (j < n) {
+          if ('"' == s[j]) {
+            if ((j + 1 < n) && ('"' == s[j + 1])) {
+              doubled = true;
+              j = j + 2;
+              continue;
+            }
+            break;
+          }
+          j++;
+        }
+        // j is at the closing quote, or at n if it was never closed
+        if (doubled) {
+          string u = "";
+          u.reserve(j - q0);
+          for (size_t k = q0; k < j; k++) {
+            u.push_back(s[k]);
+            if ('"' == s[k]) {
+              k++; // skip the second of the pair
+            }
+          }
+          fld.unq = unquoted.size();
+          unquoted.push_back(u);
+        }
+        fld.off = q0;
+        fld.len = j - q0;
+        i = (j < n) ? j + 1 : n;
+        // tolerate junk between the closing quote and the separator
+        while ((i < n) && (sep != s[i]) && ('\n' != s[i]) && ('\r' != s[i])) {
+          i++;
+        }
+      }
+      else {
+        size_t j = i;
+        while ((j < n) && (sep != s[j]) && ('\n' != s[j]) && ('\r' != s[j])) {
+          j++;
+        }
+        fld.off = i;
+        fld.len = j - i;
+        i = j;
+      }
+      fields.push_back(fld);
+
+      if (i < n) {
+        if (sep == s[i]) {
+          i++;
+          if (n == i) { // trailing separator at the very end
+            auto e = Field();
+            e.off = i;
+            e.len = 0;
+            e.unq = -1;
+            fields.push_back(e);
+          }
+        }
+        else { // end of row
+          if ('\r' == s[i]) {
+            i++;
+          }
+          if ((i < n) && ('\n' == s[i])) {
+            i++;
+          }
+          rowOpen = false;
+        }
+      }
+    }
+    return;
+  }
+
+
+  unsigned int CSVTable::numFields(unsigned int r) const {
+    if (numRows() <= r) {
+      return 0;
+    }
+    const unsigned int f1 = (r + 1 < numRows()) ? rowStart[r + 1] : fields.size();
+    return f1 - rowStart[r];
+  }
+
+
+  bool CSVTable::has(unsigned int r, unsigned int c) const {
+    return (c < numFields(r));
+  }
+
+
+  const char* CSVTable::fieldText(unsigned int r, unsigned int c, size_t & n) const {
+    n = 0;
+    if (!has(r, c)) {
+      return nullptr;
+    }
+    const Field & fld = fields[rowStart[r] + c];
+    if (0 <= fld.unq) {
+      const string & u = unquoted[fld.unq];
+      n = u.size();
+      return u.data();
+    }
+    n = fld.len;
+    return textBase() + fld.off;
+  }
+
+
+  string CSVTable::str(unsigned int r, unsigned int c) const {
+    size_t n = 0;
+    const char* p = fieldText(r, c, n);
+    return (nullptr == p) ? string("") : string(p, n);
+  }
+
+
+  // Trimmed, NUL-terminated copy of a field, so strtod cannot run past its end
+  string CSVTable::numText(unsigned int r, unsigned int c) const {
+    size_t n = 0;
+    const char* p = fieldText(r, c, n);
+    while ((0 < n) && ((' ' == p[0]) || ('\t' == p[0]))) {
+      p++;
+      n--;
+    }
+    while ((0 < n) && ((' ' == p[n - 1]) || ('\t' == p[n - 1]))) {
+      n--;
+    }
+    if (0 == n) {
+      char buff[100];
+      sprintf(buff, "CSVTable: missing number at row %u, column %u", r, c);
+      throw KException(buff);
+    }
+    return string(p, n);
+  }
+
+
+  double CSVTable::real(unsigned int r, unsigned int c) const {
+    const string t = numText(r, c);
+    char* end = nullptr;
+    errno = 0;
+    const double x = strtod(t.c_str(), &end);
+    if ((end != t.c_str() + t.size()) || (ERANGE == errno)) {
+      char buff[200];
+      snprintf(buff, sizeof(buff), "CSVTable: not a number at row %u, column %u: |%s|",
+               r, c, t.c_str());
+      throw KException(buff);
+    }
+    return x;
+  }
+
+
+  int64_t CSVTable::integer(unsigned int r, unsigned int c) const {
+    const string t = numText(r, c);
+    char* end = nullptr;
+    errno = 0;
+    const long long k = strtoll(t.c_str(), &end, 10);
+    if ((end != t.c_str() + t.size()) || (ERANGE == errno)) {
+      char buff[200];
+      snprintf(buff, sizeof(buff), "CSVTable: not an integer at row %u, column %u: |%s|",
+               r, c, t.c_str());
+      throw KException(buff);
+    }
+    return (int64_t)k;
+  }
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
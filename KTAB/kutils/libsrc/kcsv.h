@@ -0,0 +1,126 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// Reading CSV files in one pass over a memory-mapped copy of the file.
+//
+// The whole file is mapped (or, where mapping is not available, read in
+// one block), then split into fields in a single scan. Unquoted fields are
+// kept as offsets into the mapped text, so nothing is copied until a value
+// is asked for. Quoted fields follow RFC 4180: "a, b" is one field,
+// "say ""hi""" holds a doubled quote, and a quoted field may span lines.
+// Rows may end with either \n or \r\n, and blank lines are skipped.
+//
+// Unlike csv_parser, rows and columns count from 0.
+// -------------------------------------------------
+#ifndef KTAB_CSV_H
+#define KTAB_CSV_H
+
+#include <memory>
+
+#include "kutils.h"
+
+namespace KBase {
+
+  // Read-only view of a whole file. Throws KException if it cannot be opened.
+  class MappedFile {
+  public:
+    explicit MappedFile(const string & fName);
+    virtual ~MappedFile();
+
+    const char* data() const {
+      return text;
+    }
+    size_t size() const {
+      return len;
+    }
+    bool isMapped() const {
+      return mapped;
+    }
+
+  protected:
+    const char* text = nullptr;
+    size_t len = 0;
+    bool mapped = false; // or copied into a buffer we own
+#ifdef _WIN32
+    void* fileH = nullptr;
+    void* mapH = nullptr;
+#endif
+
+  private:
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+  };
+
+
+  class CSVTable {
+  public:
+    explicit CSVTable(const string & fName, char sep = ',');
+    static CSVTable fromText(const string & s, char sep = ',');
+    virtual ~CSVTable();
+
+    unsigned int numRows() const {
+      return rowStart.size();
+    }
+    unsigned int numFields(unsigned int r) const;
+
+    // Is there a field here, even an empty one?
+    bool has(unsigned int r, unsigned int c) const;
+
+    // Text of the field, unquoted. Missing fields are empty.
+    string str(unsigned int r, unsigned int c) const;
+
+    // Numeric fields, ignoring surrounding blanks. These throw KException,
+    // naming the row and column, if the field is missing, empty, or not a number.
+    double real(unsigned int r, unsigned int c) const;
+    int64_t integer(unsigned int r, unsigned int c) const;
+
+  protected:
+    CSVTable();
+    void tokenize(const char* s, size_t n, char sep);
+    const char* textBase() const {
+      return (nullptr != file) ? file->data() : ownText.data();
+    }
+    const char* fieldText(unsigned int r, unsigned int c, size_t & n) const;
+    string numText(unsigned int r, unsigned int c) const;
+
+    // A field either points into the text, or (if it had quotes to
+    // remove) into the list of unquoted copies.
+    struct Field {
+      size_t off;
+      size_t len;
+      int unq; // index into unquoted, or -1
+    };
+
+    std::shared_ptr<MappedFile> file = nullptr;
+    string ownText = ""; // when built from a string
+    vector<Field> fields = {};
+    vector<unsigned int> rowStart = {}; // index into fields of each row's first field
+    vector<string> unquoted = {};
+  };
+
+}; // end of namespace
+
+// -------------------------------------------------
+#endif
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -0,0 +1,265 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// The queue is the bounded multi-producer queue of D. Vyukov: each slot carries
+// a sequence number which says whether it is free for the producer at that
+// position, or full for the consumer at that position. Producers claim a
+// run of positions, one per slot of the message, with one compare-and-swap,
+// so they never block each other and messages are never interleaved;
+// the single consumer needs no atomic read-modify-write at all.
+// -------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstring>
+#include <thread>
+
+#include "klog.h"
+
+namespace KBase {
+
+  namespace {
+    const unsigned int LogSlotLen = 248; // long messages take several consecutive slots
+    const uint64_t LogQueueLen = 4096; // must be a power of 2
+    const uint64_t LogQueueMask = LogQueueLen - 1;
+    const uint64_t LogMaxSlots = LogQueueLen / 8; // longer messages bypass the queue
+
+    struct LogSlot {
+      std::atomic<uint64_t> seq;
+      FILE* dest;
+      unsigned int len;
+      char text[LogSlotLen];
+    };
+
+    class AsyncSink {
+    public:
+      AsyncSink() : head(0), tail(0), done(false), consumer() {
+        for (uint64_t i = 0; i < LogQueueLen; i++) {
+          slots[i].seq.store(i, std::memory_order_relaxed);
+          slots[i].dest = nullptr;
+          slots[i].len = 0;
+        }
+        consumer = std::thread([this]() {
+          drainLoop();
+        });
+      }
+
+      ~AsyncSink() {
+        done.store(true, std::memory_order_release);
+        consumer.join();
+      }
+
+      // Called by any thread. Waits only if the queue is full.
+      // A message's slots are claimed together, so other messages cannot
+      // land between its pieces.
+      void push(FILE* f, const char* s, unsigned int n) {
+        const uint64_t k = (0 == n) ? 1 : (n + LogSlotLen - 1) / LogSlotLen;
+        if (LogMaxSlots < k) {
+          // too big to queue: write it after everything queued so far.
+          // fwrite locks the stream, so it is not split by the consumer.
+          flush();
+          fwrite(s, 1, n, (nullptr == f) ? stdout : f);
+          return;
+        }
+        uint64_t pos = head.load(std::memory_order_relaxed);
+        bool claimed = false;
+        while (!claimed) {
+          // The consumer frees slots in order, so if the last one
+          // is free for this position, all the others are too.
+          const uint64_t seq0 = slots[pos & LogQueueMask].seq.load(std::memory_order_acquire);
+          const uint64_t seqK = slots[(pos + k - 1) & LogQueueMask].seq.load(std::memory_order_acquire);
+          const int64_t dif0 = (int64_t)seq0 - (int64_t)pos;
+          const int64_t difK = (int64_t)seqK - (int64_t)(pos + k - 1);
+          if (0 < dif0) { // another producer got there first
+            pos = head.load(std::memory_order_relaxed);
+          }
+          else if ((dif0 < 0) || (difK < 0)) { // full: let the consumer catch up
+            std::this_thread::yield();
+            pos = head.load(std::memory_order_relaxed);
+          }
+          else {
+            claimed = head.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed);
+          }
+        }
+        for (uint64_t i = 0; i < k; i++) {
+          const unsigned int m = (n < LogSlotLen) ? n : LogSlotLen;
+          LogSlot* slot = &slots[(pos + i) & LogQueueMask];
+          slot->dest = f;
+          slot->len = m;
+          memcpy(slot->text, s, m);
+          slot->seq.store(pos + i + 1, std::memory_order_release);
+          s = s + m;
+          n = n - m;
+        }
+        return;
+      }
+
+      // wait until the consumer has written everything pushed before this call
+      void flush() {
+        const uint64_t target = head.load(std::memory_order_acquire);
+        while (tail.load(std::memory_order_acquire) < target) {
+          std::this_thread::yield();
+        }
+        return;
+      }
+
+    protected:
+      // returns false if there was nothing to write
+      bool popOne() {
+        const uint64_t pos = tail.load(std::memory_order_relaxed);
+        LogSlot* slot = &slots[pos & LogQueueMask];
+        if (slot->seq.load(std::memory_order_acquire) != pos + 1) {
+          return false;
+        }
+        FILE* f = (nullptr == slot->dest) ? stdout : slot->dest;
+        fwrite(slot->text, 1, slot->len, f);
+        slot->seq.store(pos + LogQueueLen, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+
+      void drainLoop() {
+        unsigned int idle = 0;
+        while (true) {
+          if (popOne()) {
+            idle = 0;
+          }
+          else if (done.load(std::memory_order_acquire)) {
+            if (tail.load() == head.load()) {
+              break;
+            }
+          }
+          else {
+            // back off gently, so an idle logger costs almost nothing
+            idle++;
+            if (idle < 64) {
+              std::this_thread::yield();
+            }
+            else {
+              fflush(nullptr);
+              std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+          }
+        }
+        fflush(nullptr);
+        return;
+      }
+
+      LogSlot slots[LogQueueLen];
+      std::atomic<uint64_t> head; // next position for a producer
+      std::atomic<uint64_t> tail; // next position for the consumer
+      std::atomic<bool> done;
+      std::thread consumer;
+    };
+
+    AsyncSink* asyncSink = nullptr;
+    thread_local FILE* tlSink = nullptr;
+
+    // make sure the queue is written out at exit, even if nobody stops it
+    struct SinkCloser {
+      ~SinkCloser() {
+        Logger::setAsync(false);
+      }
+    };
+    SinkCloser sinkCloser;
+  }; // end of anonymous namespace
+
+
+  void Logger::write(const char* s, unsigned int n) {
+    if (nullptr != asyncSink) {
+      asyncSink->push(tlSink, s, n);
+    }
+    else {
+      fwrite(s, 1, n, (nullptr == tlSink) ? stdout : tlSink);
+    }
+    return;
+  }
+
+
+  void Logger::setAsync(bool a) {
+    if (a && (nullptr == asyncSink)) {
+      fflush(nullptr); // earlier, synchronous output goes first
+      asyncSink = new AsyncSink();
+    }
+    if ((!a) && (nullptr != asyncSink)) {
+      delete asyncSink; // waits for the queue to empty
+      asyncSink = nullptr;
+    }
+    return;
+  }
+
+
+  bool Logger::isAsync() {
+    return (nullptr != asyncSink);
+  }
+
+
+  void Logger::setThreadSink(FILE* f) {
+    tlSink = f;
+    return;
+  }
+
+
+  FILE* Logger::threadSink() {
+    return tlSink;
+  }
+
+
+  void Logger::flush() {
+    if (nullptr != asyncSink) {
+      asyncSink->flush();
+    }
+    fflush((nullptr == tlSink) ? stdout : tlSink);
+    return;
+  }
+
+
+  void klogf(const char* fmt, ...) {
+    // most messages fit in the buffer; longer ones get formatted twice
+    char buff[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buff, sizeof(buff), fmt, args);
+    va_end(args);
+    if (n < 0) {
+      return;
+    }
+    if ((unsigned int)n < sizeof(buff)) {
+      Logger::write(buff, n);
+    }
+    else {
+      auto big = new char[n + 1];
+      va_start(args, fmt);
+      vsnprintf(big, n + 1, fmt, args);
+      va_end(args);
+      Logger::write(big, n);
+      delete[] big;
+    }
+    return;
+  }
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
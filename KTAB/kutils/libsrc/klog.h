@@ -0,0 +1,94 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// Logging of the progress messages that used to go straight to stdout.
+//
+// A message is tagged with the ReportingLevel at which it becomes worth showing,
+// and is shown if the caller's ReportingLevel is at least that high. For example,
+// the old test "if (ReportingLevel::Low < rl)" is now KLOG_ON(ReportingLevel::Medium, rl).
+//
+// Messages above KTAB_LOG_MAX_LEVEL are removed at compile time: the test is
+// constant-false, so the compiler drops the whole block. Compile with
+// -DKTAB_LOG_MAX_LEVEL=0 to remove all of them.
+//
+// The arguments of KLOG are not evaluated, nor is anything formatted,
+// unless the message will be shown. Formatted text goes either straight to
+// the sink (the default), or onto a lock-free queue from which a single
+// background thread writes it out, so that threads doing real work never
+// wait on console or file I/O.
+// -------------------------------------------------
+#ifndef KTAB_LOG_H
+#define KTAB_LOG_H
+
+#include <cstdio>
+
+#include "kutils.h"
+
+#ifndef KTAB_LOG_MAX_LEVEL
+#define KTAB_LOG_MAX_LEVEL 4 // i.e. ReportingLevel::Debugging, so nothing is compiled out
+#endif
+
+// is a message at level lvl wanted, when reporting at level rl?
+#define KLOG_ON(lvl, rl) \
+  ((static_cast<int>(lvl) <= KTAB_LOG_MAX_LEVEL) && ((lvl) <= (rl)))
+
+// printf-style message, formatted only if wanted
+#define KLOG(lvl, rl, ...) \
+  do { if (KLOG_ON(lvl, rl)) { KBase::klogf(__VA_ARGS__); } } while (false)
+
+
+namespace KBase {
+
+  // printf to the current thread's sink, unconditionally.
+  void klogf(const char* fmt, ...)
+#ifdef __GNUC__
+    __attribute__((format(printf, 1, 2)))
+#endif
+    ;
+
+  class Logger {
+  public:
+    // Write the text to the current thread's sink (stdout unless set).
+    static void write(const char* s, unsigned int n);
+
+    // Start or stop the background writer. Stopping writes out everything
+    // still queued. Call these only when no other thread is logging.
+    static void setAsync(bool a);
+    static bool isAsync();
+
+    // Send this thread's messages to the given file (nullptr means stdout).
+    // The caller keeps ownership of the file, and must not close it until
+    // after flush().
+    static void setThreadSink(FILE* f);
+    static FILE* threadSink();
+
+    // wait until everything queued so far has been written
+    static void flush();
+  };
+
+}; // end of namespace
+
+// -------------------------------------------------
+#endif
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
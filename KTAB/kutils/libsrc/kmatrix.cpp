@@ -31,14 +31,16 @@
 
 #include "prng.h"
 #include "kmatrix.h"
+#include "klog.h"
 
 
 namespace KBase {
 
-  KMatrix trans(const KMatrix & m1) {
+  template <class T>
+  BasicKMatrix<T> trans(const BasicKMatrix<T> & m1) {
     unsigned int nr2 = m1.numC();
     unsigned int nc2 = m1.numR();
-    auto m2 = KMatrix(nr2, nc2);
+    auto m2 = BasicKMatrix<T>(nr2, nc2);
     for (unsigned int i = 0; i < nr2; i++) {
       for (unsigned int j = 0; j < nc2; j++){
         m2(i, j) = m1(j, i);
@@ -48,42 +50,55 @@ namespace KBase {
   }
 
 
-  double norm(const KMatrix & m1) { 
-    double s = 0.0;
+  template <class T>
+  T norm(const BasicKMatrix<T> & m1) { 
+    T s = 0.0;
     for (auto x : m1) {  s = s + (x*x);   }
     return sqrt(s);
   }
 
 
-  double sum(const KMatrix & m1){ 
-    double s = 0.0;
+  template <class T>
+  T sum(const BasicKMatrix<T> & m1){ 
+    T s = 0.0;
     for (auto x : m1) { s = s + x; }
     return s;
   }
 
 
-  double mean(const KMatrix & m1) { return sum(m1) / (m1.numC()*m1.numR()); }
+  template <class T>
+  T mean(const BasicKMatrix<T> & m1) { return sum(m1) / (m1.numC()*m1.numR()); }
 
 
-  double stdv(const KMatrix & m1) { return norm(m1 - mean(m1)) / sqrt(m1.numR() * m1.numC()); }
+  template <class T>
+  T stdv(const BasicKMatrix<T> & m1) { return norm(m1 - mean(m1)) / sqrt(m1.numR() * m1.numC()); }
 
 
-  double  maxAbs(const KMatrix & m) {
-    double ma = 0;
+  template <class T>
+  T maxAbs(const BasicKMatrix<T> & m) {
+    T ma = 0;
     for (auto x : m) {
-      double a = fabs(x);
+      T a = fabs(x);
       ma = (a > ma) ? a : ma;
     } 
     return ma;
   }
 
-  tuple<unsigned int, unsigned int>  ndxMaxAbs(const KMatrix & m) {
-    double ma = 0;
+  template <class T>
+  uint64_t memBytes(const BasicKMatrix<T> & m) {
+    const unsigned int n = m.numR() * m.numC();
+    const bool onHeap = (BasicKMatrix<T>::InlineLen < n); // otherwise already in the sizeof
+    return sizeof(BasicKMatrix<T>) + (onHeap ? (sizeof(T) * n) : 0);
+  }
+
+  template <class T>
+  tuple<unsigned int, unsigned int>  ndxMaxAbs(const BasicKMatrix<T> & m) {
+    T ma = 0;
     unsigned int ndxI = 1+m.numR(); // mark with obviously wrong value
     unsigned int ndxJ = 1+m.numC(); // mark with obviously wrong value
     for (unsigned int i=0; i<m.numR(); i++) { 
       for (unsigned int j=0; j<m.numC(); j++) {
-	double a = fabs(m(i,j));
+	T a = fabs(m(i,j));
 	if (ma < a) {
 	  ndxI = i;
 	  ndxJ = j;
@@ -104,14 +119,16 @@ namespace KBase {
   // When people say "linear correlation" and "linear model", they usually
   // mean "affine", like Y = aX+b.
   // If you want affine correlation, it is simply lCorr(y-mean(y), x-mean(x))
-  double  lCorr(const KMatrix & m1, const KMatrix & m2) {
+  template <class T>
+  T lCorr(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2) {
     return dot(m1, m2) / sqrt(dot(m1, m1)*dot(m2, m2));
   }
 
 
-  double  dot(const KMatrix & m1, const KMatrix & m2) {
+  template <class T>
+  T dot(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2) {
     assert(sameShape(m1, m2));
-    double s12 = 0;
+    T s12 = 0;
     for (unsigned int i = 0; i < m1.numR(); i++){
       for (unsigned int j = 0; j < m1.numC(); j++) {
         s12 = s12 + m1(i, j)*m2(i, j);
@@ -121,20 +138,46 @@ namespace KBase {
   }
 
 
-  KMatrix::KMatrix() {
+  template <class T>
+  BasicKMatrix<T>::BasicKMatrix() {
     vFillVec(0, 0, 0.0); // totally empty
   }
 
-  KMatrix::~KMatrix() {
+  template <class T>
+  BasicKMatrix<T>::~BasicKMatrix() {
     vFillVec(0, 0, 0.0); // totally empty
   }
 
 
-  KMatrix::KMatrix(unsigned int nr, unsigned int nc, double iv) {
+  template <class T>
+  BasicKMatrix<T>::BasicKMatrix(unsigned int nr, unsigned int nc, T iv) {
     vFillVec(nr, nc, iv);
   }
 
 
+  template <class T>
+  BasicKMatrix<T>::BasicKMatrix(BasicKMatrix && m) noexcept :
+    rows(m.rows), clms(m.clms), vals(std::move(m.vals)) {
+    m.rows = 0;
+    m.clms = 0;
+    m.vals.clear();
+  }
+
+
+  template <class T>
+  BasicKMatrix<T> & BasicKMatrix<T>::operator=(BasicKMatrix && m) noexcept {
+    if (this != &m) {
+      rows = m.rows;
+      clms = m.clms;
+      vals = std::move(m.vals);
+      m.rows = 0;
+      m.clms = 0;
+      m.vals.clear();
+    }
+    return *this;
+  }
+
+
   // if double mv[] = { 11, 12, 13, 21, 22, 23 }, then
   // mArrayInit (mv, 2, 3) yields
   // 11  12  13
@@ -143,8 +186,9 @@ namespace KBase {
   // call does not seem to work easily.
   //
   // You have to make very sure that the mv[] really is of size nr*nc. If not, it just reads in random memory.
-  KMatrix KMatrix::arrayInit(const double mv[], const unsigned int & nr, const unsigned int & nc) {
-    KMatrix m = KMatrix(nr, nc);
+  template <class T>
+  BasicKMatrix<T> BasicKMatrix<T>::arrayInit(const T mv[], const unsigned int & nr, const unsigned int & nc) {
+    BasicKMatrix m = BasicKMatrix(nr, nc);
     for (unsigned int i = 0; i < nr; i++) {
       for (unsigned int j = 0; j < nc; j++) {
         unsigned int n = m.nFromRC(i, j);
@@ -155,25 +199,19 @@ namespace KBase {
   }
 
 
-  void KMatrix::mPrintf(string fs) const {
-    const char * fc = fs.c_str();
-    auto pf = [fc, this](unsigned int i, unsigned int j) {
-      std::printf(fc, (*this)(i, j));
-      if (j == (this->numC() - 1)){
-        std::printf("\n");
-      }
-      return;
-    };
-    mapV(pf, rows, clms);
+  template <class T>
+  void BasicKMatrix<T>::mPrintf(string fs) const {
+    view().mPrintf(fs);
     return;
   }
 
 
-  void KMatrix::vFillVec(unsigned int nr, unsigned int nc, double iv) {
+  template <class T>
+  void BasicKMatrix<T>::vFillVec(unsigned int nr, unsigned int nc, T iv) {
     rows = nr;
     clms = nc;
     const unsigned int n = nr*nc;
-    vals = {}; // 0-length vector
+    vals.clear();
     vals.resize(n);
     for (unsigned int i = 0; i < n; i++) {
       vals[i] = iv;
@@ -182,30 +220,37 @@ namespace KBase {
   }
 
 
-  double KMatrix::operator () (unsigned int i, unsigned int j) const { 
+  template <class T>
+  T BasicKMatrix<T>::operator () (unsigned int i, unsigned int j) const { 
     const unsigned int n = nFromRC(i, j);
     return vals[n]; // rvalue
   }
 
 
-  double& KMatrix::operator() (unsigned int i, unsigned int j){
+  template <class T>
+  T& BasicKMatrix<T>::operator() (unsigned int i, unsigned int j){
     const unsigned int n = nFromRC(i, j);
     return vals[n]; // lvalue
   }
 
 
-  unsigned int KMatrix::numR() const { return rows; }
-  unsigned int KMatrix::numC() const { return clms; }
+  template <class T>
+  unsigned int BasicKMatrix<T>::numR() const { return rows; }
+
+  template <class T>
+  unsigned int BasicKMatrix<T>::numC() const { return clms; }
 
 
-  unsigned int KMatrix::nFromRC(const unsigned int r, const unsigned int c) const {
+  template <class T>
+  unsigned int BasicKMatrix<T>::nFromRC(const unsigned int r, const unsigned int c) const {
     assert(r < rows);
     assert(c < clms);
     return (r*clms + c);
   }
 
 
-  void KMatrix::rcFromN(const unsigned int n, unsigned int & r, unsigned int &c) const {
+  template <class T>
+  void BasicKMatrix<T>::rcFromN(const unsigned int n, unsigned int & r, unsigned int &c) const {
     assert(n < rows*clms);
     r = n / clms;
     c = n - (r*clms);
@@ -215,70 +260,79 @@ namespace KBase {
   }
 
 
-  KMatrix operator+ (const KMatrix & m1, double x) {
+  template <class T>
+  BasicKMatrix<T> operator+ (const BasicKMatrix<T> & m1, Scalar<T> x) {
     auto af = [x, &m1](unsigned int i, unsigned int j) { return m1(i, j) + x; };
-    return KMatrix::map(af, m1.numR(), m1.numC());
+    return BasicKMatrix<T>::map(af, m1.numR(), m1.numC());
   }
 
 
-  KMatrix operator- (const KMatrix & m1, double x) {
+  template <class T>
+  BasicKMatrix<T> operator- (const BasicKMatrix<T> & m1, Scalar<T> x) {
     auto sf = [x, &m1](unsigned int i, unsigned int j) { return m1(i, j) - x; };
-    return KMatrix::map(sf, m1.numR(), m1.numC());
+    return BasicKMatrix<T>::map(sf, m1.numR(), m1.numC());
   }
 
 
-  bool sameShape(const KMatrix & m1, const KMatrix & m2) {
+  template <class T>
+  bool sameShape(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2) {
     const bool sameR = (m1.numR() == m2.numR());
     const bool sameC = (m1.numC() == m2.numC());
     return (sameR && sameC);
   }
 
 
-  KMatrix operator+ (const KMatrix & m1, const KMatrix & m2) {
+  template <class T>
+  BasicKMatrix<T> operator+ (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2) {
     assert(sameShape(m1, m2));
-    auto af = [m1, m2](unsigned int i, unsigned int j) { return m1(i, j) + m2(i, j); };
-    return KMatrix::map(af, m1.numR(), m1.numC());
+    auto af = [&m1, &m2](unsigned int i, unsigned int j) { return m1(i, j) + m2(i, j); };
+    return BasicKMatrix<T>::map(af, m1.numR(), m1.numC());
   }
 
 
-  KMatrix operator- (const KMatrix & m1, const KMatrix & m2) {
+  template <class T>
+  BasicKMatrix<T> operator- (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2) {
     assert(sameShape(m1, m2));
     auto sf = [&m1, &m2](unsigned int i, unsigned int j) { return m1(i, j) - m2(i, j); };
-    return KMatrix::map(sf, m1.numR(), m1.numC());
+    return BasicKMatrix<T>::map(sf, m1.numR(), m1.numC());
   }
 
 
-  KMatrix operator* (double x, const KMatrix & m1) {
+  template <class T>
+  BasicKMatrix<T> operator* (Scalar<T> x, const BasicKMatrix<T> & m1) {
     auto mf = [x, &m1](unsigned int i, unsigned int j) { return x*m1(i, j); };
-    return KMatrix::map(mf, m1.numR(), m1.numC());
+    return BasicKMatrix<T>::map(mf, m1.numR(), m1.numC());
   }
 
 
-  KMatrix operator/ (const KMatrix & m1, double x) {
+  template <class T>
+  BasicKMatrix<T> operator/ (const BasicKMatrix<T> & m1, Scalar<T> x) {
     auto df = [x, &m1](unsigned int i, unsigned int j) { return m1(i, j) / x; };
-    return KMatrix::map(df, m1.numR(), m1.numC());
+    return BasicKMatrix<T>::map(df, m1.numR(), m1.numC());
   }
 
 
-  KMatrix operator* (const KMatrix & m1, const KMatrix & m2) {
+  template <class T>
+  BasicKMatrix<T> operator* (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2) {
     const unsigned int nr3 = m1.numR();
     const unsigned int nm3 = m1.numC();
     assert(nm3 == m2.numR());
     const unsigned int nc3 = m2.numC();
     auto f = [nm3, &m1, &m2](unsigned int i, unsigned int j) {
-      double sij = 0.0;
+      T sij = 0.0;
       for (unsigned int k = 0; k < nm3; k++){
         sij = sij + m1(i, k)*m2(k, j);
       }
       return sij;
     };
-    return KMatrix::map(f, nr3, nc3);
+    return BasicKMatrix<T>::map(f, nr3, nc3);
   }
 
 
-  KMatrix KMatrix::map(function<double(unsigned int i, unsigned int j)> f, unsigned int nr, unsigned int nc) {
+  template <class T>
+  BasicKMatrix<T> BasicKMatrix<T>::map(function<T(unsigned int i, unsigned int j)> f, unsigned int nr, unsigned int nc) {
     assert (f != nullptr);
-    auto m = KMatrix(nr, nc);
+    auto m = BasicKMatrix(nr, nc);
     for (unsigned int i = 0; i < nr; i++){
       for (unsigned int j = 0; j < nc; j++){
         m(i, j) = f(i, j);
@@ -288,7 +342,23 @@ namespace KBase {
   }
 
 
-  void KMatrix::mapV(function<void(unsigned int i, unsigned int j)> f, unsigned int nr, unsigned int nc) {
+  template <class T>
+  BasicKMatrix<T> BasicKMatrix<T>::map(function<T(T x)> f, const BasicKCView<T> & v) {
+    assert (f != nullptr);
+    const unsigned int nr = v.numR();
+    const unsigned int nc = v.numC();
+    auto m = BasicKMatrix(nr, nc);
+    for (unsigned int i = 0; i < nr; i++) {
+      for (unsigned int j = 0; j < nc; j++) {
+        m(i, j) = f(v(i, j));
+      }
+    }
+    return m;
+  }
+
+
+  template <class T>
+  void BasicKMatrix<T>::mapV(function<void(unsigned int i, unsigned int j)> f, unsigned int nr, unsigned int nc) {
     assert (f != nullptr);
     for (unsigned int i = 0; i < nr; i++){
       for (unsigned int j = 0; j < nc; j++){
@@ -299,18 +369,20 @@ namespace KBase {
   }
 
 
-  KMatrix KMatrix::uniform(PRNG* rng, unsigned int nr, unsigned int nc, double a, double b) {
-    auto rf = [rng, a, b](unsigned int, unsigned int) {return rng->uniform(a, b); };
+  template <class T>
+  BasicKMatrix<T> BasicKMatrix<T>::uniform(PRNG* rng, unsigned int nr, unsigned int nc, double a, double b) {
+    auto rf = [rng, a, b](unsigned int, unsigned int) {return (T)(rng->uniform(a, b)); };
     return map(rf, nr, nc);
   }
 
 
-  void KMatrix::pivot(unsigned int r, unsigned int c){
+  template <class T>
+  void BasicKMatrix<T>::pivot(unsigned int r, unsigned int c){
     auto x = [this](unsigned int i, unsigned int j) {
       return vals[nFromRC(i, j)];
     };
-    double xrc = x(r, c);
-    double xrcAbs = fabs(xrc); 
+    T xrc = x(r, c);
+    T xrcAbs = fabs(xrc); 
     const double minPivot = 1E-8;
     assert(xrcAbs > minPivot); // nearly-singular?
     
@@ -318,7 +390,7 @@ namespace KBase {
     for (unsigned int i = 0; i < rows; i++){
       for (unsigned int j = 0; j < clms; j++){
         if ((r != i) && (c != j)){
-          double vij = x(i, j) - (x(i, c)*x(r, j)) / xrc;
+          T vij = x(i, j) - (x(i, c)*x(r, j)) / xrc;
           (*this)(i, j) = vij;
         }
       }
@@ -327,7 +399,7 @@ namespace KBase {
     // pivot the main row
     for (unsigned int j = 0; j < clms; j++) {
       if (c != j){
-        double vrj = x(r, j) / xrc;
+        T vrj = x(r, j) / xrc;
         (*this)(r, j) = vrj;
       }
     }
@@ -345,11 +417,12 @@ namespace KBase {
   }
 
   // textbook algorithm
-  KMatrix inv(const KMatrix & m) {
+  template <class T>
+  BasicKMatrix<T> inv(const BasicKMatrix<T> & m) {
     const unsigned int n = m.numR();
     assert(n == m.numC());
 
-    KMatrix m2 = joinH(KMatrix(m), iMat(n));
+    BasicKMatrix<T> m2 = joinH(m, iMat<T>(n));
     auto ok = vector<bool>();
     ok.resize(n);
     for (unsigned int i = 0; i < n; i++){
@@ -357,12 +430,12 @@ namespace KBase {
     }
     
     for (unsigned int iter = 0; iter < n; iter++) {
-      double maxD = -1;
+      T maxD = -1;
       unsigned int pk = 0;
       for (unsigned int k = 0; k < n; k++){
         if (ok[k]) {
-          const double mk = m2(k,k); 
-          const double pe = fabs(mk); 
+          const T mk = m2(k,k); 
+          const T pe = fabs(mk); 
           if (pe > maxD) {
             maxD = pe;
             pk = k;
@@ -374,7 +447,7 @@ namespace KBase {
       ok[pk] = false;
     }
 
-    auto m3 = KMatrix(n, n);
+    auto m3 = BasicKMatrix<T>(n, n);
     for (unsigned int i = 0; i < n; i++){
       for (unsigned int j = 0; j < n; j++) {
         m3(i, j) = m2(i, n + j);
@@ -384,8 +457,9 @@ namespace KBase {
   }
 
 
-  KMatrix iMat(unsigned int n) {
-    auto idm = KMatrix(n, n);
+  template <class T>
+  BasicKMatrix<T> iMat(unsigned int n) {
+    auto idm = BasicKMatrix<T>(n, n);
     for (unsigned int i = 0; i < n; i++){
       idm(i, i) = 1;
     }
@@ -393,18 +467,20 @@ namespace KBase {
   }
 
   // return y to min |y-x| s.t. perpendicular(y,p)
-  KMatrix makePerp(const KMatrix & x, const KMatrix & p) {
-    double lambda = dot(x,p) / dot(p,p);
+  template <class T>
+  BasicKMatrix<T> makePerp(const BasicKMatrix<T> & x, const BasicKMatrix<T> & p) {
+    T lambda = dot(x,p) / dot(p,p);
     auto y = x - lambda*p;
     return y;
   }
 
-  KMatrix  joinH(const KMatrix & mL, const KMatrix & mR) {
+  template <class T>
+  BasicKMatrix<T> joinH(const BasicKMatrix<T> & mL, const BasicKMatrix<T> & mR) {
     unsigned int nr3 = mL.numR();
     unsigned int nc1 = mL.numC();
     assert(nr3 == mR.numR());
     unsigned int nc2 = mR.numC();
-    auto m3 = KMatrix(nr3, nc1 + nc2);
+    auto m3 = BasicKMatrix<T>(nr3, nc1 + nc2);
     for (unsigned int i = 0; i < nr3; i++){
       for (unsigned int j = 0; j < nc1; j++){
         m3(i, j) = mL(i, j); 
@@ -417,12 +493,13 @@ namespace KBase {
   }
 
 
-  KMatrix  joinV(const KMatrix & mT, const KMatrix & mB) {
+  template <class T>
+  BasicKMatrix<T> joinV(const BasicKMatrix<T> & mT, const BasicKMatrix<T> & mB) {
     unsigned int nr1 = mT.numR();
     unsigned int nr2 = mB.numR();
     unsigned int nc3 = mT.numC();
     assert(nc3 == mB.numC());
-    auto m3 = KMatrix(nr1 + nr2, nc3);
+    auto m3 = BasicKMatrix<T>(nr1 + nr2, nc3);
     for (unsigned int j = 0; j < nc3; j++) {
       for (unsigned int i = 0; i < nr1; i++) {
         m3(i, j) = mT(i, j); 
@@ -434,6 +511,260 @@ namespace KBase {
     return m3;
   }
 
+  // -------------------------------------------------
+
+  template <class T>
+  BasicKMatrix<T>::BasicKMatrix(const BasicKCView<T> & v) {
+    vFillVec(v.numR(), v.numC(), 0.0);
+    for (unsigned int i = 0; i < rows; i++) {
+      for (unsigned int j = 0; j < clms; j++) {
+        vals[nFromRC(i, j)] = v(i, j);
+      }
+    }
+  }
+
+  template <class T>
+  BasicKCView<T> BasicKMatrix<T>::view() const { return BasicKCView<T>(vals.data(), rows, clms, clms, 1); }
+
+  template <class T>
+  BasicKView<T> BasicKMatrix<T>::view() { return BasicKView<T>(vals.data(), rows, clms, clms, 1); }
+
+  template <class T>
+  BasicKCView<T> BasicKMatrix<T>::row(unsigned int i) const { return view().row(i); }
+
+  template <class T>
+  BasicKView<T> BasicKMatrix<T>::row(unsigned int i) { return view().row(i); }
+
+  template <class T>
+  BasicKCView<T> BasicKMatrix<T>::clm(unsigned int j) const { return view().clm(j); }
+
+  template <class T>
+  BasicKView<T> BasicKMatrix<T>::clm(unsigned int j) { return view().clm(j); }
+
+  template <class T>
+  BasicKCView<T> BasicKMatrix<T>::tView() const { return view().trans(); }
+
+  template <class T>
+  BasicKCView<T> BasicKMatrix<T>::block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc) const {
+    return view().block(r0, c0, nr, nc);
+  }
+
+  template <class T>
+  BasicKView<T> BasicKMatrix<T>::block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc) {
+    return view().block(r0, c0, nr, nc);
+  }
+
+
+  template <class T>
+  BasicKCView<T>::BasicKCView(const T* b, unsigned int nr, unsigned int nc,
+                                     unsigned int rs, unsigned int cs) :
+    base(b), rows(nr), clms(nc), rStride(rs), cStride(cs) {}
+
+  template <class T>
+  BasicKCView<T>::BasicKCView(const BasicKMatrix<T> & m) : BasicKCView(m.view()) {}
+
+  template <class T>
+  BasicKCView<T> BasicKCView<T>::row(unsigned int i) const {
+    assert(i < rows);
+    return BasicKCView(base + i*rStride, 1, clms, rStride, cStride);
+  }
+
+  template <class T>
+  BasicKCView<T> BasicKCView<T>::clm(unsigned int j) const {
+    assert(j < clms);
+    return BasicKCView(base + j*cStride, rows, 1, rStride, cStride);
+  }
+
+  template <class T>
+  BasicKCView<T> BasicKCView<T>::block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc) const {
+    assert(r0 + nr <= rows);
+    assert(c0 + nc <= clms);
+    return BasicKCView(base + r0*rStride + c0*cStride, nr, nc, rStride, cStride);
+  }
+
+  template <class T>
+  BasicKCView<T> BasicKCView<T>::trans() const {
+    return BasicKCView(base, clms, rows, cStride, rStride);
+  }
+
+  template <class T>
+  void BasicKCView<T>::mPrintf(string fs) const {
+    // one write per row, so that rows from different threads do not get mixed
+    const char * fc = fs.c_str();
+    char buff[100];
+    string row = "";
+    for (unsigned int i = 0; i < rows; i++) {
+      row.clear();
+      for (unsigned int j = 0; j < clms; j++) {
+        int n = snprintf(buff, sizeof(buff), fc, (*this)(i, j));
+        row.append(buff, (n < (int)sizeof(buff)) ? n : sizeof(buff) - 1);
+      }
+      row.append("\n");
+      Logger::write(row.c_str(), row.length());
+    }
+    return;
+  }
+
+
+  template <class T>
+  BasicKView<T>::BasicKView(T* b, unsigned int nr, unsigned int nc,
+                         unsigned int rs, unsigned int cs) :
+    base(b), rows(nr), clms(nc), rStride(rs), cStride(cs) {}
+
+  template <class T>
+  BasicKView<T>::BasicKView(BasicKMatrix<T> & m) : BasicKView(m.view()) {}
+
+  template <class T>
+  BasicKView<T> BasicKView<T>::row(unsigned int i) const {
+    assert(i < rows);
+    return BasicKView(base + i*rStride, 1, clms, rStride, cStride);
+  }
+
+  template <class T>
+  BasicKView<T> BasicKView<T>::clm(unsigned int j) const {
+    assert(j < clms);
+    return BasicKView(base + j*cStride, rows, 1, rStride, cStride);
+  }
+
+  template <class T>
+  BasicKView<T> BasicKView<T>::block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc) const {
+    assert(r0 + nr <= rows);
+    assert(c0 + nc <= clms);
+    return BasicKView(base + r0*rStride + c0*cStride, nr, nc, rStride, cStride);
+  }
+
+  template <class T>
+  BasicKView<T> BasicKView<T>::trans() const {
+    return BasicKView(base, clms, rows, cStride, rStride);
+  }
+
+  template <class T>
+  void BasicKView<T>::fill(T x) {
+    for (unsigned int i = 0; i < rows; i++) {
+      for (unsigned int j = 0; j < clms; j++) {
+        (*this)(i, j) = x;
+      }
+    }
+    return;
+  }
+
+  // Note that if v overlaps this view (e.g. its transpose), the result depends on the order of copying.
+  template <class T>
+  void BasicKView<T>::assign(const BasicKCView<T> & v) {
+    assert(rows == v.numR());
+    assert(clms == v.numC());
+    for (unsigned int i = 0; i < rows; i++) {
+      for (unsigned int j = 0; j < clms; j++) {
+        (*this)(i, j) = v(i, j);
+      }
+    }
+    return;
+  }
+
+  template <class T>
+  void BasicKView<T>::mPrintf(string fs) const {
+    BasicKCView<T>(*this).mPrintf(fs);
+    return;
+  }
+
+
+  template <class T>
+  T norm(const BasicKCView<T> & v) {
+    T s = 0.0;
+    for (unsigned int i = 0; i < v.numR(); i++) {
+      for (unsigned int j = 0; j < v.numC(); j++) {
+        s = s + v(i, j)*v(i, j);
+      }
+    }
+    return sqrt(s);
+  }
+
+  template <class T>
+  T sum(const BasicKCView<T> & v) {
+    T s = 0.0;
+    for (unsigned int i = 0; i < v.numR(); i++) {
+      for (unsigned int j = 0; j < v.numC(); j++) {
+        s = s + v(i, j);
+      }
+    }
+    return s;
+  }
+
+  template <class T>
+  T maxAbs(const BasicKCView<T> & v) {
+    T ma = 0;
+    for (unsigned int i = 0; i < v.numR(); i++) {
+      for (unsigned int j = 0; j < v.numC(); j++) {
+        T a = fabs(v(i, j));
+        ma = (a > ma) ? a : ma;
+      }
+    }
+    return ma;
+  }
+
+  template <class T>
+  T dot(const BasicKCView<T> & v1, const BasicKCView<T> & v2) {
+    assert(sameShape(v1, v2));
+    T s12 = 0;
+    for (unsigned int i = 0; i < v1.numR(); i++) {
+      for (unsigned int j = 0; j < v1.numC(); j++) {
+        s12 = s12 + v1(i, j)*v2(i, j);
+      }
+    }
+    return s12;
+  }
+
+  template <class T>
+  bool sameShape(const BasicKCView<T> & v1, const BasicKCView<T> & v2) {
+    return ((v1.numR() == v2.numR()) && (v1.numC() == v2.numC()));
+  }
+
+  // -------------------------------------------------
+  // The only element types we need. Adding another (e.g. long double)
+  // takes just one more line here.
+
+  template class BasicKMatrix<double>;
+  template class BasicKMatrix<float>;
+  template class BasicKCView<double>;
+  template class BasicKCView<float>;
+  template class BasicKView<double>;
+  template class BasicKView<float>;
+
+#define KTAB_KMATRIX_FNS(T) \
+  template BasicKMatrix<T> trans(const BasicKMatrix<T> & m); \
+  template T norm(const BasicKMatrix<T> & m); \
+  template T sum(const BasicKMatrix<T> & m); \
+  template T mean(const BasicKMatrix<T> & m); \
+  template T stdv(const BasicKMatrix<T> & m); \
+  template T maxAbs(const BasicKMatrix<T> & m); \
+  template uint64_t memBytes(const BasicKMatrix<T> & m); \
+  template tuple<unsigned int, unsigned int> ndxMaxAbs(const BasicKMatrix<T> & m); \
+  template T dot(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2); \
+  template T lCorr(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2); \
+  template BasicKMatrix<T> inv(const BasicKMatrix<T> & m); \
+  template BasicKMatrix<T> iMat(unsigned int n); \
+  template BasicKMatrix<T> makePerp(const BasicKMatrix<T> & x, const BasicKMatrix<T> & p); \
+  template BasicKMatrix<T> joinH(const BasicKMatrix<T> & mL, const BasicKMatrix<T> & mR); \
+  template BasicKMatrix<T> joinV(const BasicKMatrix<T> & mT, const BasicKMatrix<T> & mB); \
+  template BasicKMatrix<T> operator+ (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2); \
+  template BasicKMatrix<T> operator+ (const BasicKMatrix<T> & m1, Scalar<T> x); \
+  template BasicKMatrix<T> operator- (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2); \
+  template BasicKMatrix<T> operator- (const BasicKMatrix<T> & m1, Scalar<T> x); \
+  template BasicKMatrix<T> operator* (Scalar<T> x, const BasicKMatrix<T> & m1); \
+  template BasicKMatrix<T> operator/ (const BasicKMatrix<T> & m1, Scalar<T> x); \
+  template bool sameShape(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2); \
+  template BasicKMatrix<T> operator* (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2); \
+  template T norm(const BasicKCView<T> & v); \
+  template T sum(const BasicKCView<T> & v); \
+  template T maxAbs(const BasicKCView<T> & v); \
+  template T dot(const BasicKCView<T> & v1, const BasicKCView<T> & v2); \
+  template bool sameShape(const BasicKCView<T> & v1, const BasicKCView<T> & v2);
+
+  KTAB_KMATRIX_FNS(double)
+  KTAB_KMATRIX_FNS(float)
+
+#undef KTAB_KMATRIX_FNS
+
 } // end of namespace
 
 // --------------------------------------------
@@ -33,84 +33,225 @@
 #include <cstdint>
 #include <functional> 
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "kutils.h"
+#include "smallvec.h"
 
 namespace KBase { 
   
   using std::function;
   using std::tuple;
 
-  class KMatrix;
+  // The element type is a template parameter, so the same code serves double
+  // (KMatrix, used everywhere) and float (KMatrixF, for exploratory runs where
+  // half the memory and twice the SIMD width matter more than the last digits).
+  // Only these two are instantiated, in kmatrix.cpp.
+  template <class T> class BasicKMatrix;
+  template <class T> class BasicKCView;
+  template <class T> class BasicKView;
   class PRNG;
 
-  KMatrix trans(const KMatrix & m);
-  double  norm(const KMatrix & m);
-  double  sum(const KMatrix & m);
-  double  mean(const KMatrix & m);
-  double  stdv(const KMatrix & m);
-  double  maxAbs(const KMatrix & m);
-  tuple<unsigned int, unsigned int>  ndxMaxAbs(const KMatrix & m);
-  double  dot(const KMatrix & m1, const KMatrix & m2);
-  double  lCorr(const KMatrix & m1, const KMatrix & m2);
-  KMatrix  inv(const KMatrix & m);
-  KMatrix iMat(unsigned int n);
-  KMatrix makePerp(const KMatrix & x, const KMatrix & p);
-  KMatrix  joinH(const KMatrix & mL, const KMatrix & mR);
-  KMatrix  joinV(const KMatrix & mT, const KMatrix & mB);
-  KMatrix operator+ (const KMatrix & m1, const KMatrix & m2);
-  KMatrix operator+ (const KMatrix & m1, double x);
-  KMatrix operator- (const KMatrix & m1, const KMatrix & m2);
-  KMatrix operator- (const KMatrix & m1, double x);
-  KMatrix operator* (double x, const KMatrix & m1);
-  KMatrix operator/ (const KMatrix & m1, double x);
-  bool sameShape(const KMatrix & m1, const KMatrix & m2);
-  KMatrix operator* (const KMatrix & m1, const KMatrix & m2);
-
-
-  class KMatrix {
-    friend KMatrix  inv(const KMatrix & m);
+  typedef BasicKMatrix<double> KMatrix;
+  typedef BasicKCView<double> KCView;
+  typedef BasicKView<double> KView;
+
+  typedef BasicKMatrix<float> KMatrixF;
+  typedef BasicKCView<float> KCViewF;
+  typedef BasicKView<float> KViewF;
+
+  // Scalar arguments are of the non-deduced type Scalar<T>, so that
+  // m/n or 2*m work with the usual arithmetic conversions.
+  template <class T> using Scalar = typename BasicKMatrix<T>::value_type;
+
+  template <class T> BasicKMatrix<T> trans(const BasicKMatrix<T> & m);
+  template <class T> T norm(const BasicKMatrix<T> & m);
+  template <class T> T sum(const BasicKMatrix<T> & m);
+  template <class T> T mean(const BasicKMatrix<T> & m);
+  template <class T> T stdv(const BasicKMatrix<T> & m);
+  template <class T> T maxAbs(const BasicKMatrix<T> & m);
+  template <class T> uint64_t memBytes(const BasicKMatrix<T> & m); // the object plus its elements
+  template <class T> tuple<unsigned int, unsigned int>  ndxMaxAbs(const BasicKMatrix<T> & m);
+  template <class T> T dot(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2);
+  template <class T> T lCorr(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2);
+  template <class T> BasicKMatrix<T> inv(const BasicKMatrix<T> & m);
+  template <class T = double> BasicKMatrix<T> iMat(unsigned int n);
+  template <class T> BasicKMatrix<T> makePerp(const BasicKMatrix<T> & x, const BasicKMatrix<T> & p);
+  template <class T> BasicKMatrix<T> joinH(const BasicKMatrix<T> & mL, const BasicKMatrix<T> & mR);
+  template <class T> BasicKMatrix<T> joinV(const BasicKMatrix<T> & mT, const BasicKMatrix<T> & mB);
+  template <class T> BasicKMatrix<T> operator+ (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2);
+  template <class T> BasicKMatrix<T> operator+ (const BasicKMatrix<T> & m1, Scalar<T> x);
+  template <class T> BasicKMatrix<T> operator- (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2);
+  template <class T> BasicKMatrix<T> operator- (const BasicKMatrix<T> & m1, Scalar<T> x);
+  template <class T> BasicKMatrix<T> operator* (Scalar<T> x, const BasicKMatrix<T> & m1);
+  template <class T> BasicKMatrix<T> operator/ (const BasicKMatrix<T> & m1, Scalar<T> x);
+  template <class T> bool sameShape(const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2);
+  template <class T> BasicKMatrix<T> operator* (const BasicKMatrix<T> & m1, const BasicKMatrix<T> & m2);
+
+  // the same reductions over views, so rows, columns and blocks need not be copied
+  template <class T> T norm(const BasicKCView<T> & v);
+  template <class T> T sum(const BasicKCView<T> & v);
+  template <class T> T maxAbs(const BasicKCView<T> & v);
+  template <class T> T dot(const BasicKCView<T> & v1, const BasicKCView<T> & v2);
+  template <class T> bool sameShape(const BasicKCView<T> & v1, const BasicKCView<T> & v2);
+
+
+  // A view refers to the elements of a KMatrix without owning or copying them:
+  // the whole matrix, one row or column, a rectangular block, or the transpose
+  // of any of these. Element (i,j) of a view is base[i*rStride + j*cStride],
+  // so a transpose just swaps the strides.
+  //
+  // A view is valid only while its matrix is alive and keeps its shape;
+  // assigning to the matrix, or moving from it, leaves the view dangling.
+  // In particular, do not keep a view of a temporary, e.g. KCView v = a + b;
+  template <class T>
+  class BasicKCView {
+  public:
+    BasicKCView(const T* b, unsigned int nr, unsigned int nc,
+                unsigned int rs, unsigned int cs);
+    BasicKCView(const BasicKMatrix<T> & m); // the whole matrix; implicit, so a KMatrix can be passed as a view
+    T operator() (unsigned int i, unsigned int j) const {
+      return base[i*rStride + j*cStride];
+    };
+    unsigned int numR() const { return rows; };
+    unsigned int numC() const { return clms; };
+    BasicKCView row(unsigned int i) const;
+    BasicKCView clm(unsigned int j) const;
+    BasicKCView block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc) const;
+    BasicKCView trans() const;
+    void mPrintf(string fs) const;
+
+  protected:
+    const T* base = nullptr;
+    unsigned int rows = 0;
+    unsigned int clms = 0;
+    unsigned int rStride = 0;
+    unsigned int cStride = 0;
+  };
+
+
+  // As KCView, but the elements can be assigned through it.
+  template <class T>
+  class BasicKView {
+  public:
+    BasicKView(T* b, unsigned int nr, unsigned int nc,
+               unsigned int rs, unsigned int cs);
+    BasicKView(BasicKMatrix<T> & m);
+    operator BasicKCView<T>() const { return BasicKCView<T>(base, rows, clms, rStride, cStride); };
+    T operator() (unsigned int i, unsigned int j) const {
+      return base[i*rStride + j*cStride];
+    };
+    T& operator() (unsigned int i, unsigned int j) {
+      return base[i*rStride + j*cStride];
+    };
+    unsigned int numR() const { return rows; };
+    unsigned int numC() const { return clms; };
+    BasicKView row(unsigned int i) const;
+    BasicKView clm(unsigned int j) const;
+    BasicKView block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc) const;
+    BasicKView trans() const;
+    void fill(T x);
+    void assign(const BasicKCView<T> & v); // copy v's elements in; the shapes must match
+    void mPrintf(string fs) const;
+
+  protected:
+    T* base = nullptr;
+    unsigned int rows = 0;
+    unsigned int clms = 0;
+    unsigned int rStride = 0;
+    unsigned int cStride = 0;
+  };
+
+
+  template <class T>
+  class BasicKMatrix {
+    template <class U> friend BasicKMatrix<U> inv(const BasicKMatrix<U> & m);
   public:
+    typedef T value_type;
+
+    BasicKMatrix();
+    BasicKMatrix(unsigned int nr, unsigned int nc, T iv=0.0);
 
-    KMatrix();
-    KMatrix(unsigned int nr, unsigned int nc, double iv=0.0);
-    // default copy constructor, copy assigment, etc. are sufficient 
-    double operator() (unsigned int i, unsigned int j) const;  // readable rvalue
-    double& operator() (unsigned int i, unsigned int j);       // assignable lvalue
+    // Copies are deep. Declaring the virtual destructor suppresses the implicit
+    // moves, so they are declared here: moving just takes over the elements,
+    // and leaves the source an empty 0-by-0 matrix.
+    BasicKMatrix(const BasicKMatrix & m) = default;
+    BasicKMatrix(BasicKMatrix && m) noexcept;
+    BasicKMatrix & operator=(const BasicKMatrix & m) = default;
+    BasicKMatrix & operator=(BasicKMatrix && m) noexcept;
+
+    explicit BasicKMatrix(const BasicKCView<T> & v); // copy the elements of the view
+
+    // convert between element types, e.g. KMatrixF(m) rounds a KMatrix to float
+    template <class U>
+    explicit BasicKMatrix(const BasicKMatrix<U> & m) : rows(m.numR()), clms(m.numC()), vals() {
+      vals.reserve(rows*clms);
+      for (auto x : m) {
+        vals.push_back((T)x);
+      }
+    };
+
+    T operator() (unsigned int i, unsigned int j) const;  // readable rvalue
+    T& operator() (unsigned int i, unsigned int j);       // assignable lvalue
     void mPrintf(string) const;
     unsigned int numR() const;
     unsigned int numC() const;
-    static KMatrix uniform(PRNG* rng, unsigned int nr, unsigned int nc, double a, double b);
-    static KMatrix map(function<double(unsigned int i, unsigned int j)> f, unsigned int nr, unsigned int nc);
+    static BasicKMatrix uniform(PRNG* rng, unsigned int nr, unsigned int nc, double a, double b);
+    static BasicKMatrix map(function<T(unsigned int i, unsigned int j)> f, unsigned int nr, unsigned int nc);
+    static BasicKMatrix map(function<T(T x)> f, const BasicKCView<T> & v); // f applied to each element of v
     static void mapV(function<void(unsigned int i, unsigned int j)> f, unsigned int nr, unsigned int nc);
     
-    static KMatrix arrayInit(const double mv[], const unsigned int & rows, const unsigned int & clms);
+    static BasicKMatrix arrayInit(const T mv[], const unsigned int & rows, const unsigned int & clms);
+
+    // non-owning views: see KCView
+    BasicKCView<T> view() const;
+    BasicKView<T> view();
+    BasicKCView<T> row(unsigned int i) const;
+    BasicKView<T> row(unsigned int i);
+    BasicKCView<T> clm(unsigned int j) const;
+    BasicKView<T> clm(unsigned int j);
+    BasicKCView<T> block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc) const;
+    BasicKView<T> block(unsigned int r0, unsigned int c0, unsigned int nr, unsigned int nc);
+    BasicKCView<T> tView() const; // the transpose, without copying
+
+    // The elements, row by row, for kernels that want a plain array
+    const T* data() const { return vals.data(); };
+    T* data() { return vals.data(); };
 
     // For those rare cases when we do not need explicit indices inside the loop, 
     // the standard C++11 iterators are provided to support range-for
-    vector<double>::iterator begin()  { return vals.begin(); };
-    vector<double>::iterator end() { return vals.end(); };
-    vector<double>::const_iterator cbegin() { return vals.cbegin(); };
-    vector<double>::const_iterator cend() { return vals.cend(); };
-    vector<double>::const_iterator begin() const { return vals.begin(); };
-    vector<double>::const_iterator end() const { return vals.end(); };
+    T* begin()  { return vals.begin(); };
+    T* end() { return vals.end(); };
+    const T* cbegin() { return vals.cbegin(); };
+    const T* cend() { return vals.cend(); };
+    const T* begin() const { return vals.begin(); };
+    const T* end() const { return vals.end(); };
+
+    // Up to this many elements are stored inside the matrix object itself,
+    // so small matrices (e.g. most positions) never touch the heap.
+    static const unsigned int InlineLen = 8;
     
-    virtual ~KMatrix();
+    virtual ~BasicKMatrix();
 
   protected:
     unsigned int rows = 0;
     unsigned int clms = 0;
-    vector<double> vals = vector<double>();
+    SmallVec<T, InlineLen> vals = SmallVec<T, InlineLen>();
     
   private:
-    void vFillVec(unsigned int nr, unsigned int nv, double iv);
+    void vFillVec(unsigned int nr, unsigned int nv, T iv);
     void pivot(unsigned int r, unsigned int c);
     inline unsigned int nFromRC(const unsigned int r, const unsigned int c) const;
     void rcFromN(const unsigned int n, unsigned int & r, unsigned int &c) const;
   };
 
-
+  extern template class BasicKMatrix<double>;
+  extern template class BasicKMatrix<float>;
+  extern template class BasicKCView<double>;
+  extern template class BasicKCView<float>;
+  extern template class BasicKView<double>;
+  extern template class BasicKView<float>;
 
 };
 
@@ -0,0 +1,290 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+
+#include <mutex>
+
+#include "kprof.h"
+
+namespace KBase {
+
+  using std::cout;
+  using std::endl;
+  using std::flush;
+
+  namespace {
+    // The owning thread is the only writer, so plain load/store of relaxed
+    // atomics is enough: readers in other threads just see recent totals.
+    struct ThreadProf {
+      unsigned int ordinal = 0;
+      std::atomic<uint64_t> calls[Profiler::MaxProbes];
+      std::atomic<uint64_t> nsec[Profiler::MaxProbes];
+      std::atomic<uint64_t> allocs[Profiler::MaxProbes];
+
+      explicit ThreadProf(unsigned int n) : ordinal(n) {
+        for (unsigned int i = 0; i < Profiler::MaxProbes; i++) {
+          calls[i].store(0, std::memory_order_relaxed);
+          nsec[i].store(0, std::memory_order_relaxed);
+          allocs[i].store(0, std::memory_order_relaxed);
+        }
+      }
+
+      ProbeStats stats(unsigned int np) const {
+        auto ps = ProbeStats(np);
+        for (unsigned int i = 0; i < np; i++) {
+          ps[i].calls = calls[i].load(std::memory_order_relaxed);
+          ps[i].nsec = nsec[i].load(std::memory_order_relaxed);
+          ps[i].allocs = allocs[i].load(std::memory_order_relaxed);
+        }
+        return ps;
+      }
+    };
+
+    struct Registry {
+      Registry() : mtx(), names(), threads(), retired(Profiler::MaxProbes), nextOrdinal(1) {}
+      std::mutex mtx;
+      vector<string> names;
+      vector<ThreadProf*> threads;
+      ProbeStats retired; // from threads which have finished
+      unsigned int nextOrdinal; // 0 is the row of finished threads
+    };
+
+    Registry& registry() {
+      static Registry r;
+      return r;
+    }
+
+    // the thread's block is created when it first records anything,
+    // and folded into the retired totals when the thread ends
+    struct ThreadHolder {
+      ThreadProf* tp = nullptr;
+      ~ThreadHolder() {
+        if (nullptr != tp) {
+          auto& r = registry();
+          std::lock_guard<std::mutex> lk(r.mtx);
+          auto ps = tp->stats(Profiler::MaxProbes);
+          for (unsigned int i = 0; i < Profiler::MaxProbes; i++) {
+            r.retired[i].calls += ps[i].calls;
+            r.retired[i].nsec += ps[i].nsec;
+            r.retired[i].allocs += ps[i].allocs;
+          }
+          for (unsigned int i = 0; i < r.threads.size(); i++) {
+            if (tp == r.threads[i]) {
+              r.threads.erase(r.threads.begin() + i);
+              break;
+            }
+          }
+          delete tp;
+          tp = nullptr;
+        }
+      }
+    };
+
+    thread_local ThreadHolder tlHolder;
+    thread_local uint64_t tlAllocs = 0; // trivial, so it is safe to use inside operator new
+
+    ThreadProf* threadProf() {
+      if (nullptr == tlHolder.tp) {
+        auto& r = registry();
+        std::lock_guard<std::mutex> lk(r.mtx);
+        tlHolder.tp = new ThreadProf(r.nextOrdinal);
+        r.nextOrdinal++;
+        r.threads.push_back(tlHolder.tp);
+      }
+      return tlHolder.tp;
+    }
+
+    void bump(std::atomic<uint64_t> & a, uint64_t x) {
+      a.store(a.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+      return;
+    }
+  }; // end of anonymous namespace
+
+
+  std::atomic<bool> Profiler::on(false);
+
+
+  unsigned int Profiler::probeID(const string & name) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lk(r.mtx);
+    for (unsigned int i = 0; i < r.names.size(); i++) {
+      if (name == r.names[i]) {
+        return i;
+      }
+    }
+    if (MaxProbes <= r.names.size()) {
+      throw KException("Profiler::probeID: too many probes");
+    }
+    r.names.push_back(name);
+    return r.names.size() - 1;
+  }
+
+
+  string Profiler::probeName(unsigned int id) {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lk(r.mtx);
+    assert(id < r.names.size());
+    return r.names[id];
+  }
+
+
+  unsigned int Profiler::numProbes() {
+    auto& r = registry();
+    std::lock_guard<std::mutex> lk(r.mtx);
+    return r.names.size();
+  }
+
+
+  void Profiler::setEnabled(bool e) {
+    on.store(e, std::memory_order_relaxed);
+    return;
+  }
+
+
+  ProbeStats Profiler::threadStats() {
+    return threadProf()->stats(numProbes());
+  }
+
+
+  vector<ProbeStats> Profiler::allStats() {
+    const unsigned int np = numProbes();
+    auto& r = registry();
+    std::lock_guard<std::mutex> lk(r.mtx);
+    auto all = vector<ProbeStats>();
+    auto rt = r.retired;
+    rt.resize(np);
+    all.push_back(rt);
+    for (auto tp : r.threads) {
+      all.push_back(tp->stats(np));
+    }
+    return all;
+  }
+
+
+  ProbeStats Profiler::totalStats() {
+    auto all = allStats();
+    auto tot = ProbeStats(numProbes());
+    for (auto& ps : all) {
+      for (unsigned int i = 0; i < ps.size(); i++) {
+        tot[i].calls += ps[i].calls;
+        tot[i].nsec += ps[i].nsec;
+        tot[i].allocs += ps[i].allocs;
+      }
+    }
+    return tot;
+  }
+
+
+  ProbeStats Profiler::diff(const ProbeStats & b, const ProbeStats & a) {
+    assert(a.size() <= b.size()); // probes may have registered in between
+    auto d = b;
+    for (unsigned int i = 0; i < a.size(); i++) {
+      d[i].calls = b[i].calls - a[i].calls;
+      d[i].nsec = b[i].nsec - a[i].nsec;
+      d[i].allocs = b[i].allocs - a[i].allocs;
+    }
+    return d;
+  }
+
+
+  uint64_t Profiler::threadAllocs() {
+    return tlAllocs;
+  }
+
+
+  void Profiler::record(unsigned int id, uint64_t ns, uint64_t na) {
+    assert(id < MaxProbes);
+    auto tp = threadProf();
+    bump(tp->calls[id], 1);
+    bump(tp->nsec[id], ns);
+    bump(tp->allocs[id], na);
+    return;
+  }
+
+
+  void Profiler::writeCSV(const string & fName) {
+    auto all = allStats();
+    FILE* f = fopen(fName.c_str(), "w");
+    if (nullptr == f) {
+      throw KException("Profiler::writeCSV: could not open " + fName);
+    }
+    fprintf(f, "Thread,Probe,Calls,NSec,Allocs\n");
+    for (unsigned int t = 0; t < all.size(); t++) {
+      for (unsigned int i = 0; i < all[t].size(); i++) {
+        const ProbeStat & s = all[t][i];
+        if (0 < s.calls) {
+          fprintf(f, "%u,%s,%llu,%llu,%llu\n", t, probeName(i).c_str(),
+                  (unsigned long long) s.calls, (unsigned long long) s.nsec,
+                  (unsigned long long) s.allocs);
+        }
+      }
+    }
+    fclose(f);
+    return;
+  }
+
+
+  void Profiler::show(const ProbeStats & ps) {
+    printf("%-24s %10s %12s %10s %10s \n", "Probe", "Calls", "Total msec", "usec/call", "Allocs");
+    for (unsigned int i = 0; i < ps.size(); i++) {
+      const ProbeStat & s = ps[i];
+      if (0 < s.calls) {
+        printf("%-24s %10llu %12.3f %10.2f %10llu \n", probeName(i).c_str(),
+               (unsigned long long) s.calls, s.nsec / 1.0E6,
+               (s.nsec / 1.0E3) / s.calls, (unsigned long long) s.allocs);
+      }
+    }
+    cout << flush;
+    return;
+  }
+
+}; // end of namespace
+
+
+#ifdef KTAB_PROFILE_ALLOC
+// Count every allocation made by the thread. These replace the global
+// operators for the whole program, so they are built only on request.
+void* operator new(std::size_t n) {
+  KBase::tlAllocs++;
+  void* p = malloc((0 < n) ? n : 1);
+  if (nullptr == p) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void* operator new[](std::size_t n) {
+  return operator new(n);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+#endif
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
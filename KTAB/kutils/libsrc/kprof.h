@@ -0,0 +1,143 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// Low-overhead profiling probes for the hot paths of a model run.
+//
+// Put KPROF_SCOPE("Name") at the top of a function (or any block), and each
+// pass through that scope adds one call, its elapsed nanoseconds, and the
+// number of allocations made inside it, to the statistics of the current thread.
+// Each thread keeps its own statistics, so probes never contend with each other.
+//
+// Probes cost one test of a flag unless profiling has been turned on with
+// Profiler::setEnabled(true); compiling with -DKTAB_PROFILE=0 removes them.
+// Allocations are counted only when kutils is built with ENABLE_PROFILE_ALLOC,
+// which replaces the global operator new; otherwise they are reported as zero.
+// -------------------------------------------------
+#ifndef KTAB_PROF_H
+#define KTAB_PROF_H
+
+#include <atomic>
+
+#include "kutils.h"
+
+#ifndef KTAB_PROFILE
+#define KTAB_PROFILE 1
+#endif
+
+#define KPROF_CAT2(a, b) a ## b
+#define KPROF_CAT(a, b) KPROF_CAT2(a, b)
+
+#if KTAB_PROFILE
+// the probe is registered once, on first use
+#define KPROF_SCOPE(name) \
+  static const unsigned int KPROF_CAT(kprofID_, __LINE__) = KBase::Profiler::probeID(name); \
+  KBase::ProfScope KPROF_CAT(kprofScope_, __LINE__) (KPROF_CAT(kprofID_, __LINE__))
+#else
+#define KPROF_SCOPE(name) do { } while (false)
+#endif
+
+
+namespace KBase {
+
+  class ProbeStat {
+  public:
+    uint64_t calls = 0;
+    uint64_t nsec = 0;
+    uint64_t allocs = 0;
+  };
+
+  // totals for each probe, indexed by probe ID
+  typedef vector<ProbeStat> ProbeStats;
+
+  class Profiler {
+  public:
+    static const unsigned int MaxProbes = 64;
+
+    // register the name (if new), and return its ID
+    static unsigned int probeID(const string & name);
+    static string probeName(unsigned int id);
+    static unsigned int numProbes();
+
+    static void setEnabled(bool e);
+    static bool enabled() {
+      return on.load(std::memory_order_relaxed);
+    }
+
+    // this thread's totals since it started
+    static ProbeStats threadStats();
+
+    // totals for each thread, in the order the threads first recorded anything.
+    // Threads which have finished are summed into the first row.
+    static vector<ProbeStats> allStats();
+    static ProbeStats totalStats(); // summed over all threads
+
+    // b - a, probe by probe (e.g. the stats for one turn)
+    static ProbeStats diff(const ProbeStats & b, const ProbeStats & a);
+
+    // number of allocations made by this thread so far
+    static uint64_t threadAllocs();
+
+    static void record(unsigned int id, uint64_t ns, uint64_t na);
+
+    // one line per thread and probe: Thread, Probe, Calls, NSec, Allocs
+    static void writeCSV(const string & fName);
+    static void show(const ProbeStats & ps);
+
+  protected:
+    static std::atomic<bool> on;
+  };
+
+
+  class ProfScope {
+  public:
+    explicit ProfScope(unsigned int pid) : id(pid), t0(), a0(0), live(Profiler::enabled()) {
+      if (live) {
+        a0 = Profiler::threadAllocs();
+        t0 = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~ProfScope() {
+      if (live) {
+        auto t1 = std::chrono::steady_clock::now();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+        Profiler::record(id, ns, Profiler::threadAllocs() - a0);
+      }
+    }
+
+    ProfScope(const ProfScope &) = delete;
+    ProfScope & operator=(const ProfScope &) = delete;
+
+  protected:
+    const unsigned int id;
+    std::chrono::steady_clock::time_point t0;
+    uint64_t a0;
+    const bool live;
+  };
+
+}; // end of namespace
+
+// -------------------------------------------------
+#endif
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -0,0 +1,197 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+
+#include <cstdio>
+
+#include "kserial.h"
+
+namespace KBase {
+
+  BinWriter::BinWriter(const string & fName, const char tag[8], uint32_t version) {
+    fileName = fName;
+    tmpName = fName + ".tmp";
+    file = fopen(tmpName.c_str(), "wb");
+    if (nullptr == file) {
+      throw KException("BinWriter: could not open " + tmpName);
+    }
+    put(tag, 8);
+    u32(version);
+  }
+
+
+  BinWriter::~BinWriter() {
+    if (nullptr != file) {
+      fclose(file);
+      file = nullptr;
+      remove(tmpName.c_str());
+    }
+  }
+
+
+  void BinWriter::put(const void* p, size_t n) {
+    assert(nullptr != file);
+    if ((0 < n) && (1 != fwrite(p, n, 1, file))) {
+      throw KException("BinWriter: could not write " + tmpName);
+    }
+    return;
+  }
+
+
+  void BinWriter::u32(uint32_t x) {
+    put(&x, sizeof(x));
+    return;
+  }
+
+
+  void BinWriter::u64(uint64_t x) {
+    put(&x, sizeof(x));
+    return;
+  }
+
+
+  void BinWriter::f64(double x) {
+    put(&x, sizeof(x));
+    return;
+  }
+
+
+  void BinWriter::str(const string & s) {
+    u64(s.length());
+    put(s.data(), s.length());
+    return;
+  }
+
+
+  void BinWriter::mat(const KMatrix & m) {
+    const unsigned int nr = m.numR();
+    const unsigned int nc = m.numC();
+    u32(nr);
+    u32(nc);
+    auto row = vector<double>(nc);
+    for (unsigned int i = 0; i < nr; i++) {
+      for (unsigned int j = 0; j < nc; j++) {
+        row[j] = m(i, j);
+      }
+      put(row.data(), nc * sizeof(double));
+    }
+    return;
+  }
+
+
+  void BinWriter::close() {
+    assert(nullptr != file);
+    const int rc = fclose(file);
+    file = nullptr;
+    if (0 != rc) {
+      remove(tmpName.c_str());
+      throw KException("BinWriter: could not write " + tmpName);
+    }
+    // on Windows, rename will not replace an existing file
+    remove(fileName.c_str());
+    if (0 != rename(tmpName.c_str(), fileName.c_str())) {
+      throw KException("BinWriter: could not rename " + tmpName + " to " + fileName);
+    }
+    return;
+  }
+
+  // --------------------------------------------
+
+  BinReader::BinReader(const string & fName, const char tag[8], uint32_t version) {
+    fileName = fName;
+    file = std::make_shared<MappedFile>(fName);
+    char t[8];
+    get(t, 8);
+    if (0 != memcmp(t, tag, 8)) {
+      throw KException("BinReader: " + fName + " is not the expected kind of file");
+    }
+    if (version != u32()) {
+      throw KException("BinReader: " + fName + " has an unknown version");
+    }
+  }
+
+
+  BinReader::~BinReader() {}
+
+
+  void BinReader::get(void* p, size_t n) {
+    if (file->size() - pos < n) {
+      throw KException("BinReader: unexpected end of " + fileName);
+    }
+    memcpy(p, file->data() + pos, n);
+    pos = pos + n;
+    return;
+  }
+
+
+  uint32_t BinReader::u32() {
+    uint32_t x = 0;
+    get(&x, sizeof(x));
+    return x;
+  }
+
+
+  uint64_t BinReader::u64() {
+    uint64_t x = 0;
+    get(&x, sizeof(x));
+    return x;
+  }
+
+
+  double BinReader::f64() {
+    double x = 0;
+    get(&x, sizeof(x));
+    return x;
+  }
+
+
+  string BinReader::str() {
+    const uint64_t n = u64();
+    if (file->size() - pos < n) {
+      throw KException("BinReader: unexpected end of " + fileName);
+    }
+    auto s = string(file->data() + pos, n);
+    pos = pos + n;
+    return s;
+  }
+
+
+  KMatrix BinReader::mat() {
+    const unsigned int nr = u32();
+    const unsigned int nc = u32();
+    if ((file->size() - pos) / sizeof(double) < ((uint64_t)nr) * nc) {
+      throw KException("BinReader: unexpected end of " + fileName);
+    }
+    auto m = KMatrix(nr, nc);
+    for (unsigned int i = 0; i < nr; i++) {
+      for (unsigned int j = 0; j < nc; j++) {
+        m(i, j) = f64();
+      }
+    }
+    return m;
+  }
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
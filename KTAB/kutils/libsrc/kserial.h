@@ -0,0 +1,96 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// Simple binary files, for checkpoints and the like.
+//
+// Values are written in the byte order of the machine, with no padding,
+// so files move only between machines of the same kind. Each file starts
+// with a caller-chosen 8-byte tag and a version number, which the reader
+// checks. Strings and matrices carry their own sizes.
+//
+// The writer builds the file under a temporary name and renames it only
+// when close() succeeds, so a crash mid-write leaves any earlier file
+// of the same name intact. Both classes throw KException on any failure.
+// -------------------------------------------------
+#ifndef KTAB_SERIAL_H
+#define KTAB_SERIAL_H
+
+#include "kutils.h"
+#include "kmatrix.h"
+#include "kcsv.h"
+
+namespace KBase {
+
+  class BinWriter {
+  public:
+    BinWriter(const string & fName, const char tag[8], uint32_t version);
+    virtual ~BinWriter(); // abandons the file, unless close() was called
+
+    void u32(uint32_t x);
+    void u64(uint64_t x);
+    void f64(double x);
+    void str(const string & s);
+    void mat(const KMatrix & m);
+
+    void close();
+
+  protected:
+    void put(const void* p, size_t n);
+    string fileName = "";
+    string tmpName = "";
+    FILE* file = nullptr;
+
+  private:
+    BinWriter(const BinWriter &) = delete;
+    BinWriter& operator=(const BinWriter &) = delete;
+  };
+
+
+  class BinReader {
+  public:
+    BinReader(const string & fName, const char tag[8], uint32_t version);
+    virtual ~BinReader();
+
+    uint32_t u32();
+    uint64_t u64();
+    double f64();
+    string str();
+    KMatrix mat();
+
+    bool atEnd() const {
+      return (pos == file->size());
+    }
+
+  protected:
+    void get(void* p, size_t n);
+    string fileName = "";
+    std::shared_ptr<MappedFile> file = nullptr;
+    size_t pos = 0;
+  };
+
+}; // end of namespace
+
+// -------------------------------------------------
+#endif
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -23,6 +23,7 @@
 
 
 #include <assert.h>
+#include <sstream>
 
 #include "prng.h"
  
@@ -82,6 +83,25 @@ namespace KBase {
   }
 
 
+  string PRNG::getState() const {
+    std::ostringstream os;
+    os << mt;
+    return os.str();
+  }
+
+
+  void PRNG::setState(const string & s) {
+    std::istringstream is(s);
+    auto mt1 = mt19937_64();
+    is >> mt1;
+    if (is.fail()) {
+      throw KException("PRNG::setState: not a valid generator state");
+    }
+    mt = mt1;
+    return;
+  }
+
+
   double PRNG::uniform(double a, double b){
     uint64_t n = uniform();
     double x = ((double)n) / ((double)0xFFFFFFFFFFFFFFFF);
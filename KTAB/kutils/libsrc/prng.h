@@ -52,6 +52,11 @@ namespace KBase {
     double uniform(double a, double b);
     vector<bool> bits(unsigned int nb);
     uint64_t setSeed(uint64_t);
+
+    // The whole state of the generator, as text, so that a checkpointed
+    // run can carry on with exactly the same stream of numbers.
+    string getState() const;
+    void setState(const string & s); // throws KException if s is not a state
   protected:
     mt19937_64 mt = mt19937_64();
   };
@@ -0,0 +1,179 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom 
+// the Software is furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING 
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND 
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// -------------------------------------------------
+// A vector of plain numbers which keeps up to N of them inline, in the object
+// itself, and goes to the heap only when it needs more. It provides just the part
+// of the std::vector interface that KMatrix uses.
+//
+// Positions in most models have 1 to 8 dimensions, so with this storage a
+// VctrPstn (and any other small KMatrix) needs no heap allocation at all.
+// The price is sizeof(T)*N extra bytes in every matrix, which is negligible
+// next to the elements of a big one.
+// -------------------------------------------------
+#ifndef KTAB_SMALLVEC_H
+#define KTAB_SMALLVEC_H
+
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace KBase {
+
+  template <class T, unsigned int N>
+  class SmallVec {
+    static_assert(std::is_trivially_copyable<T>::value, "SmallVec is only for plain numbers");
+  public:
+    SmallVec() : inl(), ptr(inl), len(0), cap(N) {};
+
+    SmallVec(const SmallVec & v) : inl(), ptr(inl), len(0), cap(N) {
+      assignFrom(v);
+    };
+
+    SmallVec(SmallVec && v) noexcept : inl(), ptr(inl), len(0), cap(N) {
+      takeFrom(v);
+    };
+
+    SmallVec & operator=(const SmallVec & v) {
+      if (this != &v) {
+        assignFrom(v);
+      }
+      return *this;
+    };
+
+    SmallVec & operator=(SmallVec && v) noexcept {
+      if (this != &v) {
+        release();
+        takeFrom(v);
+      }
+      return *this;
+    };
+
+    ~SmallVec() {
+      release();
+    };
+
+    unsigned int size() const { return len; };
+    bool isInline() const { return (ptr == inl); };
+    const T* data() const { return ptr; };
+    T* data() { return ptr; };
+    T operator[] (unsigned int n) const { return ptr[n]; };
+    T& operator[] (unsigned int n) { return ptr[n]; };
+
+    T* begin() { return ptr; };
+    T* end() { return ptr + len; };
+    const T* begin() const { return ptr; };
+    const T* end() const { return ptr + len; };
+    const T* cbegin() const { return ptr; };
+    const T* cend() const { return ptr + len; };
+
+    void reserve(unsigned int n) {
+      if (cap < n) {
+        T* p2 = new T[n];
+        if (0 < len) {
+          memcpy(p2, ptr, len * sizeof(T));
+        }
+        release();
+        ptr = p2;
+        cap = n;
+      }
+      return;
+    };
+
+    // new elements are zero
+    void resize(unsigned int n) {
+      reserve(n);
+      for (unsigned int i = len; i < n; i++) {
+        ptr[i] = T();
+      }
+      len = n;
+      return;
+    };
+
+    void push_back(T x) {
+      if (len == cap) {
+        reserve(2 * cap);
+      }
+      ptr[len] = x;
+      len = len + 1;
+      return;
+    };
+
+    // empty, and back to the inline buffer
+    void clear() {
+      release();
+      len = 0;
+      return;
+    };
+
+  protected:
+    void release() {
+      if (ptr != inl) {
+        delete[] ptr;
+        ptr = inl;
+        cap = N;
+      }
+      return;
+    };
+
+    void assignFrom(const SmallVec & v) {
+      len = 0;
+      reserve(v.len);
+      if (0 < v.len) {
+        memcpy(ptr, v.ptr, v.len * sizeof(T));
+      }
+      len = v.len;
+      return;
+    };
+
+    // take over v's heap block, or copy its inline elements, leaving v empty
+    void takeFrom(SmallVec & v) {
+      if (v.ptr == v.inl) {
+        if (0 < v.len) {
+          memcpy(inl, v.inl, v.len * sizeof(T));
+        }
+        ptr = inl;
+        cap = N;
+      }
+      else {
+        ptr = v.ptr;
+        cap = v.cap;
+        v.ptr = v.inl;
+        v.cap = N;
+      }
+      len = v.len;
+      v.len = 0;
+      return;
+    };
+
+    T inl[N];
+    T* ptr = nullptr;
+    unsigned int len = 0;
+    unsigned int cap = 0;
+  };
+
+}; // end of namespace
+
+// -------------------------------------------------
+#endif
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
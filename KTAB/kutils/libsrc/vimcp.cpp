@@ -119,7 +119,7 @@ namespace KBase {
       M.mPrintf("%+.4f  ");
       cout << endl;
       cout << "Received q:" << endl;
-      trans(q).mPrintf("%+.4f  ");
+      q.tView().mPrintf("%+.4f  ");
       cout << endl << endl << flush;
     }
 
@@ -48,10 +48,28 @@ namespace AgendaControl {
   }
 
 
+  namespace {
+    // n choose m, which is zero if m > n. Each partial product is itself
+    // a binomial coefficient, so the division is always exact.
+    uint64_t binom(unsigned int n, unsigned int m) {
+      if (n < m) {
+        return 0;
+      }
+      m = (n - m < m) ? (n - m) : m;
+      uint64_t c = 1;
+      for (unsigned int i = 1; i <= m; i++) {
+        c = (c * (n - m + i)) / i;
+      }
+      return c;
+    }
+  }; // end of anonymous namespace
+
+
   uint64_t numSets(unsigned int n, unsigned int m) {
     assert(0 < n);
     assert(0 < m);
-    uint64_t ns = fact(n) / (fact(m)*fact(n - m));
+    // computed directly, as fact(n) overflows for n > 20
+    uint64_t ns = binom(n, m);
     return ns;
   }
 
@@ -131,6 +149,110 @@ namespace AgendaControl {
   }
 
 
+  uint64_t nextSubset(uint64_t x) {
+    // Gosper's hack: move the lowest movable bit up by one, and
+    // shift the bits below it all the way down.
+    assert(0 != x);
+    const uint64_t u = x & (~x + 1); // lowest set bit
+    const uint64_t v = x + u;
+    return v + (((v ^ x) / u) >> 2);
+  }
+
+
+  // In the combinatorial number system, the rank of {c1 < c2 < ... < cm}
+  // is C(c1,1) + C(c2,2) + ... + C(cm,m)
+  uint64_t rankSubset(uint64_t x) {
+    uint64_t r = 0;
+    unsigned int i = 1;
+    for (unsigned int c = 0; c < 64; c++) {
+      if (0 != (x & (((uint64_t)1) << c))) {
+        r = r + binom(c, i);
+        i++;
+      }
+    }
+    return r;
+  }
+
+
+  uint64_t unrankSubset(uint64_t r, unsigned int m) {
+    assert(m < 64);
+    // pick the largest element first: the largest c with C(c,m) <= r
+    uint64_t x = 0;
+    for (unsigned int i = m; 0 < i; i--) {
+      unsigned int c = i - 1;
+      while (binom(c + 1, i) <= r) {
+        c++;
+      }
+      r = r - binom(c, i);
+      x = x | (((uint64_t)1) << c);
+    }
+    return x;
+  }
+
+
+  void forEachSubset(unsigned int n, unsigned int m, function<void(uint64_t x)> f) {
+    forEachSubset(n, m, f, 0, numSets(n, m));
+    return;
+  }
+
+
+  void forEachSubset(unsigned int n, unsigned int m, function<void(uint64_t x)> f,
+                     uint64_t r0, uint64_t r1) {
+    assert(0 < m);
+    assert(m <= n);
+    assert(n < 64);
+    assert(r1 <= numSets(n, m));
+    if (r1 <= r0) {
+      return;
+    }
+    uint64_t x = unrankSubset(r0, m);
+    for (uint64_t r = r0; r < r1; r++) {
+      f(x);
+      if (r + 1 < r1) {
+        x = nextSubset(x);
+      }
+    }
+    return;
+  }
+
+
+  void forEachSubsetLex(unsigned int n, unsigned int m, function<void(uint64_t x)> f) {
+    forEachSubsetLex(n, m, f, 0, numSets(n, m));
+    return;
+  }
+
+
+  void forEachSubsetLex(unsigned int n, unsigned int m, function<void(uint64_t x)> f,
+                        uint64_t r0, uint64_t r1) {
+    assert(0 < m);
+    assert(m <= n);
+    assert(n < 64);
+    assert(r1 <= numSets(n, m));
+    if (r1 <= r0) {
+      return;
+    }
+    if (m == n) {
+      f((((uint64_t)1) << n) - 1);
+      return;
+    }
+    // Taking complements reverses colex order, and so does numbering the items
+    // from the other end; lex order is colex order with the items so numbered.
+    // So the r-th m-subset in lex order is the r-th (n-m)-subset in colex order,
+    // complemented and with its items numbered backwards.
+    forEachSubset(n, n - m, [n, &f](uint64_t y) {
+      uint64_t x = 0;
+      for (unsigned int i = 0; i < n; i++) {
+        if (0 == (y & (((uint64_t)1) << (n - 1 - i)))) {
+          x = x | (((uint64_t)1) << i);
+        }
+      }
+      f(x);
+      return;
+    }, r0, r1);
+    return;
+  }
+
+
   tuple<VUI, VUI> indexedSet(const VUI xs,
     const VUI is) {
     VUI rslt = {};
@@ -180,48 +302,47 @@ namespace AgendaControl {
 
     default: // n>2, odd or even
       for (unsigned int k = 1; k <= (n / 2); k++) {
-        vector<VUI> leftIndices = {};
-
-        leftIndices = chooseSet(n, k);
+        if (!Choice::balancedLR(pr, k, n - k)) {
+          continue;
+        }
         // if n is odd, then when k= (n/2), we have k < n-k, so the
         // left-hand agenda is smaller than and distinct from the right-hand agenda.
-        // However, when n is even, the latter half of the list must be discarded
+        // However, when n is even, the latter half of the subsets must be skipped
         // because of symmetry.
         // Suppose n=4 for (a,b,c,d) and we choose 2.
-        // ((a,b), (a,c), (a,d), (b,c), (b,d), (c,d)) is the usual set of 6 unique subsets of size 2.
-        // However, if those are the left-hand agendas, then the right-hand are their complements:
+        // ((a,b), (a,c), (a,d), (b,c), (b,d), (c,d)) are the 6 subsets of size 2, in the
+        // order forEachSubsetLex gives them. However, if those are the left-hand agendas,
+        // then the right-hand are their complements:
         // ((c,d), (b,d), (b,c), (a,d), (a,c), (a,b)).
         // Thus, the complements of the second half are exactly the first half, so by symmetry
-        // we discard the second half.
+        // we skip the second half.
+        uint64_t numL = numSets(n, k);
         if (n == (2 * k)) {
-          unsigned int m = leftIndices.size();
-          assert(m == 2 * (m / 2));
-          vector<VUI> shortIndices = {};
-          for (unsigned int i = 0; i < (m / 2); i++) {
-            shortIndices.push_back(leftIndices[i]);
-          }
-          leftIndices = shortIndices;
+          assert(numL == 2 * (numL / 2));
+          numL = numL / 2;
         }
 
-        for (auto lhi : leftIndices) {
-          //showA(lhi);
-          //cout << " -- ";
-          auto lrPairs = indexedSet(xs, lhi);
-          VUI lhs = std::get<0>(lrPairs);
-          VUI rhs = std::get<1>(lrPairs);
-
-          bool ok = Choice::balancedLR(pr, lhs.size(), rhs.size());
-          if (ok) {
-            auto lAgendas = agendaSet(pr, lhs);
-            auto rAgendas = agendaSet(pr, rhs);
-            for (auto la : lAgendas) {
-              for (auto ra : rAgendas) {
-                Agenda* a = new Choice(la, ra);
-                as.push_back(a);
-              }
+        forEachSubsetLex(n, k, [pr, &xs, &as](uint64_t ls) {
+          VUI lhs = {};
+          VUI rhs = {};
+          for (unsigned int i = 0; i < xs.size(); i++) {
+            if (0 != (ls & (((uint64_t)1) << i))) {
+              lhs.push_back(xs[i]);
+            }
+            else {
+              rhs.push_back(xs[i]);
             }
           }
-        }
+          auto lAgendas = agendaSet(pr, lhs);
+          auto rAgendas = agendaSet(pr, rhs);
+          for (auto la : lAgendas) {
+            for (auto ra : rAgendas) {
+              Agenda* a = new Choice(la, ra);
+              as.push_back(a);
+            }
+          }
+          return;
+        }, 0, numL);
       }
       break;
     }
@@ -329,12 +450,17 @@ namespace AgendaControl {
   double Choice::eval(const KMatrix& val, unsigned int i) {
     double valL = lhs->eval(val, i);
     double valR = rhs->eval(val, i);
+    double ev = combine(valL, valR);
+    //cout << "Eval " << i << " of " << *this << " = " << ev << endl << flush;
+    return ev;
+  }; 
+
+  double Choice::combine(double valL, double valR) {
     double valMin = (valL < valR) ? valL : valR;
     double valMax = (valL > valR) ? valL : valR;
     double ev = (4.0*valMin + 3.0*valMax) / 7.0;
-    //cout << "Eval " << i << " of " << *this << " = " << ev << endl << flush;
     return ev;
-  }; 
+  }
 
   bool Agenda::balancedLR(PartitionRule pr, unsigned int numL, unsigned int numR) {
     const unsigned int n = numL + numR;
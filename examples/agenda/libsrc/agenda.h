@@ -29,6 +29,7 @@
 #include <algorithm>
 #include <vector>
 #include <iterator>
+#include <unordered_map>
  
 #include "kutils.h"
 #include "kmatrix.h"
@@ -59,6 +60,24 @@ namespace AgendaControl {
   // returns the list of all lists that have m integers out of the first n integers,  {0, 1, 2, ... n-1}
   vector< vector <unsigned int> > chooseSet(const unsigned int n, const unsigned int m);
   
+  // Stream the subsets of m items out of the first n, as bitmasks, without
+  // building any lists. They come in increasing numeric order (i.e. colex order),
+  // so subset number r is unrankSubset(r, m), and the range [r0, r1) of a
+  // numSets(n,m) subsets can be given to one thread while others take the rest.
+  uint64_t nextSubset(uint64_t x); // the next larger bitmask with as many bits set
+  uint64_t rankSubset(uint64_t x);
+  uint64_t unrankSubset(uint64_t r, unsigned int m);
+  void forEachSubset(unsigned int n, unsigned int m, function<void(uint64_t x)> f);
+  void forEachSubset(unsigned int n, unsigned int m, function<void(uint64_t x)> f,
+                     uint64_t r0, uint64_t r1);
+
+  // The same subsets in lexicographic order, as chooseSet lists them, so that
+  // agendas are enumerated (and ties between them resolved) as they always were.
+  // The range [r0, r1) again refers to positions in this order.
+  void forEachSubsetLex(unsigned int n, unsigned int m, function<void(uint64_t x)> f);
+  void forEachSubsetLex(unsigned int n, unsigned int m, function<void(uint64_t x)> f,
+                        uint64_t r0, uint64_t r1);
+
   // pick out the indicated subset
   tuple<VUI, VUI> indexedSet(const VUI xs, const VUI is);
 
@@ -99,6 +118,9 @@ namespace AgendaControl {
     virtual unsigned int length() const { return (lhs->length() + rhs->length()); }
     bool balanced(PartitionRule pr) const;
 
+    // the value of a choice between sub-agendas with these values
+    static double combine(double valL, double valR);
+
   protected: 
     virtual void print(ostream& os) const {
       os << "[" << *lhs << ":" << *rhs << "]";
@@ -126,6 +148,121 @@ namespace AgendaControl {
   };
 
 
+  // Evaluate all the agendas over n items at once, without building any of them.
+  //
+  // The value of a Choice depends only on the values of its two sub-agendas,
+  // and is increasing in both, so the best (or worst) agenda over a set of items
+  // is a choice between the best (or worst) agendas over the two parts of some
+  // allowed split. Working up from single items, each subset of items (as a
+  // bitmask) is evaluated once per actor, by trying every split of it: O(3^n)
+  // time and O(2^n) memory, where enumerateAgendas takes time and memory
+  // proportional to the number of agendas, (2n-3)!! for FreePR.
+  // This makes 15 to 20 items practical.
+  class AgendaDP {
+  public:
+    AgendaDP(unsigned int n, Agenda::PartitionRule pr);
+    virtual ~AgendaDP() {};
+
+    static const unsigned int MaxItems = 24; // 2^24 subsets take about 420MB
+
+    // the number of distinct agendas over all n items, as a double because
+    // it overflows uint64_t beyond 19 items
+    double numAgendas() const;
+
+    // Find the best and worst agendas over every subset, from actor i's perspective
+    void eval(const KMatrix& val, unsigned int i);
+
+    // For the actor last evaluated, the values of the best and worst agendas
+    // over the given subset of items (by default, all of them)
+    double best() const { return bestV[fullSet()]; };
+    double worst() const { return worstV[fullSet()]; };
+    double best(uint32_t s) const;
+    double worst(uint32_t s) const;
+
+    // Build one best (or worst) agenda over all items. The caller owns the result,
+    // which has the same value as Agenda::eval gives it.
+    Agenda* bestAgenda() const { return buildAgenda(fullSet(), bestL); };
+    Agenda* worstAgenda() const { return buildAgenda(fullSet(), worstL); };
+
+  protected:
+    uint32_t fullSet() const { return (((uint32_t)1) << numItems) - 1; };
+    Agenda* buildAgenda(uint32_t s, const vector<uint32_t> & lhs) const;
+    static unsigned int numBits(uint32_t s);
+
+    unsigned int numItems = 0;
+    Agenda::PartitionRule rule = Agenda::PartitionRule::FreePR;
+    vector<unsigned char> splitOK = {}; // splitOK[a*(n+1)+b]: may a set of a items face one of b?
+    vector<double> bestV = {}; // indexed by subset
+    vector<double> worstV = {};
+    vector<uint32_t> bestL = {}; // the left side of the best split of each subset
+    vector<uint32_t> worstL = {};
+  };
+
+
+  // All the agendas over a set of items, as in Agenda::agendaSet, but with each
+  // distinct sub-agenda stored exactly once.
+  //
+  // The agendas over a subset of items are built once, the first time some
+  // larger agenda needs them, and recorded under that subset's bitmask; every
+  // later Choice over that subset refers to the same nodes. The nodes for one
+  // subset occupy a contiguous range of ids, and every node comes after its
+  // children, so a node is just two 32-bit ids and a set of agendas is
+  // just a range. All the nodes live in one arena, which the destructor
+  // releases with a handful of deallocations, not one per agenda.
+  //
+  // The value of every node to an actor is cached, so evaluating all the agendas
+  // for an actor costs one combine per node.
+  class AgendaDAG {
+  public:
+    AgendaDAG(const VUI & xs, Agenda::PartitionRule pr);
+    AgendaDAG(unsigned int n, Agenda::PartitionRule pr);
+    virtual ~AgendaDAG() {};
+
+    static const unsigned int MaxItems = 30;
+    static const uint32_t NoNode = 0xFFFFFFFF;
+
+    // the agendas over all the items, in the same order as agendaSet lists them
+    uint64_t numAgendas() const { return numRoots; };
+    uint32_t agenda(uint64_t k) const;
+
+    uint64_t numNodes() const { return nodes.size(); };
+    bool isTerminal(uint32_t a) const { return (NoNode == nodes[a].lhs); };
+    uint64_t memBytes() const;
+
+    // value of agenda a to actor i, as Agenda::eval would give it
+    double eval(const KMatrix& val, unsigned int i, uint32_t a);
+
+    // values to actor i of every node, indexed by node id
+    const vector<double> & evalAll(const KMatrix& val, unsigned int i);
+
+    void clearCache();
+
+    void print(ostream& os, uint32_t a) const;
+
+    // Build a stand-alone copy of agenda a, which the caller owns.
+    Agenda* toAgenda(uint32_t a) const;
+
+  protected:
+    // Agendas over subset s (bitmask of positions in items): first id and count
+    tuple<uint32_t, uint32_t> build(uint32_t s);
+
+    struct Node {
+      uint32_t lhs; // NoNode for a terminal
+      uint32_t rhs; // the item, for a terminal
+    };
+
+    VUI items = {};
+    Agenda::PartitionRule rule = Agenda::PartitionRule::FreePR;
+    vector<Node> nodes = {};
+    std::unordered_map<uint32_t, tuple<uint32_t, uint32_t>> subsets = {};
+    uint32_t firstRoot = 0;
+    uint64_t numRoots = 0;
+
+    KMatrix cacheVal = KMatrix(); // the value matrix which nodeVal reflects
+    vector<vector<double>> nodeVal = {}; // by actor, then node; empty until evaluated
+  };
+
+
 }; // end of namespace
 
 
@@ -0,0 +1,229 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom 
+// the Software is furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING 
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND 
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// All the agendas over a set of items, sharing every common sub-agenda
+// --------------------------------------------
+#include "agenda.h"
+
+namespace AgendaControl {
+
+  AgendaDAG::AgendaDAG(const VUI & xs, Agenda::PartitionRule pr) {
+    const unsigned int n = xs.size();
+    assert(0 < n);
+    assert(n <= MaxItems);
+    items = xs;
+    rule = pr;
+
+    const uint32_t all = (((uint32_t)1) << n) - 1;
+    auto rs = build(all);
+    firstRoot = std::get<0>(rs);
+    numRoots = std::get<1>(rs);
+
+    if (Agenda::PartitionRule::FreePR == pr) {
+      assert(numRoots == numAgenda(n));
+    }
+    if ((2 <= n) && (Agenda::PartitionRule::SeqPR == pr)) {
+      assert(numRoots == (fact(n) / 2));
+    }
+  }
+
+
+  AgendaDAG::AgendaDAG(unsigned int n, Agenda::PartitionRule pr) :
+    AgendaDAG(KBase::uiSeq(0, n - 1), pr) {}
+
+
+  tuple<uint32_t, uint32_t> AgendaDAG::build(uint32_t s) {
+    auto si = subsets.find(s);
+    if (subsets.end() != si) {
+      return si->second;
+    }
+
+    // the positions in s, in increasing order, as agendaSet would list them
+    VUI ps = {};
+    for (unsigned int p = 0; p < items.size(); p++) {
+      if (0 != (s & (((uint32_t)1) << p))) {
+        ps.push_back(p);
+      }
+    }
+    const unsigned int n = ps.size();
+    assert(0 < n);
+
+    if (1 == n) {
+      const uint32_t id = nodes.size();
+      nodes.push_back(Node{ NoNode, items[ps[0]] });
+      auto rslt = tuple<uint32_t, uint32_t>(id, 1);
+      subsets[s] = rslt;
+      return rslt;
+    }
+
+    // Choose the splits exactly as agendaSet does, and build the agendas over
+    // both sides of each before adding any choice over s, so that those choices
+    // end up next to each other.
+    auto splits = vector<tuple<tuple<uint32_t, uint32_t>, tuple<uint32_t, uint32_t>>>();
+    for (unsigned int k = 1; k <= (n / 2); k++) {
+      if (!Agenda::balancedLR(rule, k, n - k)) {
+        continue;
+      }
+      uint64_t numL = numSets(n, k);
+      if (n == (2 * k)) {
+        numL = numL / 2; // the rest are mirror images
+      }
+      forEachSubsetLex(n, k, [this, s, &ps, &splits](uint64_t lhi) {
+        uint32_t ls = 0;
+        for (unsigned int i = 0; i < ps.size(); i++) {
+          if (0 != (lhi & (((uint64_t)1) << i))) {
+            ls = ls | (((uint32_t)1) << ps[i]);
+          }
+        }
+        const uint32_t rs = s & (~ls);
+        auto la = build(ls);
+        auto ra = build(rs);
+        splits.push_back(tuple<tuple<uint32_t, uint32_t>, tuple<uint32_t, uint32_t>>(la, ra));
+        return;
+      }, 0, numL);
+    }
+
+    uint64_t num = 0;
+    for (auto& sp : splits) {
+      num = num + ((uint64_t)std::get<1>(std::get<0>(sp))) * std::get<1>(std::get<1>(sp));
+    }
+    if (NoNode <= nodes.size() + num) {
+      throw KBase::KException("AgendaDAG::build: too many agendas to hold");
+    }
+
+    const uint32_t first = nodes.size();
+    nodes.reserve(nodes.size() + num);
+    for (auto& sp : splits) {
+      const uint32_t l0 = std::get<0>(std::get<0>(sp));
+      const uint32_t l1 = l0 + std::get<1>(std::get<0>(sp));
+      const uint32_t r0 = std::get<0>(std::get<1>(sp));
+      const uint32_t r1 = r0 + std::get<1>(std::get<1>(sp));
+      for (uint32_t la = l0; la < l1; la++) {
+        for (uint32_t ra = r0; ra < r1; ra++) {
+          nodes.push_back(Node{ la, ra });
+        }
+      }
+    }
+    auto rslt = tuple<uint32_t, uint32_t>(first, (uint32_t)num);
+    subsets[s] = rslt;
+    return rslt;
+  }
+
+
+  uint32_t AgendaDAG::agenda(uint64_t k) const {
+    assert(k < numRoots);
+    return firstRoot + ((uint32_t)k);
+  }
+
+
+  uint64_t AgendaDAG::memBytes() const {
+    uint64_t mb = sizeof(AgendaDAG);
+    mb = mb + nodes.capacity() * sizeof(Node);
+    mb = mb + subsets.size() * (sizeof(uint32_t) + sizeof(tuple<uint32_t, uint32_t>) + 2 * sizeof(void*));
+    for (auto& nv : nodeVal) {
+      mb = mb + nv.capacity() * sizeof(double);
+    }
+    return mb;
+  }
+
+
+  const vector<double> & AgendaDAG::evalAll(const KMatrix& val, unsigned int i) {
+    // the cache is only good for the value matrix it was built from
+    bool same = KBase::sameShape(val, cacheVal);
+    for (unsigned int k = 0; same && (k < val.numR()); k++) {
+      for (unsigned int j = 0; same && (j < val.numC()); j++) {
+        same = (val(k, j) == cacheVal(k, j));
+      }
+    }
+    if (!same) {
+      clearCache();
+      cacheVal = val;
+      nodeVal = vector<vector<double>>(val.numR());
+    }
+    assert(i < nodeVal.size());
+
+    vector<double> & nv = nodeVal[i];
+    if (nv.size() < nodes.size()) {
+      // children always precede their parents
+      nv.resize(nodes.size());
+      for (uint32_t a = 0; a < nodes.size(); a++) {
+        const Node & na = nodes[a];
+        if (NoNode == na.lhs) {
+          nv[a] = val(i, na.rhs);
+        }
+        else {
+          nv[a] = Choice::combine(nv[na.lhs], nv[na.rhs]);
+        }
+      }
+    }
+    return nv;
+  }
+
+
+  double AgendaDAG::eval(const KMatrix& val, unsigned int i, uint32_t a) {
+    assert(a < nodes.size());
+    return evalAll(val, i)[a];
+  }
+
+
+  void AgendaDAG::clearCache() {
+    cacheVal = KMatrix();
+    nodeVal = vector<vector<double>>();
+    return;
+  }
+
+
+  void AgendaDAG::print(ostream& os, uint32_t a) const {
+    assert(a < nodes.size());
+    const Node & na = nodes[a];
+    if (NoNode == na.lhs) {
+      os << na.rhs;
+    }
+    else {
+      os << "[";
+      print(os, na.lhs);
+      os << ":";
+      print(os, na.rhs);
+      os << "]";
+    }
+    return;
+  }
+
+
+  Agenda* AgendaDAG::toAgenda(uint32_t a) const {
+    assert(a < nodes.size());
+    const Node & na = nodes[a];
+    Agenda* ap = nullptr;
+    if (NoNode == na.lhs) {
+      ap = new Terminal(na.rhs);
+    }
+    else {
+      ap = new Choice(toAgenda(na.lhs), toAgenda(na.rhs));
+    }
+    return ap;
+  }
+
+}; // end of namespace
+
+// ------------------------------------------
+// Copyright KAPSARC. Open Source MIT License
+// ------------------------------------------
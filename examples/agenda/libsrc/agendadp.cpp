@@ -0,0 +1,195 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+// 
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom 
+// the Software is furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING 
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND 
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, 
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// Evaluate all agendas at once, by dynamic programming over subsets of items
+// --------------------------------------------
+#include <limits>
+
+#include "agenda.h"
+
+namespace AgendaControl {
+
+  AgendaDP::AgendaDP(unsigned int n, Agenda::PartitionRule pr) {
+    assert(0 < n);
+    assert(n <= MaxItems);
+    numItems = n;
+    rule = pr;
+
+    // Whether a split is allowed depends only on the sizes of the two sides.
+    // agendaSet always puts the smaller side on the left, so do the same here.
+    splitOK = vector<unsigned char>((n + 1)*(n + 1), 0);
+    for (unsigned int a = 1; a < n; a++) {
+      for (unsigned int b = 1; a + b <= n; b++) {
+        const unsigned int lo = (a < b) ? a : b;
+        const unsigned int hi = (a < b) ? b : a;
+        splitOK[a*(n + 1) + b] = Agenda::balancedLR(pr, lo, hi) ? 1 : 0;
+      }
+    }
+  }
+
+
+  double AgendaDP::numAgendas() const {
+    // every set of k items has the same number of agendas, cnt[k]
+    const unsigned int n = numItems;
+    auto cnt = vector<double>(n + 1, 0.0);
+    cnt[1] = 1.0;
+    for (unsigned int k = 2; k <= n; k++) {
+      // choose the left side as the i items including the first, so each
+      // unordered split is counted once
+      double ck = 0.0;
+      double chs = 1.0; // choose(k-1, i-1)
+      for (unsigned int i = 1; i < k; i++) {
+        if (splitOK[i*(n + 1) + (k - i)]) {
+          ck = ck + chs * cnt[i] * cnt[k - i];
+        }
+        chs = (chs * (k - i)) / i;
+      }
+      cnt[k] = ck;
+    }
+    return cnt[n];
+  }
+
+
+  void AgendaDP::eval(const KMatrix& val, unsigned int i) {
+    const unsigned int n = numItems;
+    assert(n == val.numC());
+    assert(i < val.numR());
+    const uint32_t ns = fullSet() + 1;
+    bestV = vector<double>(ns, 0.0);
+    worstV = vector<double>(ns, 0.0);
+    bestL = vector<uint32_t>(ns, 0);
+    worstL = vector<uint32_t>(ns, 0);
+
+    // the number of items in each subset
+    auto setSize = vector<unsigned char>(ns, 0);
+    for (uint32_t s = 1; s < ns; s++) {
+      setSize[s] = setSize[s >> 1] + (s & 1);
+    }
+
+    // Every proper subset of s is numerically smaller than s,
+    // so in increasing order the parts are always done before the whole.
+    for (uint32_t s = 1; s < ns; s++) {
+      const uint32_t low = s & (~s + 1); // lowest item in s
+      const uint32_t rest = s ^ low;
+      if (0 == rest) { // a single item
+        unsigned int item = setSize[low - 1];
+        bestV[s] = val(i, item);
+        worstV[s] = val(i, item);
+        continue;
+      }
+
+      const unsigned int sz = setSize[s];
+      double bv = -std::numeric_limits<double>::infinity();
+      double wv = +std::numeric_limits<double>::infinity();
+      uint32_t bl = 0;
+      uint32_t wl = 0;
+      // the left side holds the lowest item, and any part of the rest but all of it
+      uint32_t sub = rest;
+      while (true) {
+        sub = (sub - 1) & rest;
+        const uint32_t lhs = low | sub;
+        const uint32_t rhs = s ^ lhs;
+        const unsigned int nl = setSize[lhs];
+        if (splitOK[nl*(n + 1) + (sz - nl)]) {
+          const double b = Choice::combine(bestV[lhs], bestV[rhs]);
+          const double w = Choice::combine(worstV[lhs], worstV[rhs]);
+          if (bv < b) {
+            bv = b;
+            bl = lhs;
+          }
+          if (w < wv) {
+            wv = w;
+            wl = lhs;
+          }
+        }
+        if (0 == sub) {
+          break;
+        }
+      }
+      // If no split of s is allowed, s can only appear inside an agenda as part
+      // of a set which is itself not allowed, so it never gets used.
+      bestV[s] = bv;
+      worstV[s] = wv;
+      bestL[s] = bl;
+      worstL[s] = wl;
+    }
+    return;
+  }
+
+
+  double AgendaDP::best(uint32_t s) const {
+    assert(0 < s);
+    assert(s <= fullSet());
+    return bestV[s];
+  }
+
+
+  double AgendaDP::worst(uint32_t s) const {
+    assert(0 < s);
+    assert(s <= fullSet());
+    return worstV[s];
+  }
+
+
+  unsigned int AgendaDP::numBits(uint32_t s) {
+    unsigned int nb = 0;
+    while (0 != s) {
+      s = s & (s - 1);
+      nb++;
+    }
+    return nb;
+  }
+
+
+  Agenda* AgendaDP::buildAgenda(uint32_t s, const vector<uint32_t> & lhs) const {
+    assert(0 < s);
+    assert(lhs.size() == (size_t)fullSet() + 1); // eval must have been called
+    Agenda* a = nullptr;
+    if (0 == (s & (s - 1))) {
+      unsigned int item = 0;
+      while (0 == (s & (((uint32_t)1) << item))) {
+        item++;
+      }
+      a = new Terminal(item);
+    }
+    else {
+      const uint32_t ls = lhs[s];
+      assert(0 != ls); // otherwise, no split of s was allowed
+      // eval keeps the side with the lowest item, but the rule may need the
+      // sides the other way around (e.g. the single item on the left for SeqPR)
+      uint32_t ss = ls;
+      uint32_t rs = s ^ ls;
+      if (!Agenda::balancedLR(rule, numBits(ss), numBits(rs))) {
+        ss = rs;
+        rs = ls;
+      }
+      assert(Agenda::balancedLR(rule, numBits(ss), numBits(rs)));
+      a = new Choice(buildAgenda(ss, lhs), buildAgenda(rs, lhs));
+    }
+    return a;
+  }
+
+}; // end of namespace
+
+// ------------------------------------------
+// Copyright KAPSARC. Open Source MIT License
+// ------------------------------------------
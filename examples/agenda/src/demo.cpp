@@ -22,6 +22,7 @@
 // --------------------------------------------
 
 #include <assert.h> 
+#include <limits>
 
 #include "kutils.h"
 //#include "kmodel.h"
@@ -33,6 +34,7 @@ using std::flush;
 using std::vector;
 using KBase::KMatrix;
 using KBase::PRNG;
+using KBase::KException;
 
 namespace AgendaControl {
 
@@ -81,15 +83,13 @@ namespace AgendaControl {
     return;
   }
 
-  void bestAgendaChair(vector<Agenda*> ars, const KMatrix& vals, const KMatrix& caps) {
+  void bestAgendaChair(AgendaDAG& dag, const KMatrix& vals, const KMatrix& caps) {
     unsigned int bestK = 0;
     double bestV = -1.0;
     const double sigDiff = 1E-5; // utility is on [0,1] scale, differences less than this are insignificant
-    unsigned int numAgenda = ars.size();
+    unsigned int numAgenda = dag.numAgendas();
     for (unsigned int ai = 0; ai < numAgenda; ai++) {
-      auto ar = ars[ai];
-      ars.push_back(ar);
-      double v0 = ar->eval(vals, 0); //
+      double v0 = dag.eval(vals, 0, dag.agenda(ai));
       assert(0.0 <= v0);
       assert(v0 <= 1.0);
 
@@ -97,11 +97,48 @@ namespace AgendaControl {
         bestV = v0;
         bestK = ai;
       }
-      //  printf("%4u ", ai); cout << *ar << "  "; printf("%.4f \n", v0);
     }
     printf("Best option for agenda-setting actor 0 is %u with value %.4f  is  ", bestK, bestV);
-    cout << *(ars[bestK]) << endl << flush;
-    //ars[bestK]->showProbs(1.0);
+    dag.print(cout, dag.agenda(bestK));
+    cout << endl << flush;
+    return;
+  }
+
+  // The same search for the chair as bestAgendaChair, but by AgendaDP. With few
+  // enough items, the result is checked against evaluating every agenda.
+  void bestAgendaDP(unsigned int numItems, Agenda::PartitionRule pr, std::string name,
+                    const KMatrix& vals, unsigned int maxEnum) {
+    cout << endl;
+    auto dp = AgendaDP(numItems, pr);
+    printf("Evaluating all %.4g agendas (%s) over %u items ... \n",
+           dp.numAgendas(), name.c_str(), numItems);
+    dp.eval(vals, 0);
+    Agenda* ba = dp.bestAgenda();
+    Agenda* wa = dp.worstAgenda();
+    printf("Best option for agenda-setting actor 0 has value %.4f  is  ", dp.best());
+    cout << *ba << endl;
+    printf("Worst option for agenda-setting actor 0 has value %.4f  is  ", dp.worst());
+    cout << *wa << endl << flush;
+    assert(ba->eval(vals, 0) == dp.best());
+    assert(wa->eval(vals, 0) == dp.worst());
+    if (!(ba->balanced(pr) && wa->balanced(pr))) {
+      throw KException("bestAgendaDP: rebuilt agendas do not satisfy the partition rule");
+    }
+
+    if (numItems <= maxEnum) {
+      auto dag = AgendaDAG(numItems, pr);
+      double bv = -std::numeric_limits<double>::infinity();
+      double wv = +std::numeric_limits<double>::infinity();
+      for (uint64_t k = 0; k < dag.numAgendas(); k++) {
+        double v = dag.eval(vals, 0, dag.agenda(k));
+        bv = (bv < v) ? v : bv;
+        wv = (v < wv) ? v : wv;
+      }
+      printf("Enumeration of %u agendas agrees: %s \n", (unsigned int) dag.numAgendas(),
+             ((bv == dp.best()) && (wv == dp.worst()) && (dag.numAgendas() == dp.numAgendas())) ? "yes" : "NO");
+    }
+    delete ba;
+    delete wa;
     return;
   }
 
@@ -119,6 +156,29 @@ namespace AgendaControl {
       cout << endl << flush;
     }
     assert(cat.size() == AgendaControl::numSets(n, m));
+
+    // the same subsets, streamed as bitmasks in rank order
+    uint64_t numS = 0;
+    AgendaControl::forEachSubset(n, m, [&numS, m](uint64_t x) {
+      assert(AgendaControl::rankSubset(x) == numS);
+      assert(AgendaControl::unrankSubset(numS, m) == x);
+      numS++;
+      return;
+    });
+    assert(numS == cat.size());
+
+    // and in chooseSet's order
+    numS = 0;
+    AgendaControl::forEachSubsetLex(n, m, [&numS, &cat](uint64_t x) {
+      uint64_t y = 0;
+      for (auto i : cat[numS]) {
+        y = y | (((uint64_t)1) << i);
+      }
+      assert(x == y);
+      numS++;
+      return;
+    });
+    assert(numS == cat.size());
     cout << endl;
 
     VUI testI = {};
@@ -140,14 +200,16 @@ namespace AgendaControl {
     cout << endl << flush;
 
     auto enumAg = [numI](Agenda::PartitionRule pr, std::string s) {
-      vector<Agenda*> testA = Agenda::enumerateAgendas(numI, pr);
-      printf("For %i items, found %i distinct %s agendas \n", numI, testA.size(), s.c_str());
-      for (auto a : testA) {
-        cout << *a << endl;
+      auto testA = AgendaDAG(numI, pr);
+      printf("For %i items, found %llu distinct %s agendas \n", numI,
+             (unsigned long long) testA.numAgendas(), s.c_str());
+      for (uint64_t k = 0; k < testA.numAgendas(); k++) {
+        testA.print(cout, testA.agenda(k));
+        cout << endl;
       }
       cout << endl << flush;
       if (Agenda::PartitionRule::FreePR == pr) {
-        assert(testA.size() == AgendaControl::numAgenda(numI));
+        assert(testA.numAgendas() == AgendaControl::numAgenda(numI));
       }
       return;
     };
@@ -177,12 +239,14 @@ int main(int ac, char **av) {
   using AgendaControl::Agenda;
   using AgendaControl::Choice;
   using AgendaControl::Terminal;
+  using AgendaControl::AgendaDP;
 
   auto sTime = KBase::displayProgramStart();
   uint64_t dSeed = 0xD67CC16FE69C185C; // arbitrary
   uint64_t seed = dSeed;
   bool enumP = false;
   unsigned int enumN = 0;
+  bool dpP = false;
   bool run = true;
 
   auto showHelp = [dSeed]() {
@@ -190,6 +254,8 @@ int main(int ac, char **av) {
     printf("Usage: specify one or more of these options\n");
     printf("--help            print this message \n");
     printf("--enum <n>        enumerate various agendas over N items \n");
+    printf("--dp <n>          find the chair's best agendas over N items by dynamic programming,\n");
+    printf("                  without enumerating them (N up to %u) \n", AgendaDP::MaxItems);
     printf("--seed <n>        set 64bit seed to N \n");
     printf("                  0 means truly random\n");
     printf("                  default: %020llu \n", dSeed);
@@ -211,6 +277,12 @@ int main(int ac, char **av) {
         i++;
         enumN = std::stoi(av[i]);
       }
+      else if (strcmp(av[i], "--dp") == 0) {
+        dpP = true;
+        enumP = false;
+        i++;
+        enumN = std::stoi(av[i]);
+      }
       else if (strcmp(av[i], "--help") == 0) {
         run = false;
       }
@@ -266,20 +338,27 @@ int main(int ac, char **av) {
   auto enumA = [numItems, vals, caps](Agenda::PartitionRule pr, std::string name) {
     cout << endl;
     cout << "Enumerating all agendas ("<<name<<") over " << numItems << " items ... ";
-    auto ars = Agenda::enumerateAgendas(numItems, pr);
-    printf("found %i agendas \n", ars.size());
-    AgendaControl::bestAgendaChair(ars, vals, caps); 
-    for (auto ar : ars) {
-      delete ar;
-      ar = nullptr;
-    }
+    auto dag = AgendaControl::AgendaDAG(numItems, pr);
+    printf("found %llu agendas \n", (unsigned long long) dag.numAgendas());
+    printf("They share %llu distinct nodes, in %.1f KB \n",
+           (unsigned long long) dag.numNodes(), dag.memBytes() / 1024.0);
+    AgendaControl::bestAgendaChair(dag, vals, caps);
     return;
   };
 
-  enumA(Agenda::PartitionRule::FreePR, "FreePR");
-  enumA(Agenda::PartitionRule::SeqPR, "SeqPR");
-  enumA(Agenda::PartitionRule::ModBalancedPR, "MBPR");
-  enumA(Agenda::PartitionRule::FullBalancedPR , "FBPR");
+  if (dpP) {
+    const unsigned int maxEnum = 8;
+    AgendaControl::bestAgendaDP(numItems, Agenda::PartitionRule::FreePR, "FreePR", vals, maxEnum);
+    AgendaControl::bestAgendaDP(numItems, Agenda::PartitionRule::SeqPR, "SeqPR", vals, maxEnum);
+    AgendaControl::bestAgendaDP(numItems, Agenda::PartitionRule::ModBalancedPR, "MBPR", vals, maxEnum);
+    AgendaControl::bestAgendaDP(numItems, Agenda::PartitionRule::FullBalancedPR, "FBPR", vals, maxEnum);
+  }
+  else {
+    enumA(Agenda::PartitionRule::FreePR, "FreePR");
+    enumA(Agenda::PartitionRule::SeqPR, "SeqPR");
+    enumA(Agenda::PartitionRule::ModBalancedPR, "MBPR");
+    enumA(Agenda::PartitionRule::FullBalancedPR , "FBPR");
+  }
 
 
   delete rng;
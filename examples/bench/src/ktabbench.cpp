@@ -0,0 +1,714 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#include "ktabbench.h"
+
+
+// Count every heap allocation, so that benchmarks report allocations per
+// operation as well as time. The array forms call these by default.
+namespace {
+std::atomic<uint64_t> numAllocs(0);
+};
+
+void* operator new(size_t n) {
+    numAllocs++;
+    void* p = malloc((0 < n) ? n : 1);
+    if (nullptr == p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+
+namespace KTABBench {
+using std::cout;
+using std::endl;
+using std::flush;
+using std::get;
+using std::shared_ptr;
+
+using KBase::Model;
+using KBase::PCEModel;
+using KBase::VotingRule;
+using KBase::VPModel;
+
+using SMPLib::SMPModel;
+using SMPLib::SMPScenario;
+using SMPLib::SMPState;
+
+typedef vector<bool> BVec;
+
+volatile double benchSink = 0.0;
+
+// -------------------------------------------------
+
+// an SMP model with its initial utilities set, ready for BCN calculations
+shared_ptr<SMPModel> benchModel(PRNG* rng, unsigned int n, string dbName) {
+    const unsigned int nd = 3;
+    auto sc = SMPScenario::random(rng, n, nd);
+    auto md = shared_ptr<SMPModel>(SMPModel::initModel(sc, rng, "Bench", dbName));
+    md->rptLvl = ReportingLevel::Silent;
+    md->history[0]->setAUtil(-1, ReportingLevel::Silent);
+    return md;
+}
+
+// -------------------------------------------------
+
+vector<BenchCase> kutilsCases() {
+    auto cs = vector<BenchCase>();
+
+    auto bc = BenchCase();
+    bc.name = "KMatrix::mult";
+    bc.unit = "n-by-n times n-by-n";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto a = KMatrix::uniform(rng, n, n, -1.0, +1.0);
+        auto b = KMatrix::uniform(rng, n, n, -1.0, +1.0);
+        return function<void()>([a, b]() {
+            auto c = a * b;
+            benchSink = benchSink + c(0, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "KMatrix::inv";
+    bc.unit = "n-by-n inverse";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        // diagonally dominant, so it is well-conditioned
+        auto a = KMatrix::uniform(rng, n, n, -1.0, +1.0) + (2.0 * n) * KBase::iMat(n);
+        return function<void()>([a]() {
+            auto b = inv(a);
+            benchSink = benchSink + b(0, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "KMatrix::map";
+    bc.unit = "n-by-n map";
+    bc.maxN = 1000;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto a = KMatrix::uniform(rng, n, n, -1.0, +1.0);
+        return function<void()>([a, n]() {
+            auto b = KMatrix::map([&a](unsigned int i, unsigned int j) {
+                return a(i, j) * a(j, i);
+            }, n, n);
+            benchSink = benchSink + b(0, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    // several temporaries per operation, so it shows what copying costs
+    bc = BenchCase();
+    bc.name = "KMatrix::arith";
+    bc.unit = "n-by-n sums, scalings and transpose";
+    bc.maxN = 1000;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto a = KMatrix::uniform(rng, n, n, -1.0, +1.0);
+        auto b = KMatrix::uniform(rng, n, n, -1.0, +1.0);
+        return function<void()>([a, b]() {
+            auto c = (a + b) - (0.5 * a);
+            c = trans(c) / 2.0;
+            c = c + 1.0;
+            benchSink = benchSink + c(0, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "GAOpt::run";
+    bc.unit = "10 generations of n 64-bit genes";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        const unsigned int nb = 64;
+        const BVec trgt = rng->bits(nb);
+        auto wght = KMatrix::uniform(rng, nb, 1, 1.0, 10.0);
+        return function<void()>([n, nb, trgt, wght, rng]() {
+            KBase::GAOpt<BVec> ga(n);
+            ga.makeGene = [nb](PRNG* r) {
+                return new BVec(r->bits(nb));
+            };
+            ga.eval = [trgt, wght](const BVec* g) {
+                double s = 0;
+                for (unsigned int i = 0; i < trgt.size(); i++) {
+                    s = s + (((*g)[i] == trgt[i]) ? wght(i, 0) : 0.0);
+                }
+                return s;
+            };
+            ga.mutate = [](const BVec* g, PRNG* r) {
+                auto g2 = new BVec(*g);
+                const unsigned int i = r->uniform() % g2->size();
+                (*g2)[i] = !(*g2)[i];
+                return g2;
+            };
+            ga.cross = [](const BVec* g1, const BVec* g2, PRNG* r) {
+                const unsigned int cs = KBase::crossSite(r, g1->size());
+                auto h1 = new BVec(*g1);
+                auto h2 = new BVec(*g2);
+                for (unsigned int i = cs; i < g1->size(); i++) {
+                    (*h1)[i] = (*g2)[i];
+                    (*h2)[i] = (*g1)[i];
+                }
+                return tuple<BVec*, BVec*>(h1, h2);
+            };
+            ga.equiv = [](const BVec* g1, const BVec* g2) {
+                return ((*g1) == (*g2));
+            };
+            ga.showGene = [](const BVec* g) {
+                return;
+            };
+            ga.fill(rng);
+            unsigned int iter = 0;
+            unsigned int sIter = 0;
+            ga.run(rng, 1.0, 1.0, 10, 1E-12, 9, ReportingLevel::Silent, iter, sIter);
+            benchSink = benchSink + get<0>(ga.getNth(0));
+        });
+    };
+    cs.push_back(bc);
+
+    // the same problem, with the operators as lambdas known at compile time
+    bc = BenchCase();
+    bc.name = "GAOptT::run";
+    bc.unit = "10 generations of n 64-bit genes";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        const unsigned int nb = 64;
+        const BVec trgt = rng->bits(nb);
+        auto wght = KMatrix::uniform(rng, nb, 1, 1.0, 10.0);
+        return function<void()>([n, nb, trgt, wght, rng]() {
+            auto ops = KBase::makeGAOps<BVec>(
+            [trgt, wght](const BVec* g) {
+                double s = 0;
+                for (unsigned int i = 0; i < trgt.size(); i++) {
+                    s = s + (((*g)[i] == trgt[i]) ? wght(i, 0) : 0.0);
+                }
+                return s;
+            },
+            [](const BVec* g, PRNG* r) {
+                auto g2 = new BVec(*g);
+                const unsigned int i = r->uniform() % g2->size();
+                (*g2)[i] = !(*g2)[i];
+                return g2;
+            },
+            [](const BVec* g1, const BVec* g2, PRNG* r) {
+                const unsigned int cs = KBase::crossSite(r, g1->size());
+                auto h1 = new BVec(*g1);
+                auto h2 = new BVec(*g2);
+                for (unsigned int i = cs; i < g1->size(); i++) {
+                    (*h1)[i] = (*g2)[i];
+                    (*h2)[i] = (*g1)[i];
+                }
+                return tuple<BVec*, BVec*>(h1, h2);
+            },
+            [](const BVec* g1, const BVec* g2) {
+                return ((*g1) == (*g2));
+            },
+            [nb](PRNG* r) {
+                return new BVec(r->bits(nb));
+            },
+            [](const BVec* g) {
+                return;
+            });
+            KBase::GAOptT<BVec, decltype(ops)> ga(n, ops);
+            ga.fill(rng);
+            unsigned int iter = 0;
+            unsigned int sIter = 0;
+            ga.run(rng, 1.0, 1.0, 10, 1E-12, 9, ReportingLevel::Silent, iter, sIter);
+            benchSink = benchSink + get<0>(ga.getNth(0));
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "GHCSearch::run";
+    bc.unit = "10 iterations over n-bit strings";
+    bc.maxN = 1000;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        const BVec trgt = rng->bits(n);
+        const BVec p0 = rng->bits(n);
+        auto wght = KMatrix::uniform(rng, n, 1, 1.0, 10.0);
+        return function<void()>([trgt, p0, wght]() {
+            auto ghc = KBase::GHCSearch<BVec>();
+            ghc.eval = [trgt, wght](const BVec & bv) {
+                double s = 0;
+                for (unsigned int i = 0; i < trgt.size(); i++) {
+                    s = s + ((bv[i] == trgt[i]) ? wght(i, 0) : -wght(i, 0));
+                }
+                return s;
+            };
+            ghc.nghbrs = [](const BVec & bv) {
+                auto bvs = vector<BVec>();
+                for (unsigned int i = 0; i < bv.size(); i++) {
+                    auto b2 = bv;
+                    b2[i] = !b2[i];
+                    bvs.push_back(b2);
+                }
+                return bvs;
+            };
+            ghc.show = [](const BVec & bv) {
+                return;
+            };
+            auto rslt = ghc.run(p0, ReportingLevel::Silent, 10, 10, 1E-12);
+            benchSink = benchSink + get<0>(rslt);
+        });
+    };
+    cs.push_back(bc);
+
+    // the same problem, with the operators as lambdas known at compile time
+    bc = BenchCase();
+    bc.name = "GHCSearchT::run";
+    bc.unit = "10 iterations over n-bit strings";
+    bc.maxN = 1000;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        const BVec trgt = rng->bits(n);
+        const BVec p0 = rng->bits(n);
+        auto wght = KMatrix::uniform(rng, n, 1, 1.0, 10.0);
+        return function<void()>([trgt, p0, wght]() {
+            auto ghc = KBase::makeGHCSearch<BVec>(
+            [trgt, wght](const BVec & bv) {
+                double s = 0;
+                for (unsigned int i = 0; i < trgt.size(); i++) {
+                    s = s + ((bv[i] == trgt[i]) ? wght(i, 0) : -wght(i, 0));
+                }
+                return s;
+            },
+            [](const BVec & bv) {
+                auto bvs = vector<BVec>();
+                for (unsigned int i = 0; i < bv.size(); i++) {
+                    auto b2 = bv;
+                    b2[i] = !b2[i];
+                    bvs.push_back(b2);
+                }
+                return bvs;
+            },
+            [](const BVec & bv) {
+                return;
+            });
+            auto rslt = ghc.run(p0, ReportingLevel::Silent, 10, 10, 1E-12);
+            benchSink = benchSink + get<0>(rslt);
+        });
+    };
+    cs.push_back(bc);
+
+    return cs;
+}
+
+
+vector<BenchCase> kmodelCases() {
+    auto cs = vector<BenchCase>();
+    const VotingRule vr = VotingRule::Proportional;
+    const VPModel vpm = VPModel::Linear;
+
+    auto bc = BenchCase();
+    bc.name = "Model::vProb";
+    bc.unit = "n actors, n options";
+    bc.maxN = 300;
+    bc.setup = [vr, vpm](unsigned int n, PRNG* rng) {
+        auto w = KMatrix::uniform(rng, 1, n, 1.0, 10.0);
+        auto u = KMatrix::uniform(rng, n, n, 0.0, 1.0);
+        return function<void()>([w, u, vr, vpm]() {
+            auto pv = Model::vProb(vr, vpm, w, u);
+            benchSink = benchSink + pv(0, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "Model::vProbPairs";
+    bc.unit = "n actors, n options, packed";
+    bc.maxN = 300;
+    bc.setup = [vr, vpm](unsigned int n, PRNG* rng) {
+        auto w = KMatrix::uniform(rng, 1, n, 1.0, 10.0);
+        auto u = KMatrix::uniform(rng, n, n, 0.0, 1.0);
+        return function<void()>([w, u, vr, vpm]() {
+            auto pv = Model::vProbPairs(vr, vpm, w, u);
+            benchSink = benchSink + pv(1, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    // the two PCE models are protected, so go through Model::probCE
+    auto pceCase = [vr, vpm](string nm, PCEModel pcm, bool packed) {
+        auto bc = BenchCase();
+        bc.name = nm;
+        bc.unit = packed ? "n options, packed" : "n options";
+        bc.maxN = 300;
+        bc.setup = [vr, vpm, pcm, packed](unsigned int n, PRNG* rng) {
+            auto w = KMatrix::uniform(rng, 1, n, 1.0, 10.0);
+            auto u = KMatrix::uniform(rng, n, n, 0.0, 1.0);
+            if (packed) {
+                auto pp = Model::vProbPairs(vr, vpm, w, u);
+                return function<void()>([pp, pcm]() {
+                    auto p = Model::probCE(pcm, pp);
+                    benchSink = benchSink + p(0, 0);
+                });
+            }
+            auto pv = Model::vProb(vr, vpm, w, u);
+            return function<void()>([pv, pcm]() {
+                auto p = Model::probCE(pcm, pv);
+                benchSink = benchSink + p(0, 0);
+            });
+        };
+        return bc;
+    };
+    cs.push_back(pceCase("Model::markovPCE", PCEModel::MarkovPCM, false));
+    cs.push_back(pceCase("Model::condPCE", PCEModel::ConditionalPCM, false));
+    cs.push_back(pceCase("Model::markovPairs", PCEModel::MarkovPCM, true));
+    cs.push_back(pceCase("Model::condPairs", PCEModel::ConditionalPCM, true));
+
+    bc = BenchCase();
+    bc.name = "Model::scalarPCE";
+    bc.unit = "n actors, n options";
+    bc.maxN = 300;
+    bc.setup = [vr, vpm](unsigned int n, PRNG* rng) {
+        auto w = KMatrix::uniform(rng, 1, n, 1.0, 10.0);
+        auto u = KMatrix::uniform(rng, n, n, 0.0, 1.0);
+        return function<void()>([w, u, n, vr, vpm]() {
+            auto p = Model::scalarPCE(n, n, w, u, vr, vpm, ReportingLevel::Silent);
+            benchSink = benchSink + p(0, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "Model::sqlAUtil";
+    bc.unit = "n^3 rows inserted";
+    bc.maxN = 30;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        const string dbName = "ktabbench-sql.db";
+        remove(dbName.c_str());
+        auto md = benchModel(rng, n, dbName);
+        return function<void()>([md]() {
+            md->sqlAUtil(0);
+        });
+    };
+    cs.push_back(bc);
+
+    return cs;
+}
+
+
+vector<BenchCase> smpCases() {
+    auto cs = vector<BenchCase>();
+
+    auto bc = BenchCase();
+    bc.name = "SMPState::probEduChlg";
+    bc.unit = "n challenges";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto md = benchModel(rng, n, "");
+        return function<void()>([md, n]() {
+            auto st = ((const SMPState*)(md->history[0]));
+            for (unsigned int i = 0; i < n; i++) {
+                const unsigned int j = (i + 1) % n;
+                auto pe = st->probEduChlg(i, i, i, j);
+                benchSink = benchSink + get<1>(pe);
+            }
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "SMPState::setVDiff";
+    bc.unit = "n-by-n salience-weighted distances";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto md = benchModel(rng, n, "");
+        return function<void()>([md]() {
+            auto st = ((SMPState*)(md->history[0]));
+            st->setVDiff(); // vDiff is protected, so there is nothing to add to benchSink
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "SMPState::setVDiff(fp32)";
+    bc.unit = "n-by-n salience-weighted distances, in single precision";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto md = benchModel(rng, n, "");
+        md->singlePrec = true;
+        return function<void()>([md]() {
+            auto st = ((SMPState*)(md->history[0]));
+            st->setVDiff();
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "SMPState::pDist";
+    bc.unit = "n actors' probabilities, all perspectives";
+    bc.maxN = 100;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto md = benchModel(rng, n, "");
+        return function<void()>([md]() {
+            auto st = ((const SMPState*)(md->history[0]));
+            auto pn = st->pDist(-1);
+            benchSink = benchSink + get<0>(pn)(0, 0);
+        });
+    };
+    cs.push_back(bc);
+
+    bc = BenchCase();
+    bc.name = "SMPState::bestChallenge";
+    bc.unit = "one actor against n-1 others";
+    bc.maxN = 300;
+    bc.setup = [](unsigned int n, PRNG* rng) {
+        auto md = benchModel(rng, n, "");
+        auto next = shared_ptr<unsigned int>(new unsigned int(0));
+        return function<void()>([md, n, next]() {
+            auto st = ((const SMPState*)(md->history[0]));
+            auto bc = st->bestChallenge(*next);
+            *next = ((*next) + 1) % n;
+            benchSink = benchSink + get<2>(bc);
+        });
+    };
+    cs.push_back(bc);
+
+    return cs;
+}
+
+// -------------------------------------------------
+
+BenchRslt timeCase(const BenchCase & bc, unsigned int n, PRNG* rng,
+                   unsigned int minIters, double minSec) {
+    using std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    assert(0 < minIters);
+
+    auto t0 = steady_clock::now();
+    auto op = bc.setup(n, rng);
+    auto t1 = steady_clock::now();
+    op(); // warm the caches, untimed
+
+    auto ns = vector<double>();
+    ns.reserve(minIters + 1000); // so growing it rarely counts as the operation's
+    double tot = 0.0;
+    const uint64_t a0 = numAllocs.load();
+    while ((ns.size() < minIters) || (tot < minSec * 1.0E9)) {
+        auto ta = steady_clock::now();
+        op();
+        auto tb = steady_clock::now();
+        const double dt = duration_cast<nanoseconds>(tb - ta).count();
+        ns.push_back(dt);
+        tot = tot + dt;
+    }
+    const uint64_t a1 = numAllocs.load();
+
+    auto r = BenchRslt();
+    r.name = bc.name;
+    r.unit = bc.unit;
+    r.n = n;
+    r.iters = ns.size();
+    r.setupNs = duration_cast<nanoseconds>(t1 - t0).count();
+    std::sort(ns.begin(), ns.end());
+    r.meanNs = tot / r.iters;
+    r.medianNs = ns[r.iters / 2];
+    r.minNs = ns[0];
+    r.maxNs = ns[r.iters - 1];
+    r.p90Ns = ns[(9 * r.iters) / 10];
+    r.opsPerSec = (0 < tot) ? (1.0E9 * r.iters / tot) : 0.0;
+    r.allocsPerOp = ((double)(a1 - a0)) / r.iters;
+    return r;
+}
+
+
+void writeJSON(FILE* f, const vector<BenchRslt> & rslts, uint64_t seed,
+               unsigned int minIters, double minSec) {
+    std::time_t now = std::time(nullptr);
+    auto tBuff = KBase::newChars(50);
+    std::strftime(tBuff, 50, "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"tool\": \"ktabbench\",\n");
+    fprintf(f, "  \"date\": \"%s\",\n", tBuff);
+    fprintf(f, "  \"seed\": %llu,\n", (unsigned long long) seed);
+    fprintf(f, "  \"minIters\": %u,\n", minIters);
+    fprintf(f, "  \"minSec\": %.3f,\n", minSec);
+    fprintf(f, "  \"results\": [");
+    for (unsigned int i = 0; i < rslts.size(); i++) {
+        const BenchRslt & r = rslts[i];
+        fprintf(f, "%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"n\": %u, \"iters\": %u, ",
+                ((0 == i) ? "" : ","), r.name.c_str(), r.unit.c_str(), r.n, r.iters);
+        fprintf(f, "\"setupNs\": %.0f, \"meanNs\": %.1f, \"medianNs\": %.1f, \"minNs\": %.1f, ",
+                r.setupNs, r.meanNs, r.medianNs, r.minNs);
+        fprintf(f, "\"maxNs\": %.1f, \"p90Ns\": %.1f, \"opsPerSec\": %.3f, \"allocsPerOp\": %.1f}",
+                r.maxNs, r.p90Ns, r.opsPerSec, r.allocsPerOp);
+    }
+    fprintf(f, "\n  ]\n}\n");
+
+    delete[] tBuff;
+    tBuff = nullptr;
+    return;
+}
+
+}; // end of namespace
+
+
+int main(int ac, char **av) {
+    using std::cout;
+    using std::endl;
+    using std::flush;
+    using std::string;
+    using std::vector;
+    using KBase::PRNG;
+    using KTABBench::BenchCase;
+    using KTABBench::BenchRslt;
+
+    uint64_t seed = 0xB3C4D1A5E6F70819; // arbitrary
+    unsigned int minIters = 3;
+    double minSec = 0.25;
+    unsigned int maxN = 0; // 0 means use each case's own limit
+    string jsonFile = "ktabbench.json";
+    string filter = "";
+    auto sizes = KBase::VUI{ 10, 30, 100, 300, 1000 };
+    bool run = true;
+
+    auto showHelp = [seed]() {
+        printf("\n");
+        printf("Usage: specify one or more of these options\n");
+        printf("--help            print this message\n");
+        printf("--sizes <a,b,..>  problem sizes (default: 10,30,100,300,1000)\n");
+        printf("--maxN <n>        largest size for every case (default: each case has its own)\n");
+        printf("--filter <s>      run only cases whose names contain s\n");
+        printf("--iters <n>       minimum timed operations per size (default 3)\n");
+        printf("--minSec <x>      minimum timed seconds per size (default 0.25)\n");
+        printf("--json <f>        write results to file f (default ktabbench.json)\n");
+        printf("--seed <n>        set a 64bit seed\n");
+        printf("                  0 means truly random\n");
+        printf("                  default: %020llu \n", (unsigned long long) seed);
+    };
+
+    for (int i = 1; i < ac; i++) {
+        if ((strcmp(av[i], "--sizes") == 0) && (i + 1 < ac)) {
+            i++;
+            sizes = KBase::VUI();
+            char* tok = strtok(av[i], ",");
+            while (nullptr != tok) {
+                sizes.push_back(std::stoul(tok));
+                tok = strtok(nullptr, ",");
+            }
+        }
+        else if ((strcmp(av[i], "--maxN") == 0) && (i + 1 < ac)) {
+            i++;
+            maxN = std::stoul(av[i]);
+        }
+        else if ((strcmp(av[i], "--filter") == 0) && (i + 1 < ac)) {
+            i++;
+            filter = av[i];
+        }
+        else if ((strcmp(av[i], "--iters") == 0) && (i + 1 < ac)) {
+            i++;
+            minIters = std::stoul(av[i]);
+        }
+        else if ((strcmp(av[i], "--minSec") == 0) && (i + 1 < ac)) {
+            i++;
+            minSec = std::stod(av[i]);
+        }
+        else if ((strcmp(av[i], "--json") == 0) && (i + 1 < ac)) {
+            i++;
+            jsonFile = av[i];
+        }
+        else if ((strcmp(av[i], "--seed") == 0) && (i + 1 < ac)) {
+            i++;
+            seed = std::stoull(av[i]);
+        }
+        else if (strcmp(av[i], "--help") == 0) {
+            run = false;
+        }
+        else {
+            run = false;
+            printf("Unrecognized argument %s\n", av[i]);
+        }
+    }
+
+    if (!run) {
+        showHelp();
+        return 0;
+    }
+    if (0 == minIters) {
+        minIters = 1;
+    }
+
+    auto sTime = KBase::displayProgramStart();
+    PRNG * rng = new PRNG();
+    seed = rng->setSeed(seed); // 0 == get a random number
+    printf("Using PRNG seed:  %020llu \n", (unsigned long long) seed);
+
+    auto cases = vector<BenchCase>();
+    for (auto cs : { KTABBench::kutilsCases(), KTABBench::kmodelCases(), KTABBench::smpCases() }) {
+        for (auto bc : cs) {
+            if ((0 == filter.length()) || (string::npos != bc.name.find(filter))) {
+                cases.push_back(bc);
+            }
+        }
+    }
+
+    auto rslts = vector<BenchRslt>();
+    printf("%-24s %6s %7s %14s %14s %14s %12s \n", "Benchmark", "n", "iters",
+           "mean usec", "median usec", "ops/sec", "allocs/op");
+    for (auto& bc : cases) {
+        const unsigned int lim = (0 < maxN) ? maxN : bc.maxN;
+        for (auto n : sizes) {
+            if (lim < n) {
+                continue;
+            }
+            rng->setSeed(seed + n); // same problem, whatever else runs
+            auto r = KTABBench::timeCase(bc, n, rng, minIters, minSec);
+            printf("%-24s %6u %7u %14.2f %14.2f %14.2f %12.1f \n", r.name.c_str(), r.n, r.iters,
+                   r.meanNs / 1.0E3, r.medianNs / 1.0E3, r.opsPerSec, r.allocsPerOp);
+            cout << flush;
+            rslts.push_back(r);
+        }
+    }
+
+    FILE* f = fopen(jsonFile.c_str(), "w");
+    if (nullptr == f) {
+        printf("Could not open %s \n", jsonFile.c_str());
+    }
+    else {
+        KTABBench::writeJSON(f, rslts, seed, minIters, minSec);
+        fclose(f);
+        printf("Wrote %u results to %s \n", (unsigned int)rslts.size(), jsonFile.c_str());
+    }
+
+    delete rng;
+    rng = nullptr;
+    KBase::displayProgramEnd(sTime);
+    return 0;
+}
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
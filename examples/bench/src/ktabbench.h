@@ -0,0 +1,105 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+// Parameterized benchmarks of the kutils, kmodel and SMP kernels,
+// so that throughput and latency can be tracked across releases.
+// -------------------------------------------------
+#ifndef KTAB_BENCH_H
+#define KTAB_BENCH_H
+
+#include <assert.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "kutils.h"
+#include "prng.h"
+#include "kmatrix.h"
+#include "gaopt.h"
+#include "hcsearch.h"
+#include "kmodel.h"
+#include "smp.h"
+
+namespace KTABBench {
+// namespace to which KBase has no access
+
+using std::function;
+using std::string;
+using std::tuple;
+using std::vector;
+
+using KBase::KMatrix;
+using KBase::PRNG;
+using KBase::ReportingLevel;
+
+// One benchmark: setup(n, rng) builds whatever a problem of size n needs,
+// and returns the operation to be timed. Anything the operation needs
+// after setup returns must be captured by (shared) value.
+struct BenchCase {
+    string name = "";
+    string unit = ""; // what one operation does, for the report
+    unsigned int maxN = 1000; // largest default size, as some kernels are cubic
+    function<function<void()>(unsigned int n, PRNG* rng)> setup = nullptr;
+};
+
+struct BenchRslt {
+    string name = "";
+    string unit = "";
+    unsigned int n = 0;
+    unsigned int iters = 0;
+    double setupNs = 0;
+    double meanNs = 0;
+    double medianNs = 0;
+    double minNs = 0;
+    double maxNs = 0;
+    double p90Ns = 0;
+    double opsPerSec = 0;
+    double allocsPerOp = 0; // heap allocations per timed operation
+};
+
+vector<BenchCase> kutilsCases();
+vector<BenchCase> kmodelCases();
+vector<BenchCase> smpCases();
+
+// time repeated operations until both minIters and minSec are reached
+BenchRslt timeCase(const BenchCase & bc, unsigned int n, PRNG* rng,
+                   unsigned int minIters, double minSec);
+
+void writeJSON(FILE* f, const vector<BenchRslt> & rslts, uint64_t seed,
+               unsigned int minIters, double minSec);
+
+// results are added to this, so the optimizer cannot discard the work
+extern volatile double benchSink;
+
+}; // end of namespace
+
+// -------------------------------------------------
+#endif
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
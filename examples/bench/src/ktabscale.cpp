@@ -0,0 +1,382 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+//
+// Run whole SMP models over a grid of scenario sizes, recording the cost of
+// each turn, and fit the growth of those costs with the number of actors.
+//
+// --------------------------------------------
+
+#include <math.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "ktabbench.h"
+
+
+namespace KTABBench {
+using std::cout;
+using std::endl;
+using std::flush;
+using std::get;
+
+using KBase::State;
+using SMPLib::SMPModel;
+using SMPLib::SMPScenario;
+
+// what one turn of one run cost
+struct TurnRcd {
+    unsigned int numA = 0;
+    unsigned int numD = 0;
+    unsigned int turn = 0;
+    double turnNs = 0;
+    uint64_t peakRSS = 0; // bytes, for the whole process so far
+    uint64_t histBytes = 0;
+    uint64_t dbBytes = 0;
+};
+
+
+// peak resident set size of this process, in bytes (0 if not available)
+uint64_t peakRSS() {
+    uint64_t rss = 0;
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage ru;
+    if (0 == getrusage(RUSAGE_SELF, &ru)) {
+#if defined(__APPLE__)
+        rss = ru.ru_maxrss; // bytes
+#else
+        rss = 1024 * ((uint64_t) ru.ru_maxrss); // kilobytes
+#endif
+    }
+#endif
+    return rss;
+}
+
+
+vector<TurnRcd> runScaled(PRNG* rng, unsigned int numA, unsigned int numD, unsigned int numT,
+                          double sparsity, double skew, string dbName, unsigned int keepLast) {
+    using std::chrono::steady_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+
+    auto sc = SMPScenario::random(rng, numA, numD, sparsity, skew);
+    if (0 < dbName.length()) {
+        remove(dbName.c_str());
+    }
+    auto md = SMPModel::initModel(sc, rng, sc.name, dbName);
+    md->rptLvl = ReportingLevel::Silent;
+    if (0 < keepLast) {
+        md->histPolicy = KBase::HistoryPolicy::KeepFirstLast;
+        md->histLast = keepLast;
+    }
+
+    auto rcds = vector<TurnRcd>();
+    auto tLast = steady_clock::now();
+    // stop() is called once after each turn, so it is where we take the measurements
+    md->stop = [md, numA, numD, numT, &rcds, &tLast](unsigned int iter, const State* s) {
+        auto tNow = steady_clock::now();
+        auto r = TurnRcd();
+        r.numA = numA;
+        r.numD = numD;
+        r.turn = iter;
+        r.turnNs = duration_cast<nanoseconds>(tNow - tLast).count();
+        r.peakRSS = peakRSS();
+        for (auto st : md->history) {
+            r.histBytes = r.histBytes + ((nullptr != st) ? st->memBytes() : 0);
+        }
+        r.dbBytes = md->sqlBytes();
+        rcds.push_back(r);
+        tLast = steady_clock::now(); // do not charge the measurements to the next turn
+        return (numT <= iter);
+    };
+    tLast = steady_clock::now();
+    md->run();
+
+    delete md;
+    md = nullptr;
+    if (0 < dbName.length()) {
+        remove(dbName.c_str());
+    }
+    return rcds;
+}
+
+
+// least-squares slope of log(y) against log(x): the exponent k in y ~ x^k
+double logSlope(const vector<double> & x, const vector<double> & y) {
+    assert(x.size() == y.size());
+    const unsigned int n = x.size();
+    if (n < 2) {
+        return 0.0;
+    }
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        const double lx = log(x[i]);
+        const double ly = log((0 < y[i]) ? y[i] : 1.0);
+        sx = sx + lx;
+        sy = sy + ly;
+        sxx = sxx + lx * lx;
+        sxy = sxy + lx * ly;
+    }
+    const double d = (n * sxx) - (sx * sx);
+    return (0 < d) ? (((n * sxy) - (sx * sy)) / d) : 0.0;
+}
+
+}; // end of namespace
+
+
+int main(int ac, char **av) {
+    using std::cout;
+    using std::endl;
+    using std::flush;
+    using std::string;
+    using std::vector;
+    using KBase::PRNG;
+    using KBase::VUI;
+    using KTABBench::TurnRcd;
+
+    uint64_t seed = 0x5CA1AB1E0DDBA11; // arbitrary
+    auto actors = VUI{ 10, 20, 40, 80 };
+    auto dims = VUI{ 2, 4 };
+    unsigned int numT = 5;
+    double sparsity = 0.0;
+    double skew = 1.0;
+    unsigned int keepLast = 0;
+    string jsonFile = "ktabscale.json";
+    string csvFile = "ktabscale.csv";
+    string dbName = "ktabscale.db";
+    double maxSlope = 0.0; // 0 means do not check
+    bool run = true;
+
+    auto parseList = [](char* s) {
+        auto v = VUI();
+        char* tok = strtok(s, ",");
+        while (nullptr != tok) {
+            v.push_back(std::stoul(tok));
+            tok = strtok(nullptr, ",");
+        }
+        return v;
+    };
+
+    auto showHelp = [seed]() {
+        printf("\n");
+        printf("Usage: specify one or more of these options\n");
+        printf("--help             print this message\n");
+        printf("--actors <a,b,..>  numbers of actors (default: 10,20,40,80)\n");
+        printf("--dims <a,b,..>    numbers of dimensions (default: 2,4)\n");
+        printf("--turns <n>        turns per run (default 5)\n");
+        printf("--sparsity <x>     chance an actor ignores a dimension (default 0)\n");
+        printf("--skew <x>         capability skew, 0 is equal, 1 uniform (default 1)\n");
+        printf("--noDB             do not record to SQLite\n");
+        printf("--keep <k>         keep only the first two and last k states in memory (default: all)\n");
+        printf("--json <f>         write the summary and fitted exponents to f (default ktabscale.json)\n");
+        printf("--csv <f>          write every turn to f (default ktabscale.csv)\n");
+        printf("--maxSlope <x>     exit with status 1 if time per turn grows faster than numAct^x\n");
+        printf("--seed <n>         set a 64bit seed\n");
+        printf("                   0 means truly random\n");
+        printf("                   default: %020llu \n", (unsigned long long) seed);
+    };
+
+    for (int i = 1; i < ac; i++) {
+        if ((strcmp(av[i], "--actors") == 0) && (i + 1 < ac)) {
+            i++;
+            actors = parseList(av[i]);
+        }
+        else if ((strcmp(av[i], "--dims") == 0) && (i + 1 < ac)) {
+            i++;
+            dims = parseList(av[i]);
+        }
+        else if ((strcmp(av[i], "--turns") == 0) && (i + 1 < ac)) {
+            i++;
+            numT = std::stoul(av[i]);
+        }
+        else if ((strcmp(av[i], "--sparsity") == 0) && (i + 1 < ac)) {
+            i++;
+            sparsity = std::stod(av[i]);
+        }
+        else if ((strcmp(av[i], "--skew") == 0) && (i + 1 < ac)) {
+            i++;
+            skew = std::stod(av[i]);
+        }
+        else if ((strcmp(av[i], "--keep") == 0) && (i + 1 < ac)) {
+            i++;
+            keepLast = std::stoul(av[i]);
+        }
+        else if (strcmp(av[i], "--noDB") == 0) {
+            dbName = "";
+        }
+        else if ((strcmp(av[i], "--json") == 0) && (i + 1 < ac)) {
+            i++;
+            jsonFile = av[i];
+        }
+        else if ((strcmp(av[i], "--csv") == 0) && (i + 1 < ac)) {
+            i++;
+            csvFile = av[i];
+        }
+        else if ((strcmp(av[i], "--maxSlope") == 0) && (i + 1 < ac)) {
+            i++;
+            maxSlope = std::stod(av[i]);
+        }
+        else if ((strcmp(av[i], "--seed") == 0) && (i + 1 < ac)) {
+            i++;
+            seed = std::stoull(av[i]);
+        }
+        else if (strcmp(av[i], "--help") == 0) {
+            run = false;
+        }
+        else {
+            run = false;
+            printf("Unrecognized argument %s\n", av[i]);
+        }
+    }
+
+    if (!run) {
+        showHelp();
+        return 0;
+    }
+    if (0 == numT) {
+        numT = 1;
+    }
+
+    auto sTime = KBase::displayProgramStart();
+    PRNG * rng = new PRNG();
+    seed = rng->setSeed(seed); // 0 == get a random number
+    printf("Using PRNG seed:  %020llu \n", (unsigned long long) seed);
+
+    // every turn of every run, and the mean of each run
+    auto rcds = vector<TurnRcd>();
+    auto means = vector<TurnRcd>();
+    for (auto nd : dims) {
+        for (auto na : actors) {
+            rng->setSeed(seed + (1000 * nd) + na); // same scenario, whatever else runs
+            auto rs = KTABBench::runScaled(rng, na, nd, numT, sparsity, skew, dbName, keepLast);
+            auto m = TurnRcd();
+            m.numA = na;
+            m.numD = nd;
+            m.turn = rs.size();
+            for (auto& r : rs) {
+                m.turnNs = m.turnNs + (r.turnNs / rs.size());
+                rcds.push_back(r);
+            }
+            m.peakRSS = rs.back().peakRSS;
+            m.histBytes = rs.back().histBytes;
+            m.dbBytes = rs.back().dbBytes;
+            means.push_back(m);
+            printf("%4u actors %3u dims: %3u turns, %12.3f msec/turn, history %10llu bytes, DB %10llu bytes \n",
+                   na, nd, m.turn, m.turnNs / 1.0E6,
+                   (unsigned long long) m.histBytes, (unsigned long long) m.dbBytes);
+            cout << flush;
+        }
+    }
+
+    // fit the growth with numAct, separately for each number of dimensions
+    auto slopeT = vector<double>();
+    auto slopeH = vector<double>();
+    auto slopeD = vector<double>();
+    for (auto nd : dims) {
+        auto x = vector<double>();
+        auto yT = vector<double>();
+        auto yH = vector<double>();
+        auto yD = vector<double>();
+        for (auto& m : means) {
+            if (nd == m.numD) {
+                x.push_back(m.numA);
+                yT.push_back(m.turnNs);
+                yH.push_back(m.histBytes / ((double) m.turn));
+                yD.push_back(m.dbBytes / ((double) m.turn));
+            }
+        }
+        slopeT.push_back(KTABBench::logSlope(x, yT));
+        slopeH.push_back(KTABBench::logSlope(x, yH));
+        slopeD.push_back(KTABBench::logSlope(x, yD));
+    }
+
+    cout << endl << "Growth with number of actors, as the exponent k in cost ~ numAct^k" << endl;
+    printf("%6s %10s %12s %10s \n", "dims", "time/turn", "history", "database");
+    bool tooSteep = false;
+    for (unsigned int k = 0; k < dims.size(); k++) {
+        printf("%6u %10.2f %12.2f %10.2f \n", dims[k], slopeT[k], slopeH[k], slopeD[k]);
+        if ((0 < maxSlope) && (maxSlope < slopeT[k])) {
+            tooSteep = true;
+        }
+    }
+    cout << endl << flush;
+
+    if (0 < csvFile.length()) {
+        FILE* f = fopen(csvFile.c_str(), "w");
+        if (nullptr != f) {
+            fprintf(f, "NumAct,NumDim,Turn,TurnNs,PeakRSS,HistBytes,DBBytes\n");
+            for (auto& r : rcds) {
+                fprintf(f, "%u,%u,%u,%.0f,%llu,%llu,%llu\n", r.numA, r.numD, r.turn, r.turnNs,
+                        (unsigned long long) r.peakRSS, (unsigned long long) r.histBytes,
+                        (unsigned long long) r.dbBytes);
+            }
+            fclose(f);
+            printf("Wrote %u turns to %s \n", (unsigned int) rcds.size(), csvFile.c_str());
+        }
+    }
+
+    if (0 < jsonFile.length()) {
+        FILE* f = fopen(jsonFile.c_str(), "w");
+        if (nullptr != f) {
+            fprintf(f, "{\n");
+            fprintf(f, "  \"tool\": \"ktabscale\",\n");
+            fprintf(f, "  \"seed\": %llu,\n", (unsigned long long) seed);
+            fprintf(f, "  \"turns\": %u,\n", numT);
+            fprintf(f, "  \"sparsity\": %.3f,\n", sparsity);
+            fprintf(f, "  \"skew\": %.3f,\n", skew);
+            fprintf(f, "  \"runs\": [");
+            for (unsigned int i = 0; i < means.size(); i++) {
+                const TurnRcd & m = means[i];
+                fprintf(f, "%s\n    {\"numAct\": %u, \"numDim\": %u, \"turns\": %u, \"meanTurnNs\": %.0f, ",
+                        ((0 == i) ? "" : ","), m.numA, m.numD, m.turn, m.turnNs);
+                fprintf(f, "\"peakRSS\": %llu, \"histBytes\": %llu, \"dbBytes\": %llu}",
+                        (unsigned long long) m.peakRSS, (unsigned long long) m.histBytes,
+                        (unsigned long long) m.dbBytes);
+            }
+            fprintf(f, "\n  ],\n");
+            fprintf(f, "  \"exponents\": [");
+            for (unsigned int k = 0; k < dims.size(); k++) {
+                fprintf(f, "%s\n    {\"numDim\": %u, \"turnNs\": %.3f, \"histBytesPerTurn\": %.3f, \"dbBytesPerTurn\": %.3f}",
+                        ((0 == k) ? "" : ","), dims[k], slopeT[k], slopeH[k], slopeD[k]);
+            }
+            fprintf(f, "\n  ]\n}\n");
+            fclose(f);
+            printf("Wrote summary to %s \n", jsonFile.c_str());
+        }
+    }
+
+    delete rng;
+    rng = nullptr;
+    KBase::displayProgramEnd(sTime);
+
+    if (tooSteep) {
+        printf("Time per turn grows faster than numAct^%.2f \n", maxSlope);
+        return 1;
+    }
+    return 0;
+}
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -21,14 +21,71 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // --------------------------------------------
 
+#include <algorithm>
+#include <math.h>
+
 #include "comsel.h"
+#include "emodel.cpp"
+#include "hcsearch.h"
+
+// instantiate all of them here, so users of the library need only the header
+template class KBase::EModel<ComSelLib::Committee>;
+template class KBase::EState<ComSelLib::Committee>;
 
 namespace ComSelLib {
+  using std::get;
+  using KBase::KView;
+  using KBase::KCView;
+  using KBase::VPModel;
+  using KBase::EPosition;
+  using KBase::GHCSearch;
+  using KBase::klogf;
+
+
+  CSActor::CSActor(string n, string d) : Actor(n, d) {
+    // nothing yet
+  }
 
 
-  CSModel::CSModel(unsigned int np, unsigned int nd, PRNG* r, string d) : Model(r, d) {
+  CSActor::~CSActor() {
+    // nothing yet
+  }
+
 
+  void CSActor::randomize(PRNG* rng, unsigned int numD) {
+    sCap = rng->uniform(10.0, 200.0);
+    vPos = KMatrix::uniform(rng, numD, 1, 0.0, 1.0);
+
+    // assign an overall salience, and then by-component saliences
+    double s = rng->uniform(0.75, 0.99);
+    vSal = KMatrix::uniform(rng, numD, 1, 0.1, 1.0);
+    vSal = (s * vSal) / sum(vSal);
+    assert(fabs(s - sum(vSal)) < 1E-4);
+
+    vr = VotingRule::Proportional;
+    return;
+  }
+
+
+  double CSActor::vote(unsigned int p1, unsigned int p2, const State* st) const {
+    auto cs = (const CSState*)st;
+    auto csm = (const CSModel*)(cs->model);
+    const int ai = csm->actrNdx(this);
+    assert(0 <= ai);
+    const double u1 = csm->commUtil(ai, cs->posCommittee(p1));
+    const double u2 = csm->commUtil(ai, cs->posCommittee(p2));
+    return Model::vote(vr, sCap, u1, u2);
+  }
+
+  // --------------------------------------------
+
+  CSModel::CSModel(unsigned int np, unsigned int nd, PRNG* r, string d) : KBase::EModel<Committee>(r, d) {
+
+    if ((np < 2) || (MaxCandidates < np)) {
+      throw KBase::KException("CSModel: number of candidates out of range");
+    }
     assert (np > 1);
+    assert (np <= MaxCandidates);
     assert (nd > 0);
 
     numPrty = np;
@@ -40,8 +97,462 @@ namespace ComSelLib {
     // nothing yet
   }
 
-};
-// end of namespace
+
+  void CSModel::setCommittees() {
+    assert(numPrty == numAct);
+    totCap = 0.0;
+    caps = vector<double>(numPrty, 0.0);
+    wPos = vector<double>(numPrty * numDims, 0.0);
+    aPos = vector<double>(numPrty * numDims, 0.0);
+    aSal = vector<double>(numPrty * numDims, 0.0);
+    for (unsigned int m = 0; m < numPrty; m++) {
+      auto am = (const CSActor*)(actrs[m]);
+      assert(numDims == am->vPos.numR());
+      assert(numDims == am->vSal.numR());
+      caps[m] = am->sCap;
+      totCap = totCap + am->sCap;
+      for (unsigned int d = 0; d < numDims; d++) {
+        wPos[m*numDims + d] = am->sCap * am->vPos(d, 0);
+        aPos[m*numDims + d] = am->vPos(d, 0);
+        aSal[m*numDims + d] = am->vSal(d, 0);
+      }
+    }
+
+    optionCount = ((uint64_t)1) << numPrty;
+    makeOption = grayCode;
+    numThreads = 0; // chunkValues may be called on every core at once
+    setOptions();
+    return;
+  }
+
+
+  uint64_t CSModel::grayRank(Committee c) {
+    uint64_t j = c;
+    for (unsigned int s = 1; s < 64; s = 2 * s) {
+      j = j ^ (j >> s);
+    }
+    return j;
+  }
+
+
+  bool CSModel::seated(Committee c) const {
+    double cSum = 0.0;
+    for (unsigned int m = 0; m < numPrty; m++) {
+      if (0 != (c & (((Committee)1) << m))) {
+        cSum = cSum + caps[m];
+      }
+    }
+    return (quorum * totCap < cSum);
+  }
+
+
+  KMatrix CSModel::policy(Committee c) const {
+    assert(0 != c);
+    auto p = KMatrix(numDims, 1);
+    double cSum = 0.0;
+    for (unsigned int m = 0; m < numPrty; m++) {
+      if (0 != (c & (((Committee)1) << m))) {
+        cSum = cSum + caps[m];
+        for (unsigned int d = 0; d < numDims; d++) {
+          p(d, 0) = p(d, 0) + wPos[m*numDims + d];
+        }
+      }
+    }
+    return p / cSum;
+  }
+
+
+  double CSModel::commUtil(unsigned int i, Committee c) const {
+    assert(i < numPrty);
+    if ((0 == c) || (!seated(c))) {
+      return 0.0;
+    }
+    const KMatrix p = policy(c);
+    double d2 = 0.0;
+    for (unsigned int d = 0; d < numDims; d++) {
+      const double dd = aPos[i*numDims + d] - p(d, 0);
+      d2 = d2 + aSal[i*numDims + d] * dd * dd;
+    }
+    return 1.0 - sqrt(d2);
+  }
+
+
+  KMatrix CSModel::commUtils(Committee c) const {
+    auto u = KMatrix(1, numPrty);
+    if ((0 == c) || (!seated(c))) {
+      return u;
+    }
+    auto wSum = vector<double>(numDims, 0.0);
+    double cSum = 0.0;
+    for (unsigned int m = 0; m < numPrty; m++) {
+      if (0 != (c & (((Committee)1) << m))) {
+        cSum = cSum + caps[m];
+        for (unsigned int d = 0; d < numDims; d++) {
+          wSum[d] = wSum[d] + wPos[m*numDims + d];
+        }
+      }
+    }
+    policyValues(wSum.data(), cSum, KView(u));
+    return u;
+  }
+
+
+  vector<Committee> CSModel::nghbrs(Committee c) const {
+    auto ns = vector<Committee>();
+    for (unsigned int m = 0; m < numPrty; m++) {
+      const Committee bm = ((Committee)1) << m;
+      ns.push_back(c ^ bm);
+      if (0 != (c & bm)) {
+        for (unsigned int k = 0; k < numPrty; k++) {
+          const Committee bk = ((Committee)1) << k;
+          if (0 == (c & bk)) {
+            ns.push_back(c ^ bm ^ bk);
+          }
+        }
+      }
+    }
+    return ns;
+  }
+
+
+  double CSModel::idealDist(unsigned int i, unsigned int m) const {
+    assert(i < numPrty);
+    assert(m < numPrty);
+    double d2 = 0.0;
+    for (unsigned int d = 0; d < numDims; d++) {
+      const double dd = aPos[i*numDims + d] - aPos[m*numDims + d];
+      d2 = d2 + aSal[i*numDims + d] * dd * dd;
+    }
+    return sqrt(d2);
+  }
+
+
+  MtchPstn CSModel::mtchPstn(Committee c) const {
+    auto mp = MtchPstn();
+    mp.numItm = numPrty;
+    mp.numCat = 2;
+    mp.match = VUI(numPrty, 0);
+    for (unsigned int m = 0; m < numPrty; m++) {
+      mp.match[m] = (0 != (c & (((Committee)1) << m))) ? 1 : 0;
+    }
+    return mp;
+  }
+
+
+  void CSModel::policyValues(const double* wSum, double cSum, KView vals) const {
+    // same arithmetic as commUtil, without building the policy
+    const double invC = 1.0 / cSum;
+    for (unsigned int i = 0; i < numPrty; i++) {
+      const double* pi = &aPos[i*numDims];
+      const double* si = &aSal[i*numDims];
+      double d2 = 0.0;
+      for (unsigned int d = 0; d < numDims; d++) {
+        const double dd = pi[d] - (wSum[d] * invC);
+        d2 = d2 + si[d] * dd * dd;
+      }
+      vals(0, i) = 1.0 - sqrt(d2);
+    }
+    return;
+  }
+
+
+  void CSModel::chunkValues(const vector<Committee> & cs, KView vals) const {
+    const unsigned int nc = cs.size();
+    assert(nc == vals.numR());
+    assert(numPrty == vals.numC());
+    auto wSum = vector<double>(numDims, 0.0);
+    double cSum = 0.0;
+    for (unsigned int k = 0; k < nc; k++) {
+      const Committee c = cs[k];
+      const Committee diff = (0 == k) ? 0 : (c ^ cs[k - 1]);
+      if ((0 != diff) && (0 == (diff & (diff - 1)))) {
+        // one member joined or left
+        unsigned int m = 0;
+        while (diff != (((Committee)1) << m)) {
+          m++;
+        }
+        const double sgn = (0 != (c & diff)) ? +1.0 : -1.0;
+        cSum = cSum + sgn * caps[m];
+        for (unsigned int d = 0; d < numDims; d++) {
+          wSum[d] = wSum[d] + sgn * wPos[m*numDims + d];
+        }
+      }
+      else {
+        cSum = 0.0;
+        for (unsigned int d = 0; d < numDims; d++) {
+          wSum[d] = 0.0;
+        }
+        for (unsigned int m = 0; m < numPrty; m++) {
+          if (0 != (c & (((Committee)1) << m))) {
+            cSum = cSum + caps[m];
+            for (unsigned int d = 0; d < numDims; d++) {
+              wSum[d] = wSum[d] + wPos[m*numDims + d];
+            }
+          }
+        }
+      }
+
+      KView vk = vals.row(k);
+      if ((0 == c) || (cSum <= quorum * totCap)) { // not seated, so no policy at all
+        for (unsigned int i = 0; i < numPrty; i++) {
+          vk(0, i) = 0.0;
+        }
+      }
+      else {
+        policyValues(wSum.data(), cSum, vk);
+      }
+    }
+    return;
+  }
+
+  // --------------------------------------------
+
+  CSState::CSState(CSModel* m) : KBase::EState<Committee>(m) {
+    chunkVFn = [m](uint64_t j0, const vector<Committee> & cs, KView vals) {
+      m->chunkValues(cs, vals);
+      return;
+    };
+
+    // everyone knows everyone's utilities, so all the estimates are the same
+    getAUtils = [this, m]() {
+      const unsigned int na = m->numAct;
+      auto u = KMatrix(na, na);
+      for (unsigned int j = 0; j < na; j++) {
+        const Committee cj = posCommittee(j);
+        for (unsigned int i = 0; i < na; i++) {
+          u(i, j) = m->commUtil(i, cj);
+        }
+      }
+      return vector<KMatrix>(na, u);
+    };
+  }
+
+
+  CSState::~CSState() {
+    // nothing yet
+  }
+
+
+  Committee CSState::posCommittee(unsigned int i) const {
+    return CSModel::grayCode(posNdx(i));
+  }
+
+
+  bool CSState::equivNdx(unsigned int i, unsigned int j) const {
+    return (posCommittee(i) == posCommittee(j));
+  }
+
+
+  tuple< KMatrix, VUI> CSState::pDist(int persp) const {
+    const unsigned int na = model->numAct;
+    assert(na == aUtil.size()); // must have been filled in
+    assert(persp < ((int)na));
+    assert(0 < uIndices.size()); // should have been set with setUENdx();
+    const unsigned int h = (0 <= persp) ? persp : 0; // all the same
+
+    auto w = KMatrix(1, na);
+    for (unsigned int i = 0; i < na; i++) {
+      w(0, i) = ((const CSActor*)(model->actrs[i]))->sCap;
+    }
+    auto uufn = [this, h](unsigned int i, unsigned int j) {
+      return aUtil[h](i, uIndices[j]);
+    };
+    auto uUij = KMatrix::map(uufn, na, uIndices.size());
+    auto upd = Model::scalarPCE(na, uIndices.size(), w, uUij,
+                                VotingRule::Proportional, VPModel::Linear, ReportingLevel::Silent);
+    return tuple< KMatrix, VUI>(upd, uIndices);
+  }
+
+
+  void CSState::evalCommittees(unsigned int numTop, ReportingLevel rl) {
+    auto csm = (CSModel*)model;
+    const unsigned int na = csm->numAct;
+    assert(0 == pstns.size());
+
+    auto favs = vector<Committee>();
+    auto top = vector<Committee>();
+    if (na <= CSModel::MaxEnumCandidates) {
+      enumCommittees(numTop, favs, top);
+    }
+    else {
+      searchCommittees(numTop, favs, top);
+    }
+    assert(na == favs.size());
+
+    // each actor advocates its favorite committee
+    for (unsigned int i = 0; i < na; i++) {
+      addPstn(new EPosition<Committee>(csm, CSModel::grayRank(favs[i])));
+    }
+    setAUtil(-1, rl);
+    setUENdx();
+
+    shortList = {};
+    auto addShort = [this](Committee c) {
+      if (shortList.end() == std::find(shortList.begin(), shortList.end(), c)) {
+        shortList.push_back(c);
+      }
+      return;
+    };
+    for (unsigned int i = 0; i < na; i++) {
+      addShort(posCommittee(i));
+    }
+    for (auto c : top) {
+      addShort(c);
+    }
+
+    auto w = KMatrix(1, na);
+    for (unsigned int i = 0; i < na; i++) {
+      w(0, i) = ((const CSActor*)(csm->actrs[i]))->sCap;
+    }
+    const unsigned int ns = shortList.size();
+    auto u = KMatrix::map([this, csm](unsigned int i, unsigned int j) {
+      return csm->commUtil(i, shortList[j]);
+    }, na, ns);
+    shortProb = Model::scalarPCE(na, ns, w, u, VotingRule::Proportional, VPModel::Linear, rl);
+
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+      klogf("Shortlist of %u committees, out of %llu: \n", ns, (unsigned long long)csm->numOptions());
+      for (unsigned int j = 0; j < ns; j++) {
+        klogf("%3u  %.4f  ", j, shortProb(j, 0));
+        for (unsigned int m = 0; m < na; m++) {
+          klogf("%c", (0 != (shortList[j] & (((Committee)1) << m))) ? 'X' : '.');
+        }
+        klogf(" \n");
+      }
+    }
+    return;
+  }
+
+
+  void CSState::enumCommittees(unsigned int numTop, vector<Committee> & favs, vector<Committee> & top) {
+    auto csm = (CSModel*)model;
+    const unsigned int na = csm->numAct;
+    auto wv = vector<double>(na, 0.0);
+    for (unsigned int i = 0; i < na; i++) {
+      wv[i] = ((const CSActor*)(csm->actrs[i]))->sCap;
+    }
+
+    // Keep the numTop committees of greatest total weighted utility, best first.
+    // Chunks arrive in no particular order, so ties go to the lower index.
+    auto tops = vector<tuple<double, uint64_t>>();
+    auto better = [](double s1, uint64_t j1, const tuple<double, uint64_t> & t2) {
+      return (get<0>(t2) < s1) || ((s1 == get<0>(t2)) && (j1 < get<1>(t2)));
+    };
+    useValues = [&tops, &wv, &better, numTop, na](uint64_t j0, KCView vals) {
+      for (unsigned int k = 0; k < vals.numR(); k++) {
+        double s = 0.0;
+        for (unsigned int i = 0; i < na; i++) {
+          s = s + wv[i] * vals(k, i);
+        }
+        const uint64_t j = j0 + k;
+        if ((tops.size() < numTop) || better(s, j, tops.back())) {
+          auto pos = tops.begin();
+          while ((pos != tops.end()) && (!better(s, j, *pos))) {
+            pos++;
+          }
+          tops.insert(pos, tuple<double, uint64_t>(s, j));
+          if (numTop < tops.size()) {
+            tops.pop_back();
+          }
+        }
+      }
+      return;
+    };
+    setValues();
+    useValues = nullptr;
+    numEvals = csm->numOptions();
+
+    for (unsigned int i = 0; i < na; i++) {
+      favs.push_back(csm->option(bestOption(i)));
+    }
+    for (auto& t : tops) {
+      top.push_back(csm->option(get<1>(t)));
+    }
+    return;
+  }
+
+
+  void CSState::searchCommittees(unsigned int numTop, vector<Committee> & favs, vector<Committee> & top) {
+    auto csm = (CSModel*)model;
+    const unsigned int na = csm->numAct;
+    numEvals = 0;
+    auto wv = vector<double>(na, 0.0);
+    for (unsigned int i = 0; i < na; i++) {
+      wv[i] = ((const CSActor*)(csm->actrs[i]))->sCap;
+    }
+    const Committee all = (((Committee)1) << na) - 1; // always seated
+
+    // Each neighbor is evaluated afresh, but that is only O(numPrty*numDims).
+    // With no randomness in the neighbors, one stable step means a local optimum.
+    const unsigned int iMax = 10 * na;
+    const unsigned int sMax = 1;
+    const double sTol = 1E-10;
+    auto ghc = new GHCSearch<Committee>();
+    ghc->nghbrs = [csm](const Committee & c) {
+      return csm->nghbrs(c);
+    };
+    ghc->show = [csm](const Committee & c) {
+      std::cout << csm->mtchPstn(c);
+      return;
+    };
+
+    // Each actor's favorite: climb from the full committee, and from the
+    // smallest seated committee of the candidates closest to the actor,
+    // keeping the better.
+    for (unsigned int i = 0; i < na; i++) {
+      ghc->eval = [this, csm, i](const Committee & c) {
+        numEvals++;
+        return csm->commUtil(i, c);
+      };
+      auto dist = vector<tuple<double, unsigned int>>();
+      for (unsigned int m = 0; m < na; m++) {
+        dist.push_back(tuple<double, unsigned int>(csm->idealDist(i, m), m));
+      }
+      std::sort(dist.begin(), dist.end());
+      Committee near = 0;
+      for (unsigned int k = 0; (k < na) && (!csm->seated(near)); k++) {
+        near = near | (((Committee)1) << get<1>(dist[k]));
+      }
+
+      auto r1 = ghc->run(all, ReportingLevel::Silent, iMax, sMax, sTol);
+      auto r2 = ghc->run(near, ReportingLevel::Silent, iMax, sMax, sTol);
+      favs.push_back((get<0>(r1) < get<0>(r2)) ? get<1>(r2) : get<1>(r1));
+    }
+
+    // The top committees by capability-weighted utility: the distinct local
+    // optima reached from the full committee and from each favorite.
+    ghc->eval = [this, csm, &wv, na](const Committee & c) {
+      numEvals++;
+      const KMatrix u = csm->commUtils(c);
+      double s = 0.0;
+      for (unsigned int i = 0; i < na; i++) {
+        s = s + wv[i] * u(0, i);
+      }
+      return s;
+    };
+    auto tops = vector<tuple<double, Committee>>();
+    auto climb = [ghc, &tops, iMax, sMax, sTol](Committee c0) {
+      auto r = ghc->run(c0, ReportingLevel::Silent, iMax, sMax, sTol);
+      const auto t = tuple<double, Committee>(-get<0>(r), get<1>(r)); // best first
+      if (tops.end() == std::find(tops.begin(), tops.end(), t)) {
+        tops.push_back(t);
+      }
+      return;
+    };
+    climb(all);
+    for (auto c : favs) {
+      climb(c);
+    }
+    std::sort(tops.begin(), tops.end());
+    for (unsigned int k = 0; (k < tops.size()) && (k < numTop); k++) {
+      top.push_back(get<1>(tops[k]));
+    }
+    delete ghc;
+    ghc = nullptr;
+    return;
+  }
+
+}; // end of namespace
 
 // --------------------------------------------
 // Copyright KAPSARC. Open source MIT License.
@@ -31,6 +31,7 @@
 #include "kmatrix.h"
 #include "gaopt.h"
 #include "kmodel.h"
+#include "emodel.h"
 
 #include "smp.h"
 
@@ -51,31 +52,136 @@ namespace ComSelLib {
   using KBase::VotingRule;
   using KBase::ReportingLevel;
   using KBase::MtchPstn;
+  using KBase::VUI;
 
   const string appVersion = "0.1";
 
-  class CSModel : public Model {
+  // A committee is a set of candidates, held as a bitset: bit m is set if
+  // candidate m is a member. The candidates are the model's actors.
+  typedef uint64_t Committee;
+
+  class CSActor : public Actor  {
   public:
-    CSModel(unsigned int np, unsigned int nd, PRNG* r, string d="");
-    virtual ~CSModel();
-    
+    CSActor(string n, string d);
+    virtual ~CSActor();
+
+    void randomize(PRNG* rng, unsigned int numD);
+
+    // vote between the committees advocated by two actors
+    double vote(unsigned int p1, unsigned int p2, const State* st) const;
+
+    double sCap = 0;
+    KMatrix vPos = KMatrix(); // ideal point, a column-vector in [0,1]
+    KMatrix vSal = KMatrix(); // salience of each dimension, totalling at most 1
+    VotingRule vr = VotingRule::Proportional;
   protected:
-    unsigned int numPrty = 0;
-    unsigned int numDims = 0;
   private:
   };
 
-  class CSActor : public Actor  {
+
+  // The options are all 2^n committees of the n actors, listed in Gray-code
+  // order: committee j is (j ^ (j>>1)), so consecutive committees differ by exactly
+  // one member. The policy of a committee is the capability-weighted mean of its
+  // members' ideal points, which is thereby updated in O(numDims) per committee
+  // rather than recomputed from all the members.
+  //
+  // A committee is seated only if its members hold more than the quorum fraction
+  // of all the capability. Any other committee is worth nothing to anyone, like
+  // the empty one, so an actor's favorite is the seated committee whose policy
+  // is closest to its own, not simply itself alone.
+  class CSModel : public KBase::EModel<Committee> {
   public:
-    CSActor();
-    virtual ~CSActor();
+    CSModel(unsigned int np, unsigned int nd, PRNG* r, string d="");
+    virtual ~CSModel();
+
+    // Evaluating every committee costs 2^n evaluations for each of the n actors,
+    // doubling with each candidate. Beyond this many candidates, CSState searches
+    // for good committees instead, in time polynomial in n.
+    static const unsigned int MaxEnumCandidates = 22;
+
+    // A committee is a 64-bit set, and the count of them, 2^n, must fit in uint64_t
+    static const unsigned int MaxCandidates = 63;
+
+    double quorum = 0.5;
+
+    // Once every actor has been added, set up the options
+    void setCommittees();
+
+    static Committee grayCode(uint64_t j) { return j ^ (j >> 1); };
+    static uint64_t grayRank(Committee c);
+
+    bool seated(Committee c) const;
+
+    // the capability-weighted mean of the members' positions,
+    // and its utility to actor i (zero if the committee is not seated)
+    KMatrix policy(Committee c) const;
+    double commUtil(unsigned int i, Committee c) const;
+
+    // the utility of committee c to every actor, as a row-vector
+    KMatrix commUtils(Committee c) const;
+
+    // the committees which differ from c by one candidate joining or leaving,
+    // or by one member being replaced by another candidate
+    vector<Committee> nghbrs(Committee c) const;
+
+    // how far candidate m's ideal point is from actor i's, by i's saliences
+    double idealDist(unsigned int i, unsigned int m) const;
+
+    // The committee as a matching of candidates (items) to
+    // membership (category 1) or not (category 0).
+    MtchPstn mtchPstn(Committee c) const;
+
+    // Write the values to every actor of a run of committees into vals, one row
+    // per committee. Successive committees which differ by one member are updated
+    // incrementally, as in any chunk of the Gray-code order.
+    void chunkValues(const vector<Committee> & cs, KBase::KView vals) const;
+
+    unsigned int numPrty = 0;
+    unsigned int numDims = 0;
+
   protected:
+    // copied out of the actors, so the inner loops need not chase pointers
+    double totCap = 0.0;
+    vector<double> caps = {}; // caps[m]
+    vector<double> wPos = {}; // wPos[m*numDims+d] = caps[m]*pos(m,d)
+    vector<double> aPos = {}; // aPos[i*numDims+d] = pos(i,d)
+    vector<double> aSal = {}; // aSal[i*numDims+d] = sal(i,d)
+
+    // utility to each actor of the policy (wSum/cSum), written to vals(0,i)
+    void policyValues(const double* wSum, double cSum, KBase::KView vals) const;
+
   private:
   };
 
-  class CSState : public State  {
+
+  class CSState : public KBase::EState<Committee>  {
   public:
+    explicit CSState(CSModel* m);
+    virtual ~CSState();
+
+    // Find each actor's favorite committee, and give it to the actor as its position.
+    // Then shortlist those, plus up to numTop committees of greatest capability-weighted
+    // utility, and find how likely each is to be chosen, by PCE among the shortlist.
+    // With up to MaxEnumCandidates candidates, every committee is evaluated for every
+    // actor, on all cores. With more, the favorites and the top committees are local
+    // optima found by hill-climbing over CSModel::nghbrs.
+    void evalCommittees(unsigned int numTop, ReportingLevel rl);
+
+    Committee posCommittee(unsigned int i) const;
+
+    vector<Committee> shortList = {};
+    KMatrix shortProb = KMatrix(); // column-vector, matching shortList
+    uint64_t numEvals = 0; // how many times a committee was evaluated (once each, if all were)
+
+    virtual tuple< KMatrix, VUI> pDist(int persp) const;
+
   protected:
+    virtual bool equivNdx(unsigned int i, unsigned int j) const;
+
+    // each way fills in the actors' favorites, and the top committees, best first
+    void enumCommittees(unsigned int numTop, vector<Committee> & favs, vector<Committee> & top);
+    void searchCommittees(unsigned int numTop, vector<Committee> & favs, vector<Committee> & top);
+
   private:
   };
 
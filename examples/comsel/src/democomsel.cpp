@@ -68,14 +68,54 @@ namespace DemoComSel {
 
   // -------------------------------------------------
   void demoActorUtils(const uint64_t s, PRNG* rng) {
-    printf("Using PRNG seed: %020llu \n", s);
+    printf("Using PRNG seed: %020llu \n", (unsigned long long) s);
     rng->setSeed(s);
     return;
   }
 
 
+  // Find the committees favored by nParty randomly generated parties, without the GUI.
+  // Every committee is evaluated if there are few enough parties; otherwise, they are searched.
+  void demoEngine(unsigned int nParty, unsigned int nDim, const uint64_t s, PRNG* rng) {
+    printf("Using PRNG seed: %020llu \n", (unsigned long long) s);
+    rng->setSeed(s);
+    printf("Num parties: %u \n", nParty);
+    printf("Num dimensions: %u \n", nDim);
+
+    auto csm = new CSModel(nParty, nDim, rng, "CSModel-Engine");
+    for (unsigned int i = 0; i < nParty; i++) {
+      auto buff = KBase::newChars(20);
+      sprintf(buff, "Party-%02u", i);
+      auto ai = new CSActor(buff, "randomized party");
+      delete[] buff;
+      buff = nullptr;
+      ai->randomize(rng, nDim);
+      csm->addActor(ai);
+    }
+    csm->setCommittees();
+    auto css = new CSState(csm);
+    csm->addState(css);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    css->evalCommittees(10, ReportingLevel::Low);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> dt = t1 - t0;
+    printf("Made %llu evaluations, of %llu possible committees, in %.3f seconds \n",
+           (unsigned long long)css->numEvals, (unsigned long long)csm->numOptions(), dt.count());
+
+    for (unsigned int i = 0; i < nParty; i++) {
+      printf("%s prefers ", csm->actrs[i]->name.c_str());
+      cout << csm->mtchPstn(css->posCommittee(i));
+      printf(" with utility %.4f \n", csm->commUtil(i, css->posCommittee(i)));
+    }
+    delete csm; // deletes the state and the actors too
+    csm = nullptr;
+    return;
+  }
+
+
   void demoCS(unsigned int nParty, unsigned int nDim, const uint64_t s, PRNG* rng) {
-    printf("Using PRNG seed: %020llu \n", s);
+    printf("Using PRNG seed: %020llu \n", (unsigned long long) s);
     rng->setSeed(s);
 
     if (0 == nParty) {
@@ -106,12 +146,14 @@ namespace DemoComSel {
 int main(int ac, char **av) {
   using std::cout;
   using std::endl;
+  using std::flush;
   using std::string;
 
   auto sTime = KBase::displayProgramStart();
   uint64_t dSeed = 0xD67CC16FE69C185C; // arbitrary
   uint64_t seed = dSeed;
   bool run = true;
+  unsigned int engineN = 0;
 
   cout << "comselApp version " << DemoComSel::appVersion << endl << endl;
 
@@ -119,9 +161,12 @@ int main(int ac, char **av) {
     printf("\n");
     printf("Usage: specify one or more of these options\n");
     printf("--help       print this message\n");
+    printf("--engine <n> find the committees N parties favor, without the GUI \n");
+    printf("             (N up to %u; all committees are evaluated up to %u) \n",
+           ComSelLib::CSModel::MaxCandidates, ComSelLib::CSModel::MaxEnumCandidates);
     printf("--seed <n>   set a 64bit seed\n");
     printf("             0 means truly random\n");
-    printf("             default: %020llu \n", dSeed);
+    printf("             default: %020llu \n", (unsigned long long) dSeed);
   };
 
   // tmp args
@@ -129,10 +174,22 @@ int main(int ac, char **av) {
 
   if (ac > 1) {
     for (int i = 1; i < ac; i++) {
-      if (strcmp(av[i], "--seed") == 0) {
+      if ((strcmp(av[i], "--seed") == 0) && (i + 1 < ac)) {
         i++;
         seed = std::stoull(av[i]);
       }
+      else if ((strcmp(av[i], "--engine") == 0) && (i + 1 < ac)) {
+        i++;
+        const int n = std::stoi(av[i]);
+        if ((n < 2) || (((int)ComSelLib::CSModel::MaxCandidates) < n)) {
+          run = false;
+          printf("Number of parties must be from 2 to %u, not %s\n",
+                 ComSelLib::CSModel::MaxCandidates, av[i]);
+        }
+        else {
+          engineN = n;
+        }
+      }
       else if (strcmp(av[i], "--help") == 0) {
         run = false;
       }
@@ -150,8 +207,8 @@ int main(int ac, char **av) {
 
   PRNG * rng = new PRNG();
   seed = rng->setSeed(seed); // 0 == get a random number
-  printf("Using PRNG seed: %020llu \n", seed);
-  printf("Same seed in hex: 0x%016llX \n", seed);
+  printf("Using PRNG seed: %020llu \n", (unsigned long long) seed);
+  printf("Same seed in hex: 0x%016llX \n", (unsigned long long) seed);
 
 
   cout << "Creating objects from SMPLib ... " <<endl << flush;
@@ -167,7 +224,12 @@ int main(int ac, char **av) {
   // note that we reset the seed every time, so that in case something
   // goes wrong, we need not scroll back too far to find the
   // seed required to reproduce the bug.
-  DemoComSel::demoCS(4, 6, seed, rng);
+  if (0 < engineN) {
+    DemoComSel::demoEngine(engineN, 3, seed, rng);
+  }
+  else {
+    DemoComSel::demoCS(4, 6, seed, rng);
+  }
 
   delete rng;
   KBase::displayProgramEnd(sTime);
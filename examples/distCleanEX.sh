@@ -5,7 +5,7 @@
 # rebuild them
 #
 #------------------------------------------
-FILES="minwater  reformpri  smp  agenda  comsel"
+FILES="minwater  reformpri  smp  agenda  comsel  bench"
 
 for d in $FILES
 do
@@ -207,47 +207,47 @@ double waterMinProb(ReportingLevel rl, const KMatrix & p0) {
     double err = sqrt(((err0*err0) + (err1*err1)) / 2.0); // RMS difference of the two critical probabilities
 
 
-    if (ReportingLevel::Silent < rl) {
-        cout << "Actor-cap matrix" << endl;
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+        KBase::klogf("Actor-cap matrix\n");
         w.mPrintf(" %8.1f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
 
-        if (ReportingLevel::Low < rl) {
-            cout << "Raw actor-pos util matrix" << endl;
+        if (KLOG_ON(ReportingLevel::Medium, rl)) {
+            KBase::klogf("Raw actor-pos util matrix\n");
             uInit.mPrintf(" %.4f ");
-            cout << endl << flush;
+            KBase::klogf("\n");
 
-            cout << "Coalition strength matrix" << endl;
+            KBase::klogf("Coalition strength matrix\n");
             c1.mPrintf(" %+9.3f ");
-            cout << endl << flush;
+            KBase::klogf("\n");
 
-            cout << "Probability Opt_i > Opt_j" << endl;
+            KBase::klogf("Probability Opt_i > Opt_j\n");
             pv1.mPrintf(" %.4f ");
-            cout << endl;
+            KBase::klogf("\n");
         }
 
-        cout << "Estimated prior probability Opt_i" << endl;
+        KBase::klogf("Estimated prior probability Opt_i\n");
         for (unsigned int i = 0; i < pr0.numR(); i++) {
-            printf("%2u , %6.4f \n", i, pr0(i, 0));
+            KBase::klogf("%2u , %6.4f \n", i, pr0(i, 0));
         }
         //pr0.printf(" %.4f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
 
-        cout << "Estimated posterior probability Opt_i" << endl;
+        KBase::klogf("Estimated posterior probability Opt_i\n");
         for (unsigned int i = 0; i < pr1.numR(); i++) {
-            printf("%2u , %6.4f \n", i, pr1(i, 0));
+            KBase::klogf("%2u , %6.4f \n", i, pr1(i, 0));
         }
         //pr1.printf(" %.4f ");
-        cout << endl << flush;
+        KBase::klogf("\n");
 
-        printf("Probability of base case %.3f ( %.3f )\n", priorBase, trgtP0);
+        KBase::klogf("Probability of base case %.3f ( %.3f )\n", priorBase, trgtP0);
 
-        printf("Probability of nominal case(s) %.3f ( %.3f )\n", postNom, trgtP1);
+        KBase::klogf("Probability of nominal case(s) %.3f ( %.3f )\n", postNom, trgtP1);
 
-        printf("RMSE of probabilities: %.4f \n", err);
+        KBase::klogf("RMSE of probabilities: %.4f \n", err);
 
-        printf("RMS of weight factors: %.4f \n", pRMS);
-        cout << endl << flush;
+        KBase::klogf("RMS of weight factors: %.4f \n", pRMS);
+        KBase::klogf("\n");
     }
 
     return (err + (pRMS * prmsW));
@@ -42,11 +42,11 @@ using KBase::PCEModel;
 // function definitions
 
 void printPerm(const VUI& p) {
-    cout << "[Perm ";
+    KBase::klogf("[Perm ");
     for (auto i : p) {
-        printf("%2i ", i);
+        KBase::klogf("%2u ", i);
     }
-    cout << "]";
+    KBase::klogf("]");
     return;
 }
 
@@ -341,9 +341,9 @@ tuple <KMatrix, VUI> RPState::pDist(int persp) const {
 
     cout << "Number of aUtils: " << aUtil.size() << endl << flush;
 
-    const KMatrix u = aUtil[0]; // all have same beliefs in this demo
+    const KMatrix & u = aUtil[0]; // all have same beliefs in this demo
 
-    auto uufn = [u, this](unsigned int i, unsigned int j1) {
+    auto uufn = [&u, this](unsigned int i, unsigned int j1) {
         return u(i, uIndices[j1]);
     };
 
@@ -353,7 +353,7 @@ tuple <KMatrix, VUI> RPState::pDist(int persp) const {
     assert(uMat.numC() == numU);
 
     // vote_k ( i : j )
-    auto vkij = [this, uMat](unsigned int k, unsigned int i, unsigned int j) {
+    auto vkij = [this, &uMat](unsigned int k, unsigned int i, unsigned int j) {
         auto ak = (RPActor*)(model->actrs[k]);
         auto v_kij = Model::vote(ak->vr, ak->sCap, uMat(k, i), uMat(k, j));
         return v_kij;
@@ -406,7 +406,7 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
     //printf("RPState::doSUSN: numP %i \n", numP);
     //cout << endl << flush;
 
-    const KMatrix u = aUtil[0]; // all have same beliefs in this demo
+    const KMatrix & u = aUtil[0]; // all have same beliefs in this demo
 
     auto vpm = VPModel::Linear;
     const unsigned int numP = pstns.size();
@@ -418,7 +418,7 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
         assert(uMat.numC() <= numP); // might have dropped some duplicates
 
         // vote_k ( i : j )
-        auto vkij = [this, uMat](unsigned int k, unsigned int i, unsigned int j) {
+        auto vkij = [this, &uMat](unsigned int k, unsigned int i, unsigned int j) {
             auto ak = (RPActor*)(rpMod->actrs[k]);
             auto v_kij = Model::vote(ak->vr, ak->sCap, uMat(k, i), uMat(k, j));
             return v_kij;
@@ -435,51 +435,49 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
         assert(1 == eu.numC());
 
 
-        if (ReportingLevel::Low < rl) {
-            printf("Util matrix is %i x %i \n", uMat.numR(), uMat.numC());
-            cout << "Assessing EU from util matrix: " << endl;
+        if (KLOG_ON(ReportingLevel::Medium, rl)) {
+            KBase::klogf("Util matrix is %i x %i \n", uMat.numR(), uMat.numC());
+            KBase::klogf("Assessing EU from util matrix: \n");
             uMat.mPrintf(" %.6f ");
-            cout << endl << flush;
+            KBase::klogf("\n");
 
-            cout << "Coalition strength matrix" << endl;
+            KBase::klogf("Coalition strength matrix\n");
             c.mPrintf(" %12.6f ");
-            cout << endl << flush;
+            KBase::klogf("\n");
 
-            cout << "Probability Opt_i > Opt_j" << endl;
+            KBase::klogf("Probability Opt_i > Opt_j\n");
             pv.mPrintf(" %.6f ");
-            cout << endl << flush;
+            KBase::klogf("\n");
 
-            cout << "Probability Opt_i" << endl;
+            KBase::klogf("Probability Opt_i\n");
             p.mPrintf(" %.6f ");
-            cout << endl << flush;
+            KBase::klogf("\n");
 
-            cout << "Expected utility to actors: " << endl;
+            KBase::klogf("Expected utility to actors: \n");
             eu.mPrintf(" %.6f ");
-            cout << endl << flush;
+            KBase::klogf("\n");
         }
 
         return eu;
     };
     // end of euMat
 
-    if (ReportingLevel::Low < rl) {
-        printf("--------------------------------------- \n");
-        printf("Assessing utility of actual state to all actors \n");
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        KBase::klogf("--------------------------------------- \n");
+        KBase::klogf("Assessing utility of actual state to all actors \n");
         for (unsigned int h = 0; h < numA; h++) {
-            cout << "not available" << endl;
+            KBase::klogf("not available\n");
         }
-        cout << endl << flush;
-        printf("Out of %u positions, %u were unique: ", numA, numU);
-        cout << flush;
+        KBase::klogf("\n");
+        KBase::klogf("Out of %u positions, %u were unique: ", numA, numU);
         for (auto i : uIndices) {
-            printf("%2i ", i);
+            KBase::klogf("%2i ", i);
         }
-        cout << endl;
-        cout << flush;
+        KBase::klogf("\n");
     }
 
 
-    auto uufn = [u, this](unsigned int i, unsigned int j1) {
+    auto uufn = [&u, this](unsigned int i, unsigned int j1) {
         return u(i, uIndices[j1]);
     };
     auto uUnique = KMatrix::map(uufn, numA, numU);
@@ -501,7 +499,7 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
     // The newPosFn does a GA optimization to find the best next position for actor h,
     // and stores it in s2. To do that, it defines three functions for evaluation, neighbors, and show:
     // efn, nfn, and sfn.
-    auto newPosFn = [this, rl, euMat, u, eu0, s2](const unsigned int h) {
+    auto newPosFn = [this, rl, &euMat, &u, &eu0, s2](const unsigned int h) {
         s2->pstns[h] = nullptr;
 
         auto ph = ((const MtchPstn *)(pstns[h]));
@@ -514,12 +512,12 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
         // and everyone else's actual position. Finally, compute the expected utility to
         // each actor, given that distribution, and pick out the value for h's expected utility.
         // That is the expected value to h of adopting the position.
-        auto efn = [this, euMat, rl, u, h](const MtchPstn & mph) {
+        auto efn = [this, &euMat, rl, &u, h](const MtchPstn & mph) {
             // This correctly handles duplicated/unique options
             // We modify the given euMat so that the h-column
             // corresponds to the given mph, but we need to prune duplicates as well.
             // This entails some type-juggling.
-            const KMatrix uh0 = aUtil[h];
+            const KMatrix & uh0 = aUtil[h];
             assert(KBase::maxAbs(u - uh0) < 1E-10); // all have same beliefs in this demo
             if (mph.match.size() != rpMod->numItm) {
                 cout << mph.match.size() << endl << flush;
@@ -539,7 +537,7 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
             // This entails juggling back and forth between the all current positions
             // and the one hypothetical position (mph at h).
             // Thus, the next call to euMat will consider only unique options.
-            auto equivHNdx = [this, h, mph](const unsigned int i, const unsigned int j) {
+            auto equivHNdx = [this, h, &mph](const unsigned int i, const unsigned int j) {
                 // this little function takes care of the different types needed to compare
                 // dynamic pointers to positions (all but h) with a constant position (h itself).
                 // In other words, the comparisons for index 'h' use the hypothetical mph, not pstns[h]
@@ -583,14 +581,14 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
             }
 
 
-            if (ReportingLevel::Low < rl) {
-                printf("--------------------------------------- \n");
-                printf("Assessing utility to %2i of hypo-pos: ", h);
+            if (KLOG_ON(ReportingLevel::Medium, rl)) {
+                KBase::klogf("--------------------------------------- \n");
+                KBase::klogf("Assessing utility to %2i of hypo-pos: ", h);
                 printPerm(mph.match);
-                cout << endl << flush;
-                printf("Hypo-util minus base util: \n");
+                KBase::klogf("\n");
+                KBase::klogf("Hypo-util minus base util: \n");
                 (uh - uh0).mPrintf(" %+.4E ");
-                cout << endl << flush;
+                KBase::klogf("\n");
             }
             const KMatrix eu = euMat(hypUtil); // uh or hypUtil
             // BUG: If we use 'uh' here, it passes the (0 <= delta-EU) test, because
@@ -678,17 +676,24 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
         ghc->nghbrs = nfn;
         ghc->show = sfn;
 
+        // Each move's neighbors include the point it came from, and its neighbors,
+        // so remember the values for this actor's search, rather than redo their PCEs.
+        auto ghcCache = new KBase::EvalCache(1 << 12, 4);
+        ghc->cache = ghcCache;
+        ghc->hashPt = [](const MtchPstn & mp) {
+            return mp.hash();
+        };
+
         auto rslt = ghc->run(*ph, // start from h's current positions
                              ReportingLevel::Silent,
                              100, // iter max
                              3, 0.001); // stable-max, stable-tol
 
-        if (ReportingLevel::Low < rl) {
-            printf("---------------------------------------- \n");
-            printf("Search for best next-position of actor %2i \n", h);
-            //printf("Search for best next-position of actor %2i starting from ", h);
+        if (KLOG_ON(ReportingLevel::Medium, rl)) {
+            KBase::klogf("---------------------------------------- \n");
+            KBase::klogf("Search for best next-position of actor %2i \n", h);
+            //KBase::klogf("Search for best next-position of actor %2i starting from ", h);
             //trans(*aPos).printf(" %+.6f ");
-            cout << flush;
         }
 
         double vBest = get<0>(rslt);
@@ -698,15 +703,21 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
 
         delete ghc;
         ghc = nullptr;
-        if (ReportingLevel::Medium < rl) {
-            printf("Iter: %u  Stable: %u \n", iterN, stblN);
-            printf("Best value for %2i: %+.6f \n", h, vBest);
-            cout << "Best position:    " << endl;
-            cout << "numCat: " << pBest.numCat << endl;
-            cout << "numItm: " << pBest.numItm << endl;
-            cout << "perm: ";
+        auto cs = ghcCache->stats();
+        delete ghcCache;
+        ghcCache = nullptr;
+        if (KLOG_ON(ReportingLevel::High, rl)) {
+            KBase::klogf("Iter: %u  Stable: %u \n", iterN, stblN);
+            KBase::klogf("Cached values: %llu lookups, %llu hits (%.1f%%) \n",
+                         (long long unsigned int) cs.lookups, (long long unsigned int) cs.hits,
+                         100.0 * cs.hitRate());
+            KBase::klogf("Best value for %2i: %+.6f \n", h, vBest);
+            KBase::klogf("Best position:    \n");
+            KBase::klogf("numCat: %u \n", pBest.numCat);
+            KBase::klogf("numItm: %u \n", pBest.numItm);
+            KBase::klogf("perm: ");
             printPerm(pBest.match);
-            cout << endl << flush;
+            KBase::klogf("\n");
         }
         MtchPstn * posBest = new MtchPstn(pBest);
         s2->pstns[h] = posBest;
@@ -714,8 +725,8 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
         // and each h is different.
 
         double du = vBest - eu0(h, 0); // (hypothetical, future) - (actual, current)
-        if (ReportingLevel::Low < rl) {
-            printf("EU improvement for %2i of %+.4E \n", h, du);
+        if (KLOG_ON(ReportingLevel::Medium, rl)) {
+            KBase::klogf("EU improvement for %2i of %+.4E \n", h, du);
         }
         //printf("  vBest = %+.6f \n", vBest);
         //printf("  eu0(%i, 0) for %i = %+.6f \n", h, h, eu0(h,0));
@@ -731,7 +742,7 @@ RPState* RPState::doSUSN(ReportingLevel rl) const {
     // Each actor, h, finds the position which maximizes their EU in this situation.
     for (unsigned int h = 0; h < numA; h++) {
         if (par) { // launch all, concurrent
-            ts.push_back(thread([newPosFn, h]() {newPosFn(h); return;}));
+            ts.push_back(thread([&newPosFn, h]() {newPosFn(h); return;})); // joined below
         }
         else { // do each, sequential
             newPosFn(h);
@@ -780,18 +791,16 @@ void RPState::setAllAUtil(ReportingLevel rl) {
         return uij;
     };
     auto u = KMatrix::map(uFn1, numA, numA);
-    if (KBase::ReportingLevel::Low < rl) {
-        cout << "Raw actor-pos util matrix" << endl;
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        KBase::klogf("Raw actor-pos util matrix\n");
         u.mPrintf(" %.4f ");
-        cout << endl << flush;
-        cout << flush;
+        KBase::klogf("\n");
 
         /// For the purposes of this demo, I consider each actor to know exactly what
         /// the others value. They know what consequences the others expect,
         /// and how they will value those consequences,
         /// even if they disagree on both facts and values.
-        cout << "aUtil size: " << aUtil.size() << endl << flush;
-        cout << flush;
+        KBase::klogf("aUtil size: %u \n", (unsigned int)aUtil.size());
     }
 
     assert(0 == aUtil.size());
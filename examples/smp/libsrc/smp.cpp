@@ -25,8 +25,10 @@
 //
 // --------------------------------------------
 
+#include <cmath>
+
 #include "smp.h"
-#include "csv_parser.hpp"
+#include "kcsv.h"
 
 
 namespace SMPLib {
@@ -39,7 +41,10 @@ using std::string;
 
 using KBase::PRNG;
 using KBase::KMatrix;
+using KBase::KMatrixF;
+using KBase::BasicKMatrix;
 using KBase::KException;
+using KBase::klogf;
 using KBase::Actor;
 using KBase::Model;
 using KBase::Position;
@@ -55,6 +60,119 @@ using KBase::ReportingLevel;
 
 
 
+namespace {
+// Kernels over the dimensions of a position take the number of dimensions as
+// a template parameter ND, so that the loops over dimensions have a fixed count
+// and can be unrolled. ND = 0 means that the count, nd, is only known at run time.
+// byDim calls K::run<ND> with ND fixed for 1 to 8 dimensions, which covers
+// nearly every scenario, and with ND = 0 otherwise.
+template <class K, class... Args>
+auto byDim(unsigned int nd, Args... args) -> decltype(K::template run<0>(nd, args...)) {
+    switch (nd) {
+    case 1: return K::template run<1>(nd, args...);
+    case 2: return K::template run<2>(nd, args...);
+    case 3: return K::template run<3>(nd, args...);
+    case 4: return K::template run<4>(nd, args...);
+    case 5: return K::template run<5>(nd, args...);
+    case 6: return K::template run<6>(nd, args...);
+    case 7: return K::template run<7>(nd, args...);
+    case 8: return K::template run<8>(nd, args...);
+    default: return K::template run<0>(nd, args...);
+    }
+}
+
+// bvDiff, for the differences d weighted by the saliences s
+struct BvDiffK {
+    template <unsigned int ND>
+    static double run(unsigned int nd, const double* d, const double* s) {
+        const unsigned int n = (0 < ND) ? ND : nd;
+        double dsSqr = 0;
+        double ssSqr = 0;
+        for (unsigned int k = 0; k < n; k++) {
+            assert(0 <= s[k]);
+            const double ds = d[k] * s[k];
+            dsSqr = dsSqr + (ds*ds);
+            ssSqr = ssSqr + (s[k] * s[k]);
+        }
+        assert(0 < ssSqr);
+        return sqrt(dsSqr / ssSqr);
+    }
+};
+
+// bvDiff for the difference a - b, without building it
+struct PairDiffK {
+    template <unsigned int ND>
+    static double run(unsigned int nd, const double* a, const double* b, const double* s) {
+        const unsigned int n = (0 < ND) ? ND : nd;
+        double dsSqr = 0;
+        double ssSqr = 0;
+        for (unsigned int k = 0; k < n; k++) {
+            assert(0 <= s[k]);
+            const double ds = (a[k] - b[k]) * s[k];
+            dsSqr = dsSqr + (ds*ds);
+            ssSqr = ssSqr + (s[k] * s[k]);
+        }
+        assert(0 < ssSqr);
+        return sqrt(dsSqr / ssSqr);
+    }
+};
+
+// norm(a - b), without building it
+struct NormDiffK {
+    template <unsigned int ND>
+    static double run(unsigned int nd, const double* a, const double* b) {
+        const unsigned int n = (0 < ND) ? ND : nd;
+        double s = 0;
+        for (unsigned int k = 0; k < n; k++) {
+            const double d = a[k] - b[k];
+            s = s + (d*d);
+        }
+        return sqrt(s);
+    }
+};
+
+// The single-precision forms of SMPModel::bsUtil and SMPModel::bvDiff,
+// for SMPModel::singlePrec. Only the type of the arithmetic differs.
+template <class T>
+T bsUtilT(T sd, T R) {
+    assert(0 <= sd);
+    return (sd <= 1) ? (1 - sd)*(1 + sd*R) : (1 - sd)*(1 + R);
+}
+
+// vd(i,j) = bvDiff(pos_i - pos_j, sal_i), with one actor per row of pos and sal.
+// This works on the plain arrays, so the loop over dimensions can be vectorized.
+template <class T>
+BasicKMatrix<T> vDiffT(const BasicKMatrix<T> & pos, const BasicKMatrix<T> & sal) {
+    const unsigned int na = pos.numR();
+    const unsigned int nd = pos.numC();
+    assert(KBase::sameShape(pos, sal));
+    auto vd = BasicKMatrix<T>(na, na);
+    const T* p = pos.data();
+    const T* s = sal.data();
+    for (unsigned int i = 0; i < na; i++) {
+        const T* pi = p + i*nd;
+        const T* si = s + i*nd;
+        T ssSqr = 0;
+        for (unsigned int k = 0; k < nd; k++) {
+            assert(0 <= si[k]);
+            ssSqr = ssSqr + si[k] * si[k];
+        }
+        assert(0 < ssSqr);
+        for (unsigned int j = 0; j < na; j++) {
+            const T* pj = p + j*nd;
+            T dsSqr = 0;
+            for (unsigned int k = 0; k < nd; k++) {
+                const T ds = (pi[k] - pj[k]) * si[k];
+                dsSqr = dsSqr + ds*ds;
+            }
+            vd(i, j) = std::sqrt(dsSqr / ssSqr);
+        }
+    }
+    return vd;
+}
+}; // end of anonymous namespace
+
+
 BargainSMP::BargainSMP(const SMPActor* ai, const SMPActor* ar, const VctrPstn & pi, const VctrPstn & pr) {
     assert(nullptr != ai);
     assert(nullptr != ar);
@@ -101,7 +219,7 @@ double SMPActor::posUtil(const Position * ap1, const SMPState* as) const {
     assert(nullptr != p0);
     auto p1 = ((const VctrPstn*)ap1);
     assert(nullptr != p1);
-    double u1 = SMPModel::bvUtil((*p0) - (*p1), vSal, ri);
+    double u1 = SMPModel::bsUtil(SMPModel::bvDiff(*p0, *p1, vSal), ri);
     return u1;
 }
 
@@ -177,6 +295,43 @@ void SMPActor::interpBrgnS2PMax(double tik, double sik, double prbI,
 }
 
 
+// the loop over dimensions of interpolateBrgn
+struct SMPActor::InterpK {
+    template <unsigned int ND>
+    static void run(unsigned int nd, const double* ti, const double* si, double prbI,
+                    const double* tj, const double* sj, double prbJ,
+                    InterVecBrgn ivb, double* bi, double* bj) {
+        const unsigned int n = (0 < ND) ? ND : nd;
+        for (unsigned int k = 0; k < n; k++) {
+            double tik = ti[k];
+            double sik = si[k];
+
+            double tjk = tj[k];
+            double sjk = sj[k];
+            double & bik = tik;
+            double & bjk = tjk;
+            switch (ivb) {
+            case InterVecBrgn::S1P1:
+                interpBrgnSnPm(1, 1, tik, sik, prbI, tjk, sjk, prbJ, bik, bjk);
+                break;
+            case InterVecBrgn::S2P2:
+                interpBrgnSnPm(2, 2, tik, sik, prbI, tjk, sjk, prbJ, bik, bjk);
+                break;
+            case InterVecBrgn::S2PMax:
+                interpBrgnS2PMax(tik, sik, prbI, tjk, sjk, prbJ, bik, bjk);
+                break;
+            default:
+                throw KException("interpolateBrgn: unrecognized InterVecBrgn value");
+                break;
+            }
+            bi[k] = bik;
+            bj[k] = bjk;
+        }
+        return;
+    }
+};
+
+
 BargainSMP* SMPActor::interpolateBrgn(const SMPActor* ai, const SMPActor* aj,
                                       const VctrPstn* posI, const VctrPstn * posJ,
                                       double prbI, double prbJ, InterVecBrgn ivb) {
@@ -186,31 +341,9 @@ BargainSMP* SMPActor::interpolateBrgn(const SMPActor* ai, const SMPActor* aj,
     auto brgnI = VctrPstn(numD, 1);
     auto brgnJ = VctrPstn(numD, 1);
 
-    for (unsigned int k = 0; k < numD; k++) {
-        double tik = (*posI)(k, 0);
-        double sik = ai->vSal(k, 0);
-
-        double tjk = (*posJ)(k, 0);
-        double sjk = aj->vSal(k, 0);
-        double & bik = tik;
-        double & bjk = tjk;
-        switch (ivb) {
-        case InterVecBrgn::S1P1:
-            interpBrgnSnPm(1, 1, tik, sik, prbI, tjk, sjk, prbJ, bik, bjk);
-            break;
-        case InterVecBrgn::S2P2:
-            interpBrgnSnPm(2, 2, tik, sik, prbI, tjk, sjk, prbJ, bik, bjk);
-            break;
-        case InterVecBrgn::S2PMax:
-            interpBrgnS2PMax(tik, sik, prbI, tjk, sjk, prbJ, bik, bjk);
-            break;
-        default:
-            throw KException("interpolateBrgn: unrecognized InterVecBrgn value");
-            break;
-        }
-        brgnI(k, 0) = bik;
-        brgnJ(k, 0) = bjk;
-    }
+    byDim<InterpK>(numD, posI->data(), ai->vSal.data(), prbI,
+                   posJ->data(), aj->vSal.data(), prbJ, ivb,
+                   brgnI.data(), brgnJ.data());
 
     auto brgn = new BargainSMP(ai, aj, brgnI, brgnJ);
     return brgn;
@@ -229,24 +362,45 @@ SMPState::~SMPState() {
 
 
 
+
+
 void SMPState::setVDiff(const vector<VctrPstn> & vpos) {
-    auto dfn = [vpos, this](unsigned int i, unsigned int j) {
+    const unsigned int na = model->numAct;
+    auto sm = ((const SMPModel*)model);
+    if (sm->singlePrec && (0 == vpos.size())) {
+        const unsigned int nd = sm->numDim;
+        auto posF = KMatrixF(na, nd);
+        auto salF = KMatrixF(na, nd);
+        for (unsigned int i = 0; i < na; i++) {
+            auto pi = ((const VctrPstn*)(pstns[i]));
+            auto ai = ((const SMPActor*)(model->actrs[i]));
+            for (unsigned int k = 0; k < nd; k++) {
+                posF(i, k) = (float)((*pi)(k, 0));
+                salF(i, k) = (float)(ai->vSal(k, 0));
+            }
+        }
+        vDiffF = vDiffT(posF, salF);
+        vDiff = KMatrix();
+        return;
+    }
+
+    auto dfn = [&vpos, this](unsigned int i, unsigned int j) {
         auto ai = ((const SMPActor*)(model->actrs[i]));
-        KMatrix si = ai->vSal;
+        const KMatrix & si = ai->vSal;
         auto pj = ((const VctrPstn*)(pstns[j]));
         double dij = 0.0;
         if (0 == vpos.size()) {
             auto pi = ((const VctrPstn*)(pstns[i]));
-            dij = SMPModel::bvDiff((*pi) - (*pj), si);
+            dij = SMPModel::bvDiff(*pi, *pj, si);
         } else {
-            auto vpi = vpos[i];
-            dij = SMPModel::bvDiff(vpi - (*pj), si);
+            const auto & vpi = vpos[i];
+            dij = SMPModel::bvDiff(vpi, *pj, si);
         }
         return dij;
     };
 
-    const unsigned int na = model->numAct;
     vDiff = KMatrix::map(dfn, na, na);
+    vDiffF = KMatrixF();
     return;
 }
 
@@ -263,7 +417,7 @@ void SMPModel::setUtilProb(const KMatrix& vR, const KMatrix& vS, const KMatrix&
 
     // calculate utility matrix
     // utils(i,j) = utility to actor i of position of actor j
-    auto uFn = [vR, vD](unsigned int i, unsigned int j) {
+    auto uFn = [&vR, &vD](unsigned int i, unsigned int j) {
         const double ri = vR(i,0);
         const double dij = vD(i,j);
         const double uij = bsUtil(dij, ri);
@@ -299,22 +453,9 @@ void SMPModel::setUtilProb(const KMatrix& vR, const KMatrix& vS, const KMatrix&
         }
     }
 
-    // calculate pairwise victory probabilities
+    // calculate pairwise victory probabilities, which are complementary by construction
     auto vpm = VPModel::Linear;
-    auto vP = KMatrix(na,na);
-    for (unsigned int i=0; i<na; i++) {
-        for (unsigned int j=0; j<i; j++ ) {
-            double pij = cs(i,j) / (cs(i,j) + cs(j,i));
-            auto ppr = vProb(vpm, cs(i,j), cs(j,i));
-            vP(i, j) = get<0>(ppr); // set the lower left  probability: if Linear, cij / (cij + cji)
-            vP(j, i) = get<1>(ppr); // set the upper right probability: if Linear, cji / (cij + cji)
-        }
-    }
-    for (unsigned int i=0; i<na; i++) { // check arithmetic
-        for (unsigned int j=0; j<na; j++ ) {
-            assert(fabs(vP(i,j)+vP(j,i)-1.0) < aeTol);
-        }
-    }
+    auto vP = Model::vProbPairs(vpm, cs);
 
 
     return;
@@ -348,6 +489,7 @@ void SMPState::setAllAUtil(ReportingLevel rl) {
 
 
     const unsigned int na = model->numAct;
+    const bool fp32 = ((const SMPModel*)model)->singlePrec;
 
     // make sure prerequisities are at least somewhat setup
     assert (na == eIndices.size());
@@ -360,58 +502,65 @@ void SMPState::setAllAUtil(ReportingLevel rl) {
     auto uFn1 = [this](unsigned int i, unsigned int j) {
         return  SMPModel::bsUtil(vDiff(i, j), nra(i, 0));
     };
+    auto uFn1F = [this](unsigned int i, unsigned int j) {
+        return  bsUtilT<float>(vDiffF(i, j), (float)nra(i, 0));
+    };
+    auto uMap = [fp32, na, &uFn1, &uFn1F]() {
+        return fp32 ? KMatrix(KMatrixF::map(uFn1F, na, na)) : KMatrix::map(uFn1, na, na);
+    };
 
-    auto rnUtil_ij = KMatrix::map(uFn1, na, na);
+    auto rnUtil_ij = uMap();
 
-    if (ReportingLevel::Silent < rl) {
-        cout << "Raw actor-pos value matrix (risk neutral)" << endl;
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+        klogf("Raw actor-pos value matrix (risk neutral) \n");
         rnUtil_ij.mPrintf(" %+.3f ");
-        cout << endl << flush;
+        klogf("\n");
     }
 
-    auto pv_ij = Model::vProb(vr, vpm, w_j, rnUtil_ij);
+    auto pv_ij = Model::vProbPairs(vr, vpm, w_j, rnUtil_ij);
     auto p_i = Model::probCE(PCEModel::ConditionalPCM, pv_ij);
     nra = Model::bigRfromProb(p_i, rr);
 
 
-    if (ReportingLevel::Silent < rl) {
-        cout << "Inferred risk attitudes: " << endl;
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+        klogf("Inferred risk attitudes: \n");
         nra.mPrintf(" %+.3f ");
-        cout << endl << flush;
+        klogf("\n");
     }
 
-    auto raUtil_ij = KMatrix::map(uFn1, na, na);
+    auto raUtil_ij = uMap();
 
-    if (ReportingLevel::Silent < rl) {
-        cout << "Risk-aware actor-pos utility matrix (objective):" << endl;
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+        klogf("Risk-aware actor-pos utility matrix (objective): \n");
         raUtil_ij.mPrintf(" %+.4f ");
-        cout << endl;
-        cout << "RMS change in value vs utility: " << norm(rnUtil_ij - raUtil_ij) / na << endl << flush;
+        klogf("\n");
+        klogf("RMS change in value vs utility: %g \n", norm(rnUtil_ij - raUtil_ij) / na);
     }
 
     const double duTol = 1E-6;
     assert(duTol < norm(rnUtil_ij - raUtil_ij)); // I've never seen it below 0.07
 
 
-    if (ReportingLevel::Silent < rl) {
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+        const string ran = KBase::bigRAName(ra);
         switch (ra) {
         case BigRAdjust::FullRA:
-            cout << "Using " << ra <<": r^h_i = ri" << endl;
+            klogf("Using %s: r^h_i = ri \n", ran.c_str());
             break;
         case BigRAdjust::TwoThirdsRA:
-            cout << "Using " << ra <<": r^h_i = (rh + 2*ri)/3" << endl;
+            klogf("Using %s: r^h_i = (rh + 2*ri)/3 \n", ran.c_str());
             break;
         case BigRAdjust::HalfRA:
-            cout << "Using " << ra <<": r^h_i = (rh + ri)/2" << endl;
+            klogf("Using %s: r^h_i = (rh + ri)/2 \n", ran.c_str());
             break;
         case BigRAdjust::OneThirdRA:
-            cout << "Using " << ra <<": r^h_i = (2*rh + ri)/3" << endl;
+            klogf("Using %s: r^h_i = (2*rh + ri)/3 \n", ran.c_str());
             break;
         case BigRAdjust::NoRA:
-            cout << "Using " << ra <<": r^h_i = rh " << endl;
+            klogf("Using %s: r^h_i = rh \n", ran.c_str());
             break;
         default:
-            cout << "Unrecognized BigRAdjust" << endl;
+            klogf("Unrecognized BigRAdjust \n");
             assert(false);
             break;
         }
@@ -422,21 +571,29 @@ void SMPState::setAllAUtil(ReportingLevel rl) {
         auto u_h_ij = KMatrix(na, na);
         for (unsigned int i = 0; i < na; i++) {
             double rhi = estNRA(h, i, ra);
-            for (unsigned int j = 0; j < na; j++) {
-                double dij = vDiff(i, j);
-                u_h_ij(i, j) = SMPModel::bsUtil(dij, rhi);
+            if (fp32) {
+                const float rhiF = (float)rhi;
+                for (unsigned int j = 0; j < na; j++) {
+                    u_h_ij(i, j) = bsUtilT<float>(vDiffF(i, j), rhiF);
+                }
+            }
+            else {
+                for (unsigned int j = 0; j < na; j++) {
+                    double dij = vDiff(i, j);
+                    u_h_ij(i, j) = SMPModel::bsUtil(dij, rhi);
+                }
             }
         }
         aUtil.push_back(u_h_ij);
 
 
-        if (ReportingLevel::Silent < rl) {
-            cout << "Estimate by " << h << " of risk-aware utility matrix:" << endl;
+        if (KLOG_ON(ReportingLevel::Low, rl)) {
+            klogf("Estimate by %u of risk-aware utility matrix: \n", h);
             u_h_ij.mPrintf(" %+.4f ");
-            cout << endl;
+            klogf("\n");
 
-            cout << "RMS change in util^h vs utility: " << norm(u_h_ij - raUtil_ij) / na << endl;
-            cout << endl;
+            klogf("RMS change in util^h vs utility: %g \n", norm(u_h_ij - raUtil_ij) / na);
+            klogf("\n");
         }
 
         assert(duTol < norm(u_h_ij - raUtil_ij)); // I've never seen it below 0.03
@@ -454,19 +611,19 @@ void SMPState::setOneAUtil(unsigned int perspH, ReportingLevel rl) {
 
 void SMPState::showBargains(const vector < vector < BargainSMP* > > & brgns) const {
     for (unsigned int i = 0; i < brgns.size(); i++) {
-        printf("Bargains involving actor %u: ", i);
+        klogf("Bargains involving actor %u: ", i);
         for (unsigned int j = 0; j < brgns[i].size(); j++) {
             BargainSMP* bij = brgns[i][j];
             if (nullptr != bij) {
                 int a1 = model->actrNdx(bij->actInit);
                 int a2 = model->actrNdx(bij->actRcvr);
-                printf(" [%i:%i] ", a1, a2);
+                klogf(" [%i:%i] ", a1, a2);
             }
             else {
-                printf(" SQ ");
+                klogf(" SQ ");
             }
         }
-        cout << endl << flush;
+        klogf("\n");
     }
     return;
 }
@@ -485,6 +642,17 @@ double SMPState::aNRA(unsigned int i) const {
     return ri;
 }
 
+uint64_t SMPState::memBytes() const {
+    uint64_t nb = State::memBytes() + sizeof(SMPState) - sizeof(State);
+    for (auto p : pstns) {
+        nb = nb + KBase::memBytes(*((const VctrPstn*)p)) - sizeof(KMatrix) + sizeof(VctrPstn);
+    }
+    nb = nb + KBase::memBytes(vDiff) + KBase::memBytes(rnProb) + KBase::memBytes(nra);
+    nb = nb - 3 * sizeof(KMatrix); // already in sizeof(SMPState)
+    nb = nb + KBase::memBytes(vDiffF) - sizeof(KMatrixF);
+    return nb;
+}
+
 void SMPState::addPstn(Position* ap) {
     auto sp = (VctrPstn*)ap;
     auto sm = (SMPModel*)model;
@@ -513,7 +681,7 @@ bool SMPState::equivNdx(unsigned int i, unsigned int j) const {
 // estimate Ri, and set all the aUtil[h] matrices
 SMPState* SMPState::stepBCN() {
     if (0 == aUtil.size()) {
-        setAUtil(-1, ReportingLevel::Low);
+        setAUtil(-1, model->rptLvl);
     }
     int myT = -1;
     for (unsigned int t = 0; t < model->history.size(); t++) {
@@ -535,6 +703,7 @@ SMPState* SMPState::stepBCN() {
 
 
 SMPState* SMPState::doBCN() const {
+    KPROF_SCOPE("SMPState::doBCN");
     auto brgns = vector< vector < BargainSMP* > >();
     const unsigned int na = model->numAct;
     brgns.resize(na);
@@ -544,6 +713,7 @@ SMPState* SMPState::doBCN() const {
     }
 
     auto ivb = SMPActor::InterVecBrgn::S2P2;
+    const ReportingLevel rl = model->rptLvl;
     // For each actor, identify good targets, and propose bargains to them.
     // (This loop would be an excellent place for high-level parallelism)
     for (unsigned int i = 0; i < na; i++) {
@@ -554,7 +724,7 @@ SMPState* SMPState::doBCN() const {
         if (0 < bestEU) {
             assert(0 <= bestJ);
 
-            printf("Actor %u has most advantageous target %i worth %.3f\n", i, bestJ, bestEU);
+            KLOG(ReportingLevel::Low, rl, "Actor %u has most advantageous target %i worth %.3f\n", i, bestJ, bestEU);
 
             auto ai = ((const SMPActor*)(model->actrs[i]));
             auto aj = ((const SMPActor*)(model->actrs[bestJ]));
@@ -567,23 +737,27 @@ SMPState* SMPState::doBCN() const {
             brgns[i].push_back(brgnIJ); // initiator's copy, delete only it later
             brgns[bestJ].push_back(brgnIJ); // receiver's copy, just null it out later
 
-            printf(" %2i proposes %2i adopt: ", nai, nai);
-            KBase::trans(brgnIJ->posInit).mPrintf(" %.3f ");
-            printf(" %2i proposes %2i adopt: ", nai, naj);
-            KBase::trans(brgnIJ->posRcvr).mPrintf(" %.3f ");
+            if (KLOG_ON(ReportingLevel::Low, rl)) {
+                klogf(" %2i proposes %2i adopt: ", nai, nai);
+                brgnIJ->posInit.tView().mPrintf(" %.3f ");
+                klogf(" %2i proposes %2i adopt: ", nai, naj);
+                brgnIJ->posRcvr.tView().mPrintf(" %.3f ");
+            }
         }
         else {
-            printf("Actor %u has no advantageous targets \n", i);
+            KLOG(ReportingLevel::Low, rl, "Actor %u has no advantageous targets \n", i);
         }
     }
 
 
-    cout << endl << "Bargains to be resolved" << endl << flush;
-    showBargains(brgns);
-
     auto w = actrCaps();
-    cout << "w:" << endl;
-    w.mPrintf(" %6.2f ");
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+        klogf("\nBargains to be resolved \n");
+        showBargains(brgns);
+
+        klogf("w: \n");
+        w.mPrintf(" %6.2f ");
+    }
 
     // of course, you  can change these two parameters
     auto vr = VotingRule::Proportional;
@@ -604,7 +778,7 @@ SMPState* SMPState::doBCN() const {
 
     // what is the utility to actor nai of the state resulting after
     // the nbj-th bargain of the k-th actor is implemented?
-    auto brgnUtil = [this, brgns](unsigned int nk, unsigned int nai, unsigned int nbj) {
+    auto brgnUtil = [this, &brgns](unsigned int nk, unsigned int nai, unsigned int nbj) {
         const unsigned int na = model->numAct;
         BargainSMP * b = brgns[nk][nbj];
         double uAvrg = 0.0;
@@ -658,21 +832,22 @@ SMPState* SMPState::doBCN() const {
     // (This loop would be a good place for high-level parallelism)
     for (unsigned int k = 0; k < na; k++) {
         unsigned int nb = brgns[k].size();
-        auto buk = [brgnUtil, k](unsigned int nai, unsigned int nbj) {
+        auto buk = [&brgnUtil, k](unsigned int nai, unsigned int nbj) {
             return brgnUtil(k, nai, nbj);
         };
         auto u_im = KMatrix::map(buk, na, nb);
 
-        cout << "u_im: " << endl;
-        u_im.mPrintf(" %.5f ");
+        if (KLOG_ON(ReportingLevel::Low, rl)) {
+            klogf("u_im: \n");
+            u_im.mPrintf(" %.5f ");
 
-        cout << "Doing probCE for the " << nb << " bargains of actor " << k << " ... " << flush;
-        auto p = Model::scalarPCE(na, nb, w, u_im, vr, vpm, ReportingLevel::Medium);
+            klogf("Doing probCE for the %u bargains of actor %u ... ", nb, k);
+        }
+        auto p = Model::scalarPCE(na, nb, w, u_im, vr, vpm, rl);
         assert(nb == p.numR());
         assert(1 == p.numC());
-        cout << "done" << endl << flush;
         unsigned int mMax = ndxMaxProb(p); // indexing actors by i, bargains by m
-        cout << "Chosen bargain: " << mMax << endl;
+        KLOG(ReportingLevel::Low, rl, "done \nChosen bargain: %u \n", mMax);
 
 
 
@@ -702,7 +877,7 @@ SMPState* SMPState::doBCN() const {
         assert(k == s2->pstns.size());
         s2->pstns.push_back(pk);
 
-        cout << endl << flush;
+        KLOG(ReportingLevel::Low, rl, "\n");
     }
 
 
@@ -832,6 +1007,7 @@ tuple<double, double> SMPState::probEduChlg(unsigned int h, unsigned int k, unsi
 
 
 tuple<int, double, double> SMPState::bestChallenge(unsigned int i) const {
+    KPROF_SCOPE("SMPState::bestChallenge");
     int bestJ = -1;
     double piJ = 0;
     double bestEU = 0;
@@ -867,18 +1043,22 @@ tuple< KMatrix, VUI> SMPState::pDist(int persp) const {
     const unsigned int na = model->numAct;
     const KMatrix w = actrCaps();
 
-    auto uij = KMatrix(na, na); // full utility matrix, including duplicate columns
+    // full utility matrix, including duplicate columns:
+    // one actor's own matrix is used in place, only the mixed one is built
+    auto uMix = KMatrix();
+    KBase::KCView uij = uMix;
     assert(na == aUtil.size()); // must have been filled in
     if ((0 <= persp) && (persp < na)) {
         uij = aUtil[persp];
     }
     else if (-1 == persp) {
+        uMix = KMatrix(na, na);
         for (unsigned int i = 0; i < na; i++) {
             for (unsigned int j = 0; j < na; j++) {
-                auto ui = aUtil[i];
-                uij(i, j) = aUtil[i](i, j);
+                uMix(i, j) = aUtil[i](i, j);
             }
         }
+        uij = uMix;
     }
     else {
         cout << "SMPState::pDist: unrecognized perspective, " << persp << endl << flush;
@@ -887,13 +1067,14 @@ tuple< KMatrix, VUI> SMPState::pDist(int persp) const {
 
     assert (0 < uIndices.size()); // should have been set with setUENdx();
     //auto uNdx2 = uniqueNdx(); // get the indices to unique positions
-    printf("Unique positions %i/%i ", uIndices.size(), na);
-    cout << "[ ";
-    for (auto i : uIndices) {
-        printf(" %i ", i);
+    if (KLOG_ON(ReportingLevel::Low, model->rptLvl)) {
+        klogf("Unique positions %u/%u [ ", (unsigned int)uIndices.size(), na);
+        for (auto i : uIndices) {
+            klogf(" %u ", i);
+        }
+        klogf(" ] \n");
     }
-    cout << " ] " << endl << flush;
-    auto uufn = [uij, this](unsigned int i, unsigned int j) {
+    auto uufn = [&uij, this](unsigned int i, unsigned int j) {
         return uij(i, uIndices[j]);
     };
     auto uUij = KMatrix::map(uufn, na, uIndices.size());
@@ -906,11 +1087,13 @@ tuple< KMatrix, VUI> SMPState::pDist(int persp) const {
 // -------------------------------------------------
 
 
-SMPModel::SMPModel(PRNG * r, string desc) : Model(r, desc) {
+SMPModel::SMPModel(PRNG * r, string desc, string dbName) : Model(r, desc) {
     // note that numDim, posTol, and dimName are initialized in class declaration
 
     // TODO: get cleaner opening of smpDB
-    sqlTest();
+    if (0 < dbName.length()) {
+        sqlTest(dbName);
+    }
 }
 
 SMPModel::~SMPModel() {
@@ -923,7 +1106,10 @@ SMPModel::~SMPModel() {
         sqlite3_close(smpDB);
         smpDB = nullptr;
     }
-
+    if (nullptr != spillFile) {
+        fclose(spillFile);
+        spillFile = nullptr;
+    }
 }
 
 
@@ -941,7 +1127,8 @@ double SMPModel::stateDist(const SMPState* s1, const SMPState* s2) {
     for (unsigned int i = 0; i < n; i++) {
         auto vp1i = ((const VctrPstn*)(s1->pstns[i]));
         auto vp2i = ((const VctrPstn*)(s2->pstns[i]));
-        dSum = dSum + KBase::norm((*vp1i) - (*vp2i));
+        assert(KBase::sameShape(*vp1i, *vp2i));
+        dSum = dSum + byDim<NormDiffK>(vp1i->numR() * vp1i->numC(), vp1i->data(), vp2i->data());
     }
     return dSum;
 }
@@ -963,22 +1150,13 @@ double SMPModel::bsUtil(double sd, double R) {
 
 double SMPModel::bvDiff(const  KMatrix & vd, const  KMatrix & vs) {
     assert(KBase::sameShape(vd, vs));
-    double dsSqr = 0;
-    double ssSqr = 0;
-    for (unsigned int i = 0; i < vd.numR(); i++) {
-        for (unsigned int j = 0; j < vd.numC(); j++) {
-            const double dij = vd(i, j);
-            const double sij = vs(i, j);
-            assert(0 <= sij);
-            const double ds = dij * sij;
-            const double s = sij;
-            dsSqr = dsSqr + (ds*ds);
-            ssSqr = ssSqr + (s*s);
-        }
-    }
-    assert(0 < ssSqr);
-    double sd = sqrt(dsSqr / ssSqr);
-    return sd;
+    return byDim<BvDiffK>(vd.numR() * vd.numC(), vd.data(), vs.data());
+};
+
+double SMPModel::bvDiff(const KMatrix & p0, const KMatrix & p1, const KMatrix & vs) {
+    assert(KBase::sameShape(p0, vs));
+    assert(KBase::sameShape(p1, vs));
+    return byDim<PairDiffK>(vs.numR() * vs.numC(), p0.data(), p1.data(), vs.data());
 };
 
 double SMPModel::bvUtil(const  KMatrix & vd, const  KMatrix & vs, double R) {
@@ -1006,11 +1184,27 @@ double SMPState::posProb(unsigned int i, const VUI & unq, const KMatrix & pdt) c
     return pr;
 }
 
-void SMPModel::showVPHistory(bool sqlP) const {
-    assert(numAct == actrs.size());
-    assert(numDim == dimName.size());
+function<bool(unsigned int iter, const State * s)> SMPModel::quietStop(unsigned int maxIter, double qf) {
+    auto sfn = [maxIter, qf](unsigned int iter, const State * s) {
+        bool tooLong = (maxIter <= iter);
+        bool quiet = false;
+        if (1 < iter) {
+            auto s0 = ((const SMPState*)(s->model->history[0]));
+            auto s1 = ((const SMPState*)(s->model->history[1]));
+            auto sx = ((const SMPState*)(s->model->history[iter - 0]));
+            auto sy = ((const SMPState*)(s->model->history[iter - 1]));
+            quiet = (stateDist(sx, sy) < stateDist(s0, s1) / qf);
+        }
+        return tooLong || quiet;
+    };
+    return sfn;
+}
 
-    assert(nullptr != smpDB);
+
+void SMPModel::sqlVPHistory() const {
+    if (nullptr == smpDB) {
+        return;
+    }
     char* zErrMsg = nullptr;
     createSMPTableSQL(0); // VectorPosition
     auto sqlBuff = newChars(200);
@@ -1027,65 +1221,84 @@ void SMPModel::showVPHistory(bool sqlP) const {
 
     sqlite3_exec(smpDB, "BEGIN TRANSACTION", NULL, NULL, &zErrMsg);
 
-    // show positions over time
+    // turns dropped without spilling are not recorded
+    auto posHist = vector<KMatrix>(history.size());
+    auto haveHist = vector<bool>(history.size());
+    for (unsigned int t = 0; t < history.size(); t++) {
+        haveHist[t] = turnPositions(t, posHist[t]);
+    }
+
     for (unsigned int i = 0; i < numAct; i++) {
         for (unsigned int k = 0; k < numDim; k++) {
-            printf("%s , %s , ", actrs[i]->name.c_str(), dimName[k].c_str());
             for (unsigned int t = 0; t < history.size(); t++) {
-                auto st = history[t];
-                auto pit = st->pstns[i];
-                auto vpit = (const VctrPstn*)pit;
-                assert(1 == vpit->numC());
-                assert(numDim == vpit->numR());
-                printf("%5.1f , ", 100 * (*vpit)(k, 0)); // have to print "100.0" sometimes
-                if (sqlP) {
-                    int rslt = 0;
-                    rslt = sqlite3_bind_int(insStmt, 1, t);
-                    assert(SQLITE_OK == rslt);
-                    rslt = sqlite3_bind_int(insStmt, 2, i);
-                    assert(SQLITE_OK == rslt);
-                    rslt = sqlite3_bind_int(insStmt, 3, k);
-                    assert(SQLITE_OK == rslt);
-                    const double coord = (*vpit)(k, 0);
-                    rslt = sqlite3_bind_double(insStmt, 4, coord);
-                    assert(SQLITE_OK == rslt);
-                    rslt = sqlite3_step(insStmt);
-                    assert(SQLITE_DONE == rslt);
-                    sqlite3_clear_bindings(insStmt);
-                    assert(SQLITE_DONE == rslt);
-                    rslt = sqlite3_reset(insStmt);
-                    assert(SQLITE_OK == rslt);
+                if (!haveHist[t]) {
+                    continue;
                 }
+                int rslt = 0;
+                rslt = sqlite3_bind_int(insStmt, 1, t);
+                assert(SQLITE_OK == rslt);
+                rslt = sqlite3_bind_int(insStmt, 2, i);
+                assert(SQLITE_OK == rslt);
+                rslt = sqlite3_bind_int(insStmt, 3, k);
+                assert(SQLITE_OK == rslt);
+                const double coord = posHist[t](i, k);
+                rslt = sqlite3_bind_double(insStmt, 4, coord);
+                assert(SQLITE_OK == rslt);
+                rslt = sqlite3_step(insStmt);
+                assert(SQLITE_DONE == rslt);
+                sqlite3_clear_bindings(insStmt);
+                assert(SQLITE_DONE == rslt);
+                rslt = sqlite3_reset(insStmt);
+                assert(SQLITE_OK == rslt);
             }
-            cout << endl;
         }
     }
 
     sqlite3_exec(smpDB, "END TRANSACTION", NULL, NULL, &zErrMsg);
-    cout << endl;
+    sqlite3_finalize(insStmt);
+    delete[] sqlBuff;
+    sqlBuff = nullptr;
+    return;
+}
 
-    // show probabilities over time.
+
+void SMPModel::showVPHistory(bool sqlP) const {
+    assert(numAct == actrs.size());
+    assert(numDim == dimName.size());
+
+    if (sqlP) {
+        sqlVPHistory();
+    }
+
+    // Turns dropped without spilling are shown as blanks, so the columns still line up.
     // Note that we have to set the aUtil matrices for the last one.
-    vector<KMatrix> prbHist = {};
-    vector<VUI> unqHist = {};
+    auto posHist = vector<KMatrix>(history.size());
+    auto prbHist = vector<KMatrix>(history.size());
+    auto havePos = vector<bool>(history.size());
+    auto havePrb = vector<bool>(history.size());
     for (unsigned int t = 0; t < history.size(); t++) {
-        auto sst = (SMPState*)history[t];
-        assert(numAct ==  sst->aUtil.size()); // should be fully initialized
-        auto pn = sst->pDist(-1);
-        auto pdt = std::get<0>(pn); // note that these are unique positions
-        auto unq = std::get<1>(pn);
-        prbHist.push_back(pdt);
-        unqHist.push_back(unq);
+        havePos[t] = turnPositions(t, posHist[t]);
+        havePrb[t] = turnProbs(t, prbHist[t]);
     }
 
-    auto probIT = [this, prbHist, unqHist](unsigned int i, unsigned int t) {
-        auto pdt = prbHist[t];
-        auto unq = unqHist[t];
-        auto sst = ((const SMPState*)(history[t]));
-        double pr = sst->posProb(i, unq, pdt);
-        return pr;
-    };
+    // show positions over time
+    for (unsigned int i = 0; i < numAct; i++) {
+        for (unsigned int k = 0; k < numDim; k++) {
+            printf("%s , %s , ", actrs[i]->name.c_str(), dimName[k].c_str());
+            for (unsigned int t = 0; t < history.size(); t++) {
+                if (havePos[t]) {
+                    printf("%5.1f , ", 100 * posHist[t](i, k)); // have to print "100.0" sometimes
+                }
+                else {
+                    printf("      , ");
+                }
+            }
+            cout << endl;
+        }
+    }
+    cout << endl;
 
+    // show probabilities over time.
     // TODO: displaying the probabilities of actors winning is a bit odd,
     // as we display the probability of their position winning. As multiple
     // actors often occupy the equivalent positions, this means the displayed probabilities
@@ -1093,7 +1306,12 @@ void SMPModel::showVPHistory(bool sqlP) const {
     for (unsigned int i = 0; i < numAct; i++) {
         printf("%s , prob , ", actrs[i]->name.c_str());
         for (unsigned int t = 0; t < history.size(); t++) {
-            printf("%.4f , ", probIT(i, t)); //  prbHist[t](i, 0),
+            if (havePrb[t]) {
+                printf("%.4f , ", prbHist[t](i, 0));
+            }
+            else {
+                printf("       , ");
+            }
         }
         cout << endl << flush;
     }
@@ -1101,24 +1319,237 @@ void SMPModel::showVPHistory(bool sqlP) const {
 }
 
 
+void SMPModel::spillHistory(string fName) {
+    if (nullptr != spillFile) {
+        fclose(spillFile);
+    }
+    spillFile = fopen(fName.c_str(), "w+b");
+    if (nullptr == spillFile) {
+        throw KException("SMPModel::spillHistory: could not open " + fName);
+    }
+    spillT0 = 0;
+    spillN = 0;
+    histPolicy = KBase::HistoryPolicy::Spill;
+    spill = [this](unsigned int t, const State * s) {
+        writeSpill(t, (const SMPState*) s);
+        return;
+    };
+    return;
+}
+
+
+void SMPModel::writeSpill(unsigned int t, const SMPState* s) {
+    assert(nullptr != spillFile);
+    assert(nullptr != s);
+    if (0 == spillN) {
+        spillT0 = t;
+    }
+    assert(spillT0 + spillN == t); // Model::trimHistory spills in turn order
+
+    const unsigned int nPos = numAct * numDim;
+    auto rcd = vector<double>(nPos + numAct, std::nan(""));
+    for (unsigned int i = 0; i < numAct; i++) {
+        auto vpi = (const VctrPstn*)(s->pstns[i]);
+        for (unsigned int k = 0; k < numDim; k++) {
+            rcd[(i * numDim) + k] = (*vpi)(k, 0);
+        }
+    }
+    if (numAct == s->aUtil.size()) {
+        auto pn = s->pDist(-1);
+        auto pdt = get<0>(pn);
+        auto unq = get<1>(pn);
+        for (unsigned int i = 0; i < numAct; i++) {
+            rcd[nPos + i] = s->posProb(i, unq, pdt);
+        }
+    }
+
+    const uint64_t t64 = t;
+    fseek(spillFile, 0, SEEK_END);
+    const bool ok = (1 == fwrite(&t64, sizeof(t64), 1, spillFile))
+                    && (rcd.size() == fwrite(rcd.data(), sizeof(double), rcd.size(), spillFile));
+    if (!ok) {
+        throw KException("SMPModel::writeSpill: could not write the spill file");
+    }
+    spillN++;
+    return;
+}
+
+
+bool SMPModel::readSpill(unsigned int t, vector<double> & rcd) const {
+    if ((nullptr == spillFile) || (t < spillT0) || (spillT0 + spillN <= t)) {
+        return false;
+    }
+    const unsigned int nv = (numAct * numDim) + numAct;
+    const long rcdBytes = sizeof(uint64_t) + (nv * sizeof(double));
+    rcd = vector<double>(nv);
+    uint64_t t64 = 0;
+    fseek(spillFile, (t - spillT0) * rcdBytes, SEEK_SET);
+    const bool ok = (1 == fread(&t64, sizeof(t64), 1, spillFile))
+                    && (nv == fread(rcd.data(), sizeof(double), nv, spillFile));
+    if ((!ok) || (t != t64)) {
+        throw KException("SMPModel::readSpill: spill file is damaged");
+    }
+    return true;
+}
+
+
+bool SMPModel::turnPositions(unsigned int t, KMatrix & pos) const {
+    assert(t < history.size());
+    if (nullptr != history[t]) {
+        pos = KMatrix(numAct, numDim);
+        for (unsigned int i = 0; i < numAct; i++) {
+            auto vpit = (const VctrPstn*)(history[t]->pstns[i]);
+            assert(1 == vpit->numC());
+            assert(numDim == vpit->numR());
+            for (unsigned int k = 0; k < numDim; k++) {
+                pos(i, k) = (*vpit)(k, 0);
+            }
+        }
+        return true;
+    }
+    auto rcd = vector<double>();
+    if (!readSpill(t, rcd)) {
+        return false;
+    }
+    pos = KMatrix::arrayInit(rcd.data(), numAct, numDim);
+    return true;
+}
+
+
+bool SMPModel::turnProbs(unsigned int t, KMatrix & prb) const {
+    assert(t < history.size());
+    if (nullptr != history[t]) {
+        auto sst = ((const SMPState*)(history[t]));
+        if (numAct != sst->aUtil.size()) {
+            // e.g. the newest state, or one restored from a checkpoint
+            history[t]->setAUtil(-1, ReportingLevel::Silent);
+        }
+        auto pn = sst->pDist(-1);
+        auto pdt = get<0>(pn); // note that these are unique positions
+        auto unq = get<1>(pn);
+        prb = KMatrix(numAct, 1);
+        for (unsigned int i = 0; i < numAct; i++) {
+            prb(i, 0) = sst->posProb(i, unq, pdt);
+        }
+        return true;
+    }
+    auto rcd = vector<double>();
+    if (!readSpill(t, rcd) || std::isnan(rcd[numAct * numDim])) {
+        return false;
+    }
+    prb = KMatrix::arrayInit(rcd.data() + (numAct * numDim), numAct, 1);
+    return true;
+}
+
+
+SMPScenario SMPScenario::perturb(PRNG * rng, double capNoise, double posNoise, double salNoise) const {
+    auto sc = *this;
+    const unsigned int na = sc.numAct();
+    const unsigned int nd = sc.numDim();
+
+    // multiplicative noise, in [1-f, 1+f]
+    auto noise = [rng](double f) {
+        return (0 < f) ? (1.0 + rng->uniform(-f, +f)) : 1.0;
+    };
+    auto clip = [](double x) {
+        return (x < 0.0) ? 0.0 : ((1.0 < x) ? 1.0 : x);
+    };
+
+    for (unsigned int i = 0; i < na; i++) {
+        sc.cap(i, 0) = sc.cap(i, 0) * noise(capNoise);
+
+        double salI = 0.0;
+        for (unsigned int j = 0; j < nd; j++) {
+            sc.pos(i, j) = clip(sc.pos(i, j) + ((0 < posNoise) ? rng->uniform(-posNoise, +posNoise) : 0.0));
+            sc.sal(i, j) = clip(sc.sal(i, j) * noise(salNoise));
+            salI = salI + sc.sal(i, j);
+        }
+        if (1.0 < salI) { // no more than 100% of attention to all issues
+            for (unsigned int j = 0; j < nd; j++) {
+                sc.sal(i, j) = sc.sal(i, j) / salI;
+            }
+        }
+    }
+    return sc;
+}
+
+
+SMPScenario SMPScenario::random(PRNG * rng, unsigned int numAct, unsigned int numDim,
+                                double salSparsity, double capSkew) {
+    assert(2 < numAct);
+    assert(0 < numDim);
+    assert((0.0 <= salSparsity) && (salSparsity < 1.0));
+    assert(0.0 <= capSkew);
+
+    auto sc = SMPScenario();
+    auto buff = newChars(100);
+    sprintf(buff, "Synthetic-%uA-%uD", numAct, numDim);
+    sc.name = buff;
+    for (unsigned int i = 0; i < numAct; i++) {
+        sprintf(buff, "Actor-%04u", i);
+        sc.aName.push_back(buff);
+        sprintf(buff, "Synthetic actor %u", i);
+        sc.aDesc.push_back(buff);
+    }
+    for (unsigned int j = 0; j < numDim; j++) {
+        sprintf(buff, "Dim-%03u", j);
+        sc.dName.push_back(buff);
+    }
+    delete[] buff;
+    buff = nullptr;
+
+    sc.cap = KMatrix(numAct, 1);
+    sc.pos = KMatrix::uniform(rng, numAct, numDim, 0.0, 1.0);
+    sc.sal = KMatrix(numAct, numDim);
+    for (unsigned int i = 0; i < numAct; i++) {
+        const double u = rng->uniform(1E-6, 1.0);
+        sc.cap(i, 0) = 100.0 * pow(u, capSkew);
+
+        // at least one dimension matters to each actor, whatever the sparsity
+        const unsigned int jMust = rng->uniform() % numDim;
+        double s = 0.0;
+        for (unsigned int j = 0; j < numDim; j++) {
+            const bool use = (j == jMust) || (salSparsity <= rng->uniform(0.0, 1.0));
+            sc.sal(i, j) = use ? rng->uniform(0.1, 1.0) : 0.0;
+            s = s + sc.sal(i, j);
+        }
+        // between half and all of their attention goes to these issues
+        const double tot = rng->uniform(0.5, 1.0);
+        for (unsigned int j = 0; j < numDim; j++) {
+            sc.sal(i, j) = tot * sc.sal(i, j) / s;
+        }
+    }
+    return sc;
+}
+
+
 SMPModel * SMPModel::readCSV(string fName, PRNG * rng) {
+    // now that it is read and verified, use the data
+    auto sc = parseCSV(fName);
+    auto sm0 = SMPModel::initModel(sc, rng);
+    return sm0;
+}
+
+
+SMPScenario SMPModel::parseCSV(string fName, ReportingLevel rl) {
     using KBase::KException;
     const unsigned int minNumActor = 3;
-    const unsigned int maxNumActor = 100; // It's just a demo
-    char * errBuff = newChars(100); // as sprintf requires
-    csv_parser csv(fName);
-    // Get values according to row number and column number.
-    // Remember it starts from (1,1) and not (0,0)
-    string scenName = csv.get_value(1, 1);
-    cout << "Scenario name: |" << scenName << "|" << endl;
-    cout << flush;
-    string numActorString = csv.get_value(1, 3);
-    unsigned int numActor = atoi(numActorString.c_str());
-    string numDimString = csv.get_value(1, 4);
-    int numDim = atoi(numDimString.c_str());
-    printf("Number of actors: %u \n", numActor);
-    printf("Number of dimensions: %i \n", numDim);
-    cout << endl << flush;
+    const unsigned int maxNumActor = 10000; // large, but still sane
+    char errBuff[200]; // as sprintf requires
+
+    // One pass over the mapped file splits it into fields; the values
+    // are then converted straight into the matrices.
+    // Rows and columns count from (0,0).
+    const auto csv = KBase::CSVTable(fName);
+    const string scenName = csv.str(0, 0);
+    const int64_t numActor = csv.integer(0, 2);
+    const int64_t numDim = csv.integer(0, 3);
+    if (KLOG_ON(ReportingLevel::Low, rl)) {
+        cout << "Scenario name: |" << scenName << "|" << endl;
+        printf("Number of actors: %lli \n", (long long)numActor);
+        printf("Number of dimensions: %lli \n", (long long)numDim);
+        cout << endl << flush;
+    }
 
     if (numDim < 1) { // lower limit
         throw(KBase::KException("SMPModel::readCSV: Invalid number of dimensions"));
@@ -1129,115 +1560,137 @@ SMPModel * SMPModel::readCSV(string fName, PRNG * rng) {
     }
     assert(minNumActor <= numActor);
     assert(numActor <= maxNumActor);
+    const unsigned int na = numActor;
+    const unsigned int nd = numDim;
+    if (csv.numRows() < 2 + na) {
+        sprintf(errBuff, "SMPModel::readCSV: Expected %u actor rows, found %u",
+                na, ((2 < csv.numRows()) ? csv.numRows() - 2 : 0));
+        throw(KException(errBuff));
+    }
+
+    // get issue names
+    auto dNames = vector<string>();
+    for (unsigned int j = 0; j < nd; j++) {
+        dNames.push_back(csv.str(1, 3 + 2 * j));
+        KLOG(ReportingLevel::Medium, rl, "Dimension %2u: %s \n", j, dNames[j].c_str());
+    }
+    KLOG(ReportingLevel::Medium, rl, "\n");
 
     // Read actor data
     auto actorNames = vector<string>();
     auto actorDescs = vector<string>();
-    auto cap = KMatrix(numActor, 1);
-    auto nra = KMatrix(numActor, 1);
-    for (unsigned int i = 0; i < numActor; i++) {
+    auto cap = KMatrix(na, 1);
+    auto pos = KMatrix(na, nd);
+    auto sal = KMatrix(na, nd);
+    for (unsigned int i = 0; i < na; i++) {
+        const unsigned int r = 2 + i;
+
         // get short names
-        string nis = csv.get_value(3 + i, 1);
-        assert(0 < nis.length());
+        string nis = csv.str(r, 0);
+        if (0 == nis.length()) {
+            sprintf(errBuff, "SMPModel::readCSV: Missing name for actor %u", i);
+            throw(KException(errBuff));
+        }
         actorNames.push_back(nis);
-        printf("Actor %3u name: %s \n", i, actorNames[i].c_str());
 
         // get long descriptions
-        string descsi = csv.get_value(3 + i, 2);
-        actorDescs.push_back(descsi);
-        printf("Actor %3u desc: %s \n", i, actorDescs[i].c_str());
+        actorDescs.push_back(csv.str(r, 1));
 
         // get capability/power, often on 0-100 scale
-        string psi = csv.get_value(3 + i, 3);
-        double pi = atof(psi.c_str());
-        printf("Actor %3u power: %5.1f \n", i, pi);
+        const double pi = csv.real(r, 2);
         assert(0 <= pi); // zero weight is pointless, but not incorrect
         assert(pi < 1E8); // no real upper limit, so this is just a sanity-check
         cap(i, 0) = pi;
 
+        if (KLOG_ON(ReportingLevel::Medium, rl)) {
+            printf("Actor %3u name: %s \n", i, actorNames[i].c_str());
+            printf("Actor %3u desc: %s \n", i, actorDescs[i].c_str());
+            printf("Actor %3u power: %5.1f \n", i, pi);
+            cout << endl << flush;
+        }
 
-        cout << endl << flush;
-
-    } // loop over actors, i
-
-
-    // get issue names
-    auto dNames = vector<string>();
-    for (unsigned int j = 0; j < numDim; j++) {
-        string insi = csv.get_value(2, 4 + 2 * j);
-        dNames.push_back(insi);
-        printf("Dimension %2u: %s \n", j, dNames[j].c_str());
-    }
-    cout << endl;
-
-    // get position/salience data
-    auto pos = KMatrix(numActor, numDim);
-    auto sal = KMatrix(numActor, numDim);
-    for (unsigned int i = 0; i < numActor; i++) {
+        // get position/salience data
         double salI = 0.0;
-        for (unsigned int j = 0; j < numDim; j++) {
-            string posSIJ = csv.get_value(3 + i, 4 + 2 * j);
-            double posIJ = atof(posSIJ.c_str());
-            printf("pos[%3u , %3u] =  %5.3f \n", i, j, posIJ);
-            cout << flush;
+        for (unsigned int j = 0; j < nd; j++) {
+            const double posIJ = csv.real(r, 3 + 2 * j);
+            KLOG(ReportingLevel::High, rl, "pos[%3u , %3u] =  %5.3f \n", i, j, posIJ);
             if ((posIJ < 0.0) || (+100.0 < posIJ)) { // lower and upper limit
-                errBuff = newChars(100);
                 sprintf(errBuff, "SMPModel::readCSV: Out-of-bounds position for actor %u on dimension %u:  %f",
                         i, j, posIJ);
                 throw(KException(errBuff));
             }
             assert(0.0 <= posIJ);
             assert(posIJ <= 100.0);
-            pos(i, j) = posIJ;
+            pos(i, j) = posIJ / 100.0;
 
-            string salSIJ = csv.get_value(3 + i, 5 + 2 * j);
-            double salIJ = atof(salSIJ.c_str());
-            //printf("sal[%3i , %3i] = %5.3f \n", i, j, salIJ);
-            //cout << flush;
+            const double salIJ = csv.real(r, 4 + 2 * j);
             if ((salIJ < 0.0) || (+100.0 < salIJ)) { // lower and upper limit
-                errBuff = newChars(100);
                 sprintf(errBuff, "SMPModel::readCSV: Out-of-bounds salience for actor %u on dimension %u:  %f",
                         i, j, salIJ);
                 throw(KException(errBuff));
             }
             assert(0.0 <= salIJ);
             salI = salI + salIJ;
-            //printf("sal[%3i] = %5.3f \n", i, salI);
-            //cout << flush;
             if (+100.0 < salI) { // upper limit: no more than 100% of attention to all issues
-                errBuff = newChars(100);
                 sprintf(errBuff,
                         "SMPModel::readCSV: Out-of-bounds total salience for actor %u:  %f",
                         i, salI);
                 throw(KException(errBuff));
             }
             assert(salI <= 100.0);
-            sal(i, j) = (double)salIJ;
-            //cout << endl << flush;
+            sal(i, j) = salIJ / 100.0;
         }
-    }
-
-    cout << "Position matrix:" << endl;
-    pos.mPrintf("%5.1f  ");
-    cout << endl << endl << flush;
-    cout << "Salience matrix:" << endl;
-    sal.mPrintf("%5.1f  ");
-    cout << endl << flush;
+    } // loop over actors, i
 
-    // get them into the proper internal scale:
-    pos = pos / 100.0;
-    sal = sal / 100.0;
+    if (KLOG_ON(ReportingLevel::Medium, rl)) {
+        // same scale as the CSV input
+        cout << "Position matrix:" << endl;
+        (100.0 * pos).mPrintf("%5.1f  ");
+        cout << endl << endl << flush;
+        cout << "Salience matrix:" << endl;
+        (100.0 * sal).mPrintf("%5.1f  ");
+        cout << endl << flush;
+    }
 
-    // now that it is read and verified, use the data
-    auto sm0 = SMPModel::initModel(actorNames, actorDescs, dNames, cap, pos, sal, rng);
-    return sm0;
+    // already on the proper internal scale
+    auto sc = SMPScenario();
+    sc.name = scenName;
+    sc.aName = actorNames;
+    sc.aDesc = actorDescs;
+    sc.dName = dNames;
+    sc.cap = cap;
+    sc.pos = pos;
+    sc.sal = sal;
+    return sc;
 }
 
 
 
 SMPModel * SMPModel::initModel(vector<string> aName, vector<string> aDesc, vector<string> dName,
                                KMatrix cap, KMatrix pos, KMatrix sal, PRNG * rng) {
-    SMPModel * sm0 = new SMPModel(rng);
+    auto sc = SMPScenario();
+    sc.aName = aName;
+    sc.aDesc = aDesc;
+    sc.dName = dName;
+    sc.cap = cap;
+    sc.pos = pos;
+    sc.sal = sal;
+    return initModel(sc, rng);
+}
+
+
+SMPModel * SMPModel::initModel(const SMPScenario & sc, PRNG * rng, string desc, string dbName) {
+    const vector<string> & aName = sc.aName;
+    const vector<string> & aDesc = sc.aDesc;
+    const vector<string> & dName = sc.dName;
+    const KMatrix & cap = sc.cap;
+    const KMatrix & pos = sc.pos;
+    const KMatrix & sal = sc.sal;
+    assert(aDesc.size() == aName.size());
+    assert(aName.size() == cap.numR());
+    assert(KBase::sameShape(pos, sal));
+
+    SMPModel * sm0 = new SMPModel(rng, desc, dbName);
     SMPState * st0 = new SMPState(sm0);
     st0->step = [st0]() {
         return st0->stepBCN();
@@ -1266,6 +1719,9 @@ SMPModel * SMPModel::initModel(vector<string> aName, vector<string> aDesc, vecto
         st0->addPstn(vpi);
     }
 
+    // the first step needs to know which positions are unique
+    st0->setUENdx();
+
     return sm0;
 }
 
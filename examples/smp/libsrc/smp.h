@@ -34,6 +34,7 @@
 #include "kmatrix.h"
 #include "gaopt.h"
 #include "kmodel.h"
+#include "kcsv.h"
 
 namespace SMPLib {
 // namespace to which KBase has no access
@@ -62,6 +63,94 @@ class SMPModel;
 
 const string appVersion = "0.1";
 
+// -------------------------------------------------
+// Plain-Old-Data: a scenario as read from CSV, with positions and
+// saliences already on the internal [0,1] scale. Once parsed, it is
+// only read, so many runs can share one copy.
+struct SMPScenario {
+    string name = "";
+    vector<string> aName = {};
+    vector<string> aDesc = {};
+    vector<string> dName = {};
+    KMatrix cap = KMatrix(); // numAct-by-1
+    KMatrix pos = KMatrix(); // numAct-by-numDim
+    KMatrix sal = KMatrix(); // numAct-by-numDim
+
+    unsigned int numAct() const {
+        return aName.size();
+    }
+    unsigned int numDim() const {
+        return dName.size();
+    }
+
+    // relative perturbation of inputs, e.g. 0.1 means +/- 10%, uniformly.
+    // Positions and saliences stay within [0,1], and total salience within 1.
+    SMPScenario perturb(PRNG * rng, double capNoise, double posNoise, double salNoise) const;
+
+    // Synthetic scenario, scaled like parseCSV output, for testing at large sizes.
+    // salSparsity is the chance that an actor ignores a dimension (each still has at least one),
+    // and capabilities are 100*u^capSkew with u uniform on (0,1): 0 makes all equal,
+    // 1 is uniform, and larger values give a few dominant actors.
+    static SMPScenario random(PRNG * rng, unsigned int numAct, unsigned int numDim,
+                              double salSparsity = 0.0, double capSkew = 1.0);
+
+    // Save in the binary layout read by SMPScenarioMap. Throws KException on failure.
+    void writeBinary(string fName) const;
+};
+
+// -------------------------------------------------
+// A binary scenario file, mapped into memory and read in place.
+// Nothing is parsed: the header gives the offsets of the capability, position
+// and salience arrays (doubles, internal scale, row-major), and of a table of
+// strings (scenario name, actor names, actor descriptions, dimension names).
+// Every offset is a multiple of 8 from the start of the file, so the arrays
+// can be used directly from the mapping. As the mapping is read-only and shared,
+// many processes reading the same file share one copy in the page cache.
+// Throws KException if the file is not a valid scenario of this version.
+class SMPScenarioMap {
+public:
+    static const uint32_t Version = 1;
+
+    explicit SMPScenarioMap(string fName);
+    virtual ~SMPScenarioMap();
+
+    // does the file start with the right magic number?
+    static bool isBinary(string fName);
+
+    unsigned int numAct() const {
+        return na;
+    }
+    unsigned int numDim() const {
+        return nd;
+    }
+
+    const double* cap() const; // numAct
+    const double* pos() const; // numAct-by-numDim
+    const double* sal() const; // numAct-by-numDim
+
+    string name() const;
+    string aName(unsigned int i) const;
+    string aDesc(unsigned int i) const;
+    string dName(unsigned int j) const;
+
+    // copy everything out into an ordinary scenario
+    SMPScenario scenario() const;
+
+protected:
+    string str(unsigned int k) const;
+    const char* base() const {
+        return file->data();
+    }
+
+    std::shared_ptr<KBase::MappedFile> file = nullptr;
+    unsigned int na = 0;
+    unsigned int nd = 0;
+    uint64_t capOff = 0;
+    uint64_t posOff = 0;
+    uint64_t salOff = 0;
+    uint64_t strOff = 0;
+};
+
 // -------------------------------------------------
 // Plain-Old-Data
 struct BargainSMP {
@@ -123,6 +212,8 @@ public:
 
 
 protected:
+    struct InterpK; // the loop over dimensions in interpolateBrgn; see byDim in smp.cpp
+
     static void interpBrgnSnPm(unsigned int n, unsigned int m,
                                double tik, double sik, double prbI,
                                double tjk, double sjk, double prbJ,
@@ -172,6 +263,14 @@ public:
     // return actor's normalized risk attitude (if set)
     double aNRA(unsigned int i) const;
 
+    virtual uint64_t memBytes() const;
+
+    // returns estimated probability k wins (given likely coaltiions), and expected value of that challenge
+    tuple<double, double> probEduChlg(unsigned int h, unsigned int k, unsigned int i, unsigned int j) const;
+
+    // return best j, p[i>j], edu[i->j]
+    tuple<int, double, double> bestChallenge(unsigned int i) const;
+
 protected:
 
     // this sets the values in all the AUtil matrices
@@ -180,6 +279,7 @@ protected:
     virtual void setOneAUtil(unsigned int perspH, ReportingLevel rl); 
     
     KMatrix vDiff = KMatrix(); // vDiff(i,j) = difference between pos[i] and pos[j], using actor i's saliences as weights
+    KBase::KMatrixF vDiffF = KBase::KMatrixF(); // the same, but set instead of vDiff when the model is singlePrec
     KMatrix rnProb = KMatrix(); // probability of each Unique state, when actors are treated as risk-neutral
 
     // risk-aware probabilities are uProb
@@ -190,37 +290,79 @@ protected:
     SMPState* doBCN() const;
     virtual bool equivNdx(unsigned int i, unsigned int j) const;
 
-    // returns estimated probability k wins (given likely coaltiions), and expected value of that challenge
-    tuple<double, double> probEduChlg(unsigned int h, unsigned int k, unsigned int i, unsigned int j) const;
-
-    // return best j, p[i>j], edu[i->j]
-    tuple<int, double, double> bestChallenge(unsigned int i) const;
-
 };
 
 class SMPModel : public Model {
 public:
-    explicit SMPModel(PRNG * rng, string desc = "");
+    // An empty dbName means no database is opened, so nothing is recorded
+    explicit SMPModel(PRNG * rng, string desc = "", string dbName = "test.db");
     virtual ~SMPModel();
 
     static double bsUtil(double sd, double R);
     static double bvDiff(const KMatrix & vd, const  KMatrix & vs);
+    static double bvDiff(const KMatrix & p0, const KMatrix & p1, const KMatrix & vs); // bvDiff(p0 - p1, vs)
     static double bvUtil(const KMatrix & vd, const  KMatrix & vs, double R);
 
     static SMPModel * readCSV(string fName, PRNG * rng);
 
+    // read and verify the CSV, without building a model.
+    // Details of each actor are shown at Medium, and of each position at High.
+    static SMPScenario parseCSV(string fName, ReportingLevel rl = ReportingLevel::Medium);
+
+    // as readCSV and parseCSV, for a file written by SMPScenario::writeBinary
+    static SMPModel * readBinary(string fName, PRNG * rng);
+    static SMPScenario parseBinary(string fName);
+
+    // parseBinary if it is a binary scenario file, otherwise parseCSV
+    static SMPScenario parseScenario(string fName, ReportingLevel rl = ReportingLevel::Medium);
+
     static  SMPModel * initModel(vector<string> aName, vector<string> aDesc, vector<string> dName,
                                  KMatrix cap, KMatrix pos, KMatrix sal, PRNG * rng);
 
+    // build the model and its initial state, ready to run
+    static  SMPModel * initModel(const SMPScenario & sc, PRNG * rng,
+                                 string desc = "", string dbName = "test.db");
+
     // print history of each actor in CSV (might want to generalize to arbitrary VctrPstn)
     void showVPHistory(bool sqlP) const;
 
+    // record history of each actor's position to SQLite, without printing
+    void sqlVPHistory() const;
+
+    // Keep only the ends of the history in memory (see HistoryPolicy), spilling
+    // the other turns to a compact file: the positions, and the probability of
+    // each actor's position. Throws KException if the file cannot be opened.
+    void spillHistory(string fName);
+
+    // Positions (numAct-by-numDim) and probabilities of each actor's position
+    // (numAct-by-1) at turn t, from memory or from the spill file. Probabilities
+    // need the state's aUtil. Each returns false if turn t is not available.
+    bool turnPositions(unsigned int t, KMatrix & pos) const;
+    bool turnProbs(unsigned int t, KMatrix & prb) const;
+
+    // Carry on a run from a checkpoint (see Model::saveCheckpoint), under the same
+    // scenario name and database; rows already recorded for the turns to be redone
+    // are deleted first. The stop λ-fn has to be set again.
+    static SMPModel * resume(string ckptFile, PRNG * rng);
+
+    // Start a what-if run from a checkpoint, under a new name and database
+    static SMPModel * fork(string ckptFile, PRNG * rng, string desc, string dbName);
+
+    // stop after maxIter, or when the last step is less than 1/qf of the first one
+    static function<bool(unsigned int iter, const State * s)> quietStop(unsigned int maxIter, double qf);
+
     // number of spatial dimensions in this SMP
     void addDim(string dn);
     unsigned int numDim = 0;
     vector<string> dimName = {};
     double posTol = 1E-3; // on a scale of 0 to 100, this is a difference of just 0.1
 
+    // If true, the turn kernels (the matrix of differences and the utility matrices)
+    // are computed in single precision, and widened to double only where other code
+    // reads them. It is meant for large exploratory sweeps; SMPEnsemble::checkSinglePrec
+    // shows how far the final results move.
+    bool singlePrec = false;
+
     static double stateDist(const SMPState* s1, const SMPState* s2);
 
     // this does not set AUtil, just output it to SQLite
@@ -232,7 +374,7 @@ protected:
 protected:
     // note that the function to write to table #k must be kept
     // synchronized with the result of createTableSQL(k) !
-    void sqlTest();
+    void sqlTest(string dbName);
 
     // note that the function to write to table #k must be kept
     // synchronized with the result of createTableSQL(k) !
@@ -241,10 +383,149 @@ protected:
     // compute several useful items implied by the risk attitudes, saliences, and the matrix of differences
     static void setUtilProb(const KMatrix& vR, const KMatrix& vS, const KMatrix& vD, KBase::VotingRule vr);
 
+    virtual void writeCkptModel(KBase::BinWriter & bw) const;
+    virtual void readCkptModel(KBase::BinReader & br);
+    virtual void writeCkptState(KBase::BinWriter & bw, const State* s) const;
+    virtual State* readCkptState(KBase::BinReader & br);
+
+    // Each spilled turn is a record of the turn number (uint64), then the positions
+    // and probabilities (doubles, NaN if the state had no aUtil), at a fixed size.
+    void writeSpill(unsigned int t, const SMPState* s);
+    bool readSpill(unsigned int t, vector<double> & rcd) const;
+    FILE* spillFile = nullptr;
+    unsigned int spillT0 = 0; // first turn in the spill file
+    unsigned int spillN = 0; // number of turns in the spill file
+
 private:
 };
 
 
+// -------------------------------------------------
+// Run one scenario many times, in parallel, to see how sensitive the
+// outcome is to the random seed and to noise in the input data.
+// Each run gets its own PRNG (seeded from one master seed, so the whole
+// ensemble is reproducible), its own model, and optionally its own database.
+// Nothing mutable is shared between runs, so no locking is needed inside a run.
+class SMPEnsemble {
+public:
+    SMPEnsemble(const SMPScenario & sc, unsigned int nr, uint64_t seed);
+    virtual ~SMPEnsemble();
+
+    unsigned int numThreads = 0; // 0 means one per hardware thread
+    unsigned int maxTurns = 100;
+    double quietFactor = 20.0; // stop when the last step is this much smaller than the first
+
+    // relative perturbation of inputs, see SMPScenario::perturb
+    double capNoise = 0.0;
+    double posNoise = 0.0;
+    double salNoise = 0.0;
+
+    // If dbPrefix is not empty, run r records to its own file "<dbPrefix>-<r>.db"
+    string dbPrefix = "";
+    ReportingLevel runRL = ReportingLevel::Silent;
+
+    // If logPrefix is not empty, the messages of run r, at level runRL,
+    // go to its own file "<logPrefix>-<r>.log" rather than to stdout
+    string logPrefix = "";
+
+    bool singlePrec = false; // see SMPModel::singlePrec
+
+    void run();
+    void showResults() const;
+
+    // Validate single precision: do every run both in double and in single precision,
+    // from the same seeds, and compare the final positions and final probabilities
+    // run by run. Positions are on the 0-to-1 scale, so the default position tolerance
+    // is 1 point on the usual 0-to-100 scale. Prints the largest differences,
+    // and returns true if all are within tolerance.
+    bool checkSinglePrec(double posTol = 0.01, double prbTol = 0.01);
+
+    // Aggregate results, set by run()
+    KMatrix posMean = KMatrix(); // final positions, numAct-by-numDim
+    KMatrix posStdv = KMatrix();
+    KMatrix prbMean = KMatrix(); // final probability of each actor's position, numAct-by-1
+    KMatrix prbStdv = KMatrix();
+    KMatrix prbMin = KMatrix();
+    KMatrix prbMax = KMatrix();
+    vector<unsigned int> numTurns = {}; // per run
+
+protected:
+    // final result of one run
+    struct RunRslt {
+        KMatrix pos = KMatrix();
+        KMatrix prb = KMatrix();
+        unsigned int turns = 0;
+    };
+
+    RunRslt runOne(unsigned int r) const;
+    vector<RunRslt> runAll() const;
+    void aggregate(const vector<RunRslt> & rslts);
+
+    const SMPScenario scen;
+    const unsigned int numRuns;
+    vector<uint64_t> seeds = {};
+};
+
+
+// -------------------------------------------------
+// A queue of (scenario, seed, noise) jobs kept in a small SQLite file,
+// so that many worker processes (possibly on different machines sharing
+// a filesystem) can pull jobs from it. Each worker records its results
+// into its own shard database, named "<shardPrefix>-<workerID>.db",
+// with one scenario name per job. A job is claimed with a lease; if the
+// worker dies, the claim expires and some other worker redoes the job.
+// Leases are not renewed, so a single job must finish within leaseSec
+// (one hour by default): past that, another worker may take it, and the
+// first worker's result is then discarded when it finishes.
+// Only shard rows for jobs that finished in that shard get merged, so
+// the partial output of a crashed job is never merged.
+class SMPJobQueue {
+public:
+    explicit SMPJobQueue(string qFile);
+    virtual ~SMPJobQueue();
+
+    // The k-th job runs the CSV scenario with the k-th seed drawn from seed0.
+    // Returns the number of jobs added.
+    unsigned int addJobs(string csvFile, unsigned int numSeeds, uint64_t seed0,
+                         double noise, unsigned int maxTurns);
+
+    // Claim and run jobs until none are left (or maxJobs are done, if positive).
+    // Returns the number of jobs completed.
+    unsigned int work(string workerID, string shardPrefix, unsigned int maxJobs = 0);
+
+    // Count of jobs pending, claimed, done, and failed
+    tuple<unsigned int, unsigned int, unsigned int, unsigned int> status() const;
+    void showStatus() const;
+
+    // Consolidate the finished jobs from all the shards named in the queue into one database
+    static void merge(string qFile, string outDB);
+
+    static string jobScenName(unsigned int jobID);
+
+    unsigned int leaseSec = 3600; // claims older than this are presumed dead; the ceiling on one job
+
+protected:
+    struct Job {
+        unsigned int id = 0;
+        string csvFile = "";
+        uint64_t seed = 0;
+        double noise = 0.0;
+        unsigned int maxTurns = 0;
+    };
+
+    bool claim(string workerID, Job & job);
+    // false if this worker no longer held the claim, so nothing was recorded
+    bool finish(const Job & job, string workerID, string shard, bool ok);
+    void runJob(const Job & job, const SMPScenario & sc, string shard) const;
+
+    sqlite3 * qDB = nullptr;
+
+private:
+    // the queue's database is closed by the destructor, so it must not be shared
+    SMPJobQueue(const SMPJobQueue&) = delete;
+    SMPJobQueue& operator=(const SMPJobQueue&) = delete;
+};
+
 
 };// end of namespace
 
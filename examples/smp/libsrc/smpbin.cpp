@@ -0,0 +1,334 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+//
+// A versioned binary scenario format, read in place from a memory map.
+//
+// Layout, all in the byte order of the machine that wrote it:
+//    0  char[8]    magic "KTABSMP", NUL-padded
+//    8  uint32     version
+//   12  uint32     byte-order mark 0x01020304
+//   16  uint32     numAct
+//   20  uint32     numDim
+//   24  uint64     offset of cap, numAct doubles
+//   32  uint64     offset of pos, numAct*numDim doubles
+//   40  uint64     offset of sal, numAct*numDim doubles
+//   48  uint64     offset of the string table
+//   56  uint64     total file size
+// The string table is (1 + 2*numAct + numDim + 1) uint64 offsets, then the
+// bytes of each string (no terminators): string k runs from offset k to k+1.
+//
+// --------------------------------------------
+
+#include <cstring>
+
+#include "smp.h"
+
+
+namespace SMPLib {
+using std::string;
+
+using KBase::KMatrix;
+using KBase::KException;
+using KBase::MappedFile;
+
+namespace {
+const char binMagic[8] = { 'K', 'T', 'A', 'B', 'S', 'M', 'P', 0 };
+const uint32_t binByteOrder = 0x01020304;
+const uint64_t binHeaderBytes = 64;
+
+// round up to a multiple of 8, so doubles and offsets stay aligned
+uint64_t align8(uint64_t n) {
+    return (n + 7) & ~((uint64_t)7);
+}
+
+template <typename T>
+T readAt(const char* base, uint64_t off) {
+    T x;
+    memcpy(&x, base + off, sizeof(T));
+    return x;
+}
+}; // end of anonymous namespace
+
+// --------------------------------------------
+
+void SMPScenario::writeBinary(string fName) const {
+    const uint32_t na = numAct();
+    const uint32_t nd = numDim();
+    assert(na == cap.numR());
+    assert(na == pos.numR());
+    assert(nd == pos.numC());
+    assert(na == sal.numR());
+    assert(nd == sal.numC());
+
+    auto strs = vector<string>();
+    strs.push_back(name);
+    strs.insert(strs.end(), aName.begin(), aName.end());
+    strs.insert(strs.end(), aDesc.begin(), aDesc.end());
+    strs.insert(strs.end(), dName.begin(), dName.end());
+    assert(1 + 2 * na + nd == strs.size());
+
+    const uint64_t capOff = binHeaderBytes;
+    const uint64_t posOff = capOff + 8 * (uint64_t)na;
+    const uint64_t salOff = posOff + 8 * (uint64_t)na * nd;
+    const uint64_t strOff = salOff + 8 * (uint64_t)na * nd;
+    auto sOffs = vector<uint64_t>();
+    uint64_t sOff = strOff + 8 * (strs.size() + 1);
+    for (auto& s : strs) {
+        sOffs.push_back(sOff);
+        sOff = sOff + s.length();
+    }
+    sOffs.push_back(sOff);
+    const uint64_t fileBytes = align8(sOff);
+
+    auto buff = string(fileBytes, '\0');
+    char* b = &buff[0];
+    auto put = [b](uint64_t off, const void* src, uint64_t n) {
+        memcpy(b + off, src, n);
+    };
+    const uint32_t version = SMPScenarioMap::Version;
+    put(0, binMagic, 8);
+    put(8, &version, 4);
+    put(12, &binByteOrder, 4);
+    put(16, &na, 4);
+    put(20, &nd, 4);
+    put(24, &capOff, 8);
+    put(32, &posOff, 8);
+    put(40, &salOff, 8);
+    put(48, &strOff, 8);
+    put(56, &fileBytes, 8);
+
+    // KMatrix is row-major inside, but we do not rely on it
+    for (unsigned int i = 0; i < na; i++) {
+        const double c = cap(i, 0);
+        put(capOff + 8 * i, &c, 8);
+        for (unsigned int j = 0; j < nd; j++) {
+            const uint64_t k = 8 * ((uint64_t)i * nd + j);
+            const double p = pos(i, j);
+            const double s = sal(i, j);
+            put(posOff + k, &p, 8);
+            put(salOff + k, &s, 8);
+        }
+    }
+    put(strOff, sOffs.data(), 8 * sOffs.size());
+    for (unsigned int k = 0; k < strs.size(); k++) {
+        put(sOffs[k], strs[k].data(), strs[k].length());
+    }
+
+    FILE* f = fopen(fName.c_str(), "wb");
+    if (nullptr == f) {
+        throw KException("SMPScenario::writeBinary: could not open " + fName);
+    }
+    const size_t nw = fwrite(b, 1, fileBytes, f);
+    const int rc = fclose(f);
+    if ((nw != fileBytes) || (0 != rc)) {
+        throw KException("SMPScenario::writeBinary: could not write " + fName);
+    }
+    return;
+}
+
+// --------------------------------------------
+
+SMPScenarioMap::SMPScenarioMap(string fName) {
+    const string errMsg = "SMPScenarioMap: invalid binary scenario " + fName + ": ";
+    file = std::make_shared<MappedFile>(fName);
+    const char* b = base();
+    const uint64_t n = file->size();
+    if ((n < binHeaderBytes) || (0 != memcmp(b, binMagic, 8))) {
+        throw KException(errMsg + "no magic number");
+    }
+    if (Version != readAt<uint32_t>(b, 8)) {
+        throw KException(errMsg + "unknown version");
+    }
+    if (binByteOrder != readAt<uint32_t>(b, 12)) {
+        throw KException(errMsg + "written with the other byte order");
+    }
+    na = readAt<uint32_t>(b, 16);
+    nd = readAt<uint32_t>(b, 20);
+    capOff = readAt<uint64_t>(b, 24);
+    posOff = readAt<uint64_t>(b, 32);
+    salOff = readAt<uint64_t>(b, 40);
+    strOff = readAt<uint64_t>(b, 48);
+    if ((0 == na) || (0 == nd) || (n != readAt<uint64_t>(b, 56))) {
+        throw KException(errMsg + "bad sizes");
+    }
+
+    // every region must be aligned, and lie inside the file.
+    // The matrices cannot be larger than the file, so na*nd is checked
+    // before multiplying by 8, which could then wrap.
+    const uint64_t nStr = 1 + 2 * (uint64_t)na + nd;
+    auto fits = [n](uint64_t off, uint64_t len) {
+        return (0 == off % 8) && (binHeaderBytes <= off) && (off <= n) && (len <= n - off);
+    };
+    if ((n < posOff) || ((n - posOff) / 8 < (uint64_t)na * nd)) {
+        throw KException(errMsg + "bad sizes");
+    }
+    const uint64_t mBytes = 8 * (uint64_t)na * nd;
+    if (!(fits(capOff, 8 * (uint64_t)na) && fits(posOff, mBytes) && fits(salOff, mBytes)
+            && fits(strOff, 8 * (nStr + 1)))) {
+        throw KException(errMsg + "bad offsets");
+    }
+    uint64_t prev = strOff + 8 * (nStr + 1);
+    for (uint64_t k = 0; k <= nStr; k++) {
+        const uint64_t sk = readAt<uint64_t>(b, strOff + 8 * k);
+        if ((sk < prev) || (n < sk)) {
+            throw KException(errMsg + "bad string table");
+        }
+        prev = sk;
+    }
+
+    // the same limits as parseCSV, where these were percentages
+    const double* c = cap();
+    const double* p = pos();
+    const double* s = sal();
+    char errBuff[200];
+    for (unsigned int i = 0; i < na; i++) {
+        if (!((0.0 <= c[i]) && (c[i] < 1E8))) {
+            sprintf(errBuff, "out-of-bounds capability for actor %u:  %f", i, c[i]);
+            throw KException(errMsg + errBuff);
+        }
+        double salI = 0.0;
+        for (unsigned int j = 0; j < nd; j++) {
+            const uint64_t k = (uint64_t)i * nd + j;
+            if (!((0.0 <= p[k]) && (p[k] <= 1.0))) {
+                sprintf(errBuff, "out-of-bounds position for actor %u on dimension %u:  %f", i, j, 100.0 * p[k]);
+                throw KException(errMsg + errBuff);
+            }
+            if (!((0.0 <= s[k]) && (s[k] <= 1.0))) {
+                sprintf(errBuff, "out-of-bounds salience for actor %u on dimension %u:  %f", i, j, 100.0 * s[k]);
+                throw KException(errMsg + errBuff);
+            }
+            salI = salI + s[k];
+        }
+        // allow for the rounding of percentages divided by 100
+        if (1.0 + 1E-12 < salI) {
+            sprintf(errBuff, "out-of-bounds total salience for actor %u:  %f", i, 100.0 * salI);
+            throw KException(errMsg + errBuff);
+        }
+    }
+}
+
+
+SMPScenarioMap::~SMPScenarioMap() {}
+
+
+bool SMPScenarioMap::isBinary(string fName) {
+    FILE* f = fopen(fName.c_str(), "rb");
+    if (nullptr == f) {
+        return false;
+    }
+    char m[8];
+    const bool isB = (8 == fread(m, 1, 8, f)) && (0 == memcmp(m, binMagic, 8));
+    fclose(f);
+    return isB;
+}
+
+
+const double* SMPScenarioMap::cap() const {
+    return (const double*)(base() + capOff);
+}
+
+
+const double* SMPScenarioMap::pos() const {
+    return (const double*)(base() + posOff);
+}
+
+
+const double* SMPScenarioMap::sal() const {
+    return (const double*)(base() + salOff);
+}
+
+
+string SMPScenarioMap::str(unsigned int k) const {
+    const uint64_t s0 = readAt<uint64_t>(base(), strOff + 8 * (uint64_t)k);
+    const uint64_t s1 = readAt<uint64_t>(base(), strOff + 8 * ((uint64_t)k + 1));
+    return string(base() + s0, s1 - s0);
+}
+
+
+string SMPScenarioMap::name() const {
+    return str(0);
+}
+
+
+string SMPScenarioMap::aName(unsigned int i) const {
+    assert(i < na);
+    return str(1 + i);
+}
+
+
+string SMPScenarioMap::aDesc(unsigned int i) const {
+    assert(i < na);
+    return str(1 + na + i);
+}
+
+
+string SMPScenarioMap::dName(unsigned int j) const {
+    assert(j < nd);
+    return str(1 + 2 * na + j);
+}
+
+
+SMPScenario SMPScenarioMap::scenario() const {
+    auto sc = SMPScenario();
+    sc.name = name();
+    for (unsigned int i = 0; i < na; i++) {
+        sc.aName.push_back(aName(i));
+        sc.aDesc.push_back(aDesc(i));
+    }
+    for (unsigned int j = 0; j < nd; j++) {
+        sc.dName.push_back(dName(j));
+    }
+    sc.cap = KMatrix::arrayInit(cap(), na, 1);
+    sc.pos = KMatrix::arrayInit(pos(), na, nd);
+    sc.sal = KMatrix::arrayInit(sal(), na, nd);
+    return sc;
+}
+
+// --------------------------------------------
+
+SMPModel * SMPModel::readBinary(string fName, PRNG * rng) {
+    auto sc = parseBinary(fName);
+    auto sm0 = SMPModel::initModel(sc, rng);
+    return sm0;
+}
+
+
+SMPScenario SMPModel::parseBinary(string fName) {
+    const auto sm = SMPScenarioMap(fName);
+    return sm.scenario();
+}
+
+
+SMPScenario SMPModel::parseScenario(string fName, ReportingLevel rl) {
+    if (SMPScenarioMap::isBinary(fName)) {
+        return parseBinary(fName);
+    }
+    return parseCSV(fName, rl);
+}
+
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -0,0 +1,139 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+//
+// Checkpoints of SMP runs: the model holds the dimensions and actors,
+// and each state holds just the actors' positions. Everything else is
+// recomputed when it is needed.
+//
+// --------------------------------------------
+
+#include "smp.h"
+
+
+namespace SMPLib {
+using std::get;
+using std::string;
+
+using KBase::BinReader;
+using KBase::BinWriter;
+using KBase::KException;
+using KBase::KMatrix;
+using KBase::PRNG;
+using KBase::State;
+using KBase::VctrPstn;
+using KBase::VotingRule;
+
+// --------------------------------------------
+
+SMPModel * SMPModel::resume(string ckptFile, PRNG * rng) {
+    auto names = Model::ckptNames(ckptFile);
+    auto sm = new SMPModel(rng, get<0>(names), get<1>(names));
+    sm->loadCheckpoint(ckptFile);
+    sm->sqlTruncate(sm->history.size() - 1);
+    return sm;
+}
+
+
+SMPModel * SMPModel::fork(string ckptFile, PRNG * rng, string desc, string dbName) {
+    auto sm = new SMPModel(rng, desc, dbName);
+    sm->loadCheckpoint(ckptFile);
+    return sm;
+}
+
+
+void SMPModel::writeCkptModel(BinWriter & bw) const {
+    bw.u32(numDim);
+    for (auto& dn : dimName) {
+        bw.str(dn);
+    }
+    bw.f64(posTol);
+    bw.u32(numAct);
+    for (auto a : actrs) {
+        auto sa = (const SMPActor*)a;
+        bw.str(sa->name);
+        bw.str(sa->desc);
+        bw.f64(sa->sCap);
+        bw.mat(sa->vSal);
+        bw.u32((uint32_t)(sa->vr));
+    }
+    return;
+}
+
+
+void SMPModel::readCkptModel(BinReader & br) {
+    const unsigned int nd = br.u32();
+    for (unsigned int k = 0; k < nd; k++) {
+        addDim(br.str());
+    }
+    posTol = br.f64();
+    const unsigned int na = br.u32();
+    for (unsigned int i = 0; i < na; i++) {
+        const string n = br.str();
+        const string d = br.str();
+        auto ai = new SMPActor(n, d);
+        ai->sCap = br.f64();
+        ai->vSal = br.mat();
+        ai->vr = (VotingRule)(br.u32());
+        if ((numDim != ai->vSal.numR()) || (1 != ai->vSal.numC())) {
+            delete ai;
+            throw KException("SMPModel::readCkptModel: saliences do not match the dimensions");
+        }
+        addActor(ai);
+    }
+    return;
+}
+
+
+void SMPModel::writeCkptState(BinWriter & bw, const State* s) const {
+    assert(numAct == s->pstns.size());
+    for (auto p : s->pstns) {
+        bw.mat(*((const VctrPstn*)p));
+    }
+    return;
+}
+
+
+State* SMPModel::readCkptState(BinReader & br) {
+    auto st = new SMPState(this);
+    for (unsigned int i = 0; i < numAct; i++) {
+        auto vpi = new VctrPstn(br.mat());
+        if ((numDim != vpi->numR()) || (1 != vpi->numC())) {
+            delete vpi;
+            delete st;
+            throw KException("SMPModel::readCkptState: position does not match the dimensions");
+        }
+        st->addPstn(vpi);
+    }
+    st->step = [st]() {
+        return st->stepBCN();
+    };
+    st->setUENdx();
+    return st;
+}
+
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
@@ -0,0 +1,320 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+//
+// Run an ensemble of SMP models in parallel, within one process.
+//
+// --------------------------------------------
+
+#include <atomic>
+#include <mutex>
+
+#include "smp.h"
+
+
+namespace SMPLib {
+using std::cout;
+using std::endl;
+using std::flush;
+using std::get;
+using std::string;
+using std::thread;
+
+using KBase::Logger;
+using KBase::PRNG;
+using KBase::KMatrix;
+using KBase::State;
+
+// --------------------------------------------
+
+SMPEnsemble::SMPEnsemble(const SMPScenario & sc, unsigned int nr, uint64_t seed) :
+    scen(sc), numRuns(nr) {
+    assert(0 < numRuns);
+    assert(2 < scen.numAct());
+    assert(0 < scen.numDim());
+
+    // Draw every run's seed up front, from one master stream, so that
+    // run r gets the same seed no matter which thread happens to run it.
+    auto rng = PRNG();
+    rng.setSeed(seed);
+    seeds = vector<uint64_t>();
+    for (unsigned int r = 0; r < numRuns; r++) {
+        seeds.push_back(rng.uniform());
+    }
+}
+
+
+SMPEnsemble::~SMPEnsemble() {}
+
+
+SMPEnsemble::RunRslt SMPEnsemble::runOne(unsigned int r) const {
+    auto rng = new PRNG();
+    rng->setSeed(seeds[r]);
+
+    auto sc = scen.perturb(rng, capNoise, posNoise, salNoise);
+
+    // Each run needs its own name and sink, as nothing is shared between runs
+    auto buff = newChars(200);
+    sprintf(buff, "%s-Run-%04u", scen.name.c_str(), r);
+    const string runName = buff;
+    delete[] buff;
+    buff = nullptr;
+    string dbName = "";
+    if (0 < dbPrefix.length()) {
+        buff = newChars(dbPrefix.length() + 20);
+        sprintf(buff, "%s-%04u.db", dbPrefix.c_str(), r);
+        dbName = buff;
+        delete[] buff;
+        buff = nullptr;
+    }
+
+    FILE* logFile = nullptr;
+    if (0 < logPrefix.length()) {
+        buff = newChars(logPrefix.length() + 20);
+        sprintf(buff, "%s-%04u.log", logPrefix.c_str(), r);
+        logFile = fopen(buff, "w");
+        delete[] buff;
+        buff = nullptr;
+        Logger::setThreadSink(logFile); // stdout if the open failed
+    }
+
+    auto md0 = SMPModel::initModel(sc, rng, runName, dbName);
+    md0->rptLvl = runRL;
+    md0->singlePrec = singlePrec;
+
+    md0->stop = SMPModel::quietStop(maxTurns, quietFactor);
+    md0->histPolicy = KBase::HistoryPolicy::KeepFirstLast; // only the last state is used
+
+    md0->run();
+
+    // the last state needs its utilities before we can get its probabilities
+    const unsigned int nState = md0->history.size();
+    auto lastState = ((SMPState*)(md0->history[nState - 1]));
+    lastState->setAUtil(-1, runRL);
+    md0->sqlAUtil(nState - 1);
+
+    const unsigned int na = md0->numAct;
+    const unsigned int nd = md0->numDim;
+    auto rslt = RunRslt();
+    rslt.turns = nState - 1;
+    rslt.pos = KMatrix(na, nd);
+    rslt.prb = KMatrix(na, 1);
+    auto pn = lastState->pDist(-1);
+    auto pdt = get<0>(pn);
+    auto unq = get<1>(pn);
+    for (unsigned int i = 0; i < na; i++) {
+        auto vpi = ((const VctrPstn*)(lastState->pstns[i]));
+        for (unsigned int j = 0; j < nd; j++) {
+            rslt.pos(i, j) = (*vpi)(j, 0);
+        }
+        rslt.prb(i, 0) = lastState->posProb(i, unq, pdt);
+    }
+
+    delete md0;
+    md0 = nullptr;
+    if (nullptr != logFile) {
+        Logger::flush();
+        Logger::setThreadSink(nullptr);
+        fclose(logFile);
+        logFile = nullptr;
+    }
+    delete rng;
+    rng = nullptr;
+    return rslt;
+}
+
+
+void SMPEnsemble::run() {
+    aggregate(runAll());
+    return;
+}
+
+
+vector<SMPEnsemble::RunRslt> SMPEnsemble::runAll() const {
+    unsigned int nt = numThreads;
+    if (0 == nt) {
+        nt = thread::hardware_concurrency();
+    }
+    if (0 == nt) { // not computable or not well defined
+        nt = 1;
+    }
+    if (numRuns < nt) {
+        nt = numRuns;
+    }
+
+    // Each worker claims the next unclaimed run, and writes only to its own slot
+    // of the results. Only the progress messages need a lock.
+    auto rslts = vector<RunRslt>(numRuns);
+    std::atomic<unsigned int> nextRun(0);
+    std::mutex showMtx;
+    auto worker = [this, &rslts, &nextRun, &showMtx]() {
+        unsigned int r = nextRun++;
+        while (r < numRuns) {
+            rslts[r] = runOne(r);
+            {
+                std::lock_guard<std::mutex> lk(showMtx);
+                printf("Ensemble run %4u finished after %3u turns \n", r, rslts[r].turns);
+                cout << flush;
+            }
+            r = nextRun++;
+        }
+        return;
+    };
+
+    printf("Starting %u runs on %u threads \n", numRuns, nt);
+    auto ts = vector<thread>();
+    for (unsigned int t = 0; t < nt; t++) {
+        ts.push_back(thread(worker));
+    }
+    for (auto& t : ts) {
+        t.join();
+    }
+    return rslts;
+}
+
+
+bool SMPEnsemble::checkSinglePrec(double posTol, double prbTol) {
+    const unsigned int na = scen.numAct();
+    const unsigned int nd = scen.numDim();
+    const bool sp0 = singlePrec;
+
+    singlePrec = false;
+    auto rd = runAll();
+    singlePrec = true;
+    auto rs = runAll();
+    singlePrec = sp0;
+
+    double posMax = 0.0;
+    double prbMax = 0.0;
+    unsigned int numTurnDiff = 0;
+    cout << endl;
+    cout << "Single vs double precision, largest difference in each run:" << endl;
+    cout << " Run  Turns(d) Turns(s)   Position  Probability" << endl;
+    for (unsigned int r = 0; r < numRuns; r++) {
+        const double dPos = KBase::maxAbs(rd[r].pos - rs[r].pos);
+        const double dPrb = KBase::maxAbs(rd[r].prb - rs[r].prb);
+        posMax = (dPos < posMax) ? posMax : dPos;
+        prbMax = (dPrb < prbMax) ? prbMax : dPrb;
+        if (rd[r].turns != rs[r].turns) {
+            numTurnDiff++;
+        }
+        printf("%4u  %8u %8u   %8.2e   %8.2e \n", r, rd[r].turns, rs[r].turns, dPos, dPrb);
+    }
+    const bool ok = (posMax <= posTol) && (prbMax <= prbTol);
+    printf("Largest position difference %.2e (tolerance %.2e) \n", posMax, posTol);
+    printf("Largest probability difference %.2e (tolerance %.2e) \n", prbMax, prbTol);
+    printf("%u of %u runs took a different number of turns \n", numTurnDiff, numRuns);
+    printf("Single precision %s, for %u actors and %u dimensions \n",
+           (ok ? "is within tolerance" : "is NOT within tolerance"), na, nd);
+    cout << flush;
+    return ok;
+}
+
+
+void SMPEnsemble::aggregate(const vector<RunRslt> & rslts) {
+    const unsigned int na = scen.numAct();
+    const unsigned int nd = scen.numDim();
+    const unsigned int nr = rslts.size();
+    assert(numRuns == nr);
+
+    posMean = KMatrix(na, nd);
+    posStdv = KMatrix(na, nd);
+    prbMean = KMatrix(na, 1);
+    prbStdv = KMatrix(na, 1);
+    prbMin = KMatrix(na, 1, 1.0);
+    prbMax = KMatrix(na, 1, 0.0);
+    numTurns = vector<unsigned int>();
+
+    for (auto& rr : rslts) {
+        posMean = posMean + rr.pos;
+        prbMean = prbMean + rr.prb;
+        numTurns.push_back(rr.turns);
+        for (unsigned int i = 0; i < na; i++) {
+            prbMin(i, 0) = (rr.prb(i, 0) < prbMin(i, 0)) ? rr.prb(i, 0) : prbMin(i, 0);
+            prbMax(i, 0) = (prbMax(i, 0) < rr.prb(i, 0)) ? rr.prb(i, 0) : prbMax(i, 0);
+        }
+    }
+    posMean = posMean / nr;
+    prbMean = prbMean / nr;
+
+    // population standard deviation, which is zero for a single run
+    for (auto& rr : rslts) {
+        for (unsigned int i = 0; i < na; i++) {
+            for (unsigned int j = 0; j < nd; j++) {
+                posStdv(i, j) = posStdv(i, j) + KBase::sqr(rr.pos(i, j) - posMean(i, j));
+            }
+            prbStdv(i, 0) = prbStdv(i, 0) + KBase::sqr(rr.prb(i, 0) - prbMean(i, 0));
+        }
+    }
+    posStdv = KMatrix::map([this, nr](unsigned int i, unsigned int j) {
+        return sqrt(posStdv(i, j) / nr);
+    }, na, nd);
+    prbStdv = KMatrix::map([this, nr](unsigned int i, unsigned int j) {
+        return sqrt(prbStdv(i, j) / nr);
+    }, na, 1);
+    return;
+}
+
+
+void SMPEnsemble::showResults() const {
+    const unsigned int na = scen.numAct();
+    const unsigned int nd = scen.numDim();
+    assert(numRuns == numTurns.size());
+
+    unsigned int tMin = numTurns[0];
+    unsigned int tMax = numTurns[0];
+    double tSum = 0;
+    for (auto t : numTurns) {
+        tMin = (t < tMin) ? t : tMin;
+        tMax = (tMax < t) ? t : tMax;
+        tSum = tSum + t;
+    }
+    printf("Ensemble of %u runs of %s \n", numRuns, scen.name.c_str());
+    printf("Turns: min %u, mean %.2f, max %u \n", tMin, tSum / numRuns, tMax);
+    cout << endl;
+
+    // same scale as the CSV input
+    cout << "Final positions, mean (stdv) over the ensemble:" << endl;
+    for (unsigned int i = 0; i < na; i++) {
+        printf("%-15s ", scen.aName[i].c_str());
+        for (unsigned int j = 0; j < nd; j++) {
+            printf(" %5.1f (%4.1f) ", 100 * posMean(i, j), 100 * posStdv(i, j));
+        }
+        cout << endl;
+    }
+    cout << endl;
+
+    cout << "Final probability of each actor's position: mean, stdv, min, max" << endl;
+    for (unsigned int i = 0; i < na; i++) {
+        printf("%-15s  %.4f  %.4f  %.4f  %.4f \n", scen.aName[i].c_str(),
+               prbMean(i, 0), prbStdv(i, 0), prbMin(i, 0), prbMax(i, 0));
+    }
+    cout << endl << flush;
+    return;
+}
+
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
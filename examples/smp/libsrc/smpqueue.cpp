@@ -0,0 +1,396 @@
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 King Abdullah Petroleum Studies and Research Center
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+// and associated documentation files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom
+// the Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING
+// BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------
+//
+// A job queue in SQLite, so that sweeps can be spread over many processes.
+//
+// --------------------------------------------
+
+#include <algorithm>
+
+#include "smp.h"
+#include "sqlite3.h"
+
+
+namespace SMPLib {
+using std::cout;
+using std::endl;
+using std::flush;
+using std::get;
+using std::string;
+
+using KBase::PRNG;
+using KBase::KMatrix;
+using KBase::KException;
+using KBase::State;
+
+// --------------------------------------------
+
+namespace {
+// Job status codes, as stored in the Jobs table
+const int JobPending = 0;
+const int JobClaimed = 1;
+const int JobDone = 2;
+const int JobFailed = 3;
+
+sqlite3 * openDB(string fName) {
+    sqlite3 * db = nullptr;
+    int rc = sqlite3_open(fName.c_str(), &db);
+    if (SQLITE_OK != rc) {
+        string msg = "SMPJobQueue: cannot open database " + fName + ": " + sqlite3_errmsg(db);
+        sqlite3_close(db);
+        throw(KException(msg));
+    }
+    // many processes can share the queue, so wait for locks rather than fail
+    sqlite3_busy_timeout(db, 60 * 1000);
+    return db;
+}
+
+void execSQL(sqlite3 * db, string sql) {
+    char* zErrMsg = nullptr;
+    int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &zErrMsg);
+    if (SQLITE_OK != rc) {
+        string msg = "SMPJobQueue: SQL error: " + string(zErrMsg) + " in: " + sql;
+        sqlite3_free(zErrMsg);
+        throw(KException(msg));
+    }
+    return;
+}
+
+// run one statement with one text parameter bound to ?1, such as a file name
+void execSQL1(sqlite3 * db, string sql, string p1) {
+    sqlite3_stmt *stmt = nullptr;
+    int rc = sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL);
+    if (SQLITE_OK == rc) {
+        sqlite3_bind_text(stmt, 1, p1.c_str(), -1, SQLITE_TRANSIENT);
+        rc = sqlite3_step(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if ((SQLITE_DONE != rc) && (SQLITE_ROW != rc)) {
+        string msg = "SMPJobQueue: SQL error: " + string(sqlite3_errmsg(db)) + " in: " + sql;
+        throw(KException(msg));
+    }
+    return;
+}
+
+// names of all the tables in the given (possibly attached) database
+vector<string> tableNames(sqlite3 * db, string schema) {
+    auto tns = vector<string>();
+    string sql = "SELECT name FROM " + schema + ".sqlite_master WHERE type = 'table'";
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, NULL);
+    while (SQLITE_ROW == sqlite3_step(stmt)) {
+        tns.push_back((const char*)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return tns;
+}
+}; // end of anonymous namespace
+
+
+SMPJobQueue::SMPJobQueue(string qFile) {
+    qDB = openDB(qFile);
+    execSQL(qDB, "create table if not exists Jobs ("  \
+            "JobID	INTEGER PRIMARY KEY, "\
+            "CSV	TEXT NOT NULL, "\
+            "Seed	INTEGER NOT NULL DEFAULT 0, "\
+            "Noise	REAL NOT NULL DEFAULT 0, "\
+            "MaxTurns	INTEGER NOT NULL DEFAULT 100, "\
+            "Status	INTEGER NOT NULL DEFAULT 0, "\
+            "Worker	TEXT, "\
+            "Shard	TEXT, "\
+            "Claimed	INTEGER, "\
+            "Finished	INTEGER"\
+            ");");
+}
+
+
+SMPJobQueue::~SMPJobQueue() {
+    if (nullptr != qDB) {
+        sqlite3_close(qDB);
+        qDB = nullptr;
+    }
+}
+
+
+string SMPJobQueue::jobScenName(unsigned int jobID) {
+    // must match the printf in merge
+    auto buff = newChars(50);
+    sprintf(buff, "Job-%06u", jobID);
+    string sn = buff;
+    delete[] buff;
+    return sn;
+}
+
+
+unsigned int SMPJobQueue::addJobs(string csvFile, unsigned int numSeeds, uint64_t seed0,
+                                  double noise, unsigned int maxTurns) {
+    // the same master stream as SMPEnsemble, so a job can be checked against an ensemble run
+    auto rng = PRNG();
+    rng.setSeed(seed0);
+
+    sqlite3_stmt *insStmt;
+    const char* insStr = "INSERT INTO Jobs (CSV, Seed, Noise, MaxTurns) VALUES (?1, ?2, ?3, ?4)";
+    sqlite3_prepare_v2(qDB, insStr, -1, &insStmt, NULL);
+    execSQL(qDB, "BEGIN IMMEDIATE");
+    for (unsigned int k = 0; k < numSeeds; k++) {
+        const uint64_t sk = rng.uniform();
+        sqlite3_bind_text(insStmt, 1, csvFile.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(insStmt, 2, (sqlite3_int64)sk); // stored as the same 64 bits
+        sqlite3_bind_double(insStmt, 3, noise);
+        sqlite3_bind_int(insStmt, 4, maxTurns);
+        int rslt = sqlite3_step(insStmt);
+        assert(SQLITE_DONE == rslt);
+        sqlite3_clear_bindings(insStmt);
+        sqlite3_reset(insStmt);
+    }
+    execSQL(qDB, "COMMIT");
+    sqlite3_finalize(insStmt);
+    return numSeeds;
+}
+
+
+bool SMPJobQueue::claim(string workerID, SMPJobQueue::Job & job) {
+    const sqlite3_int64 now = std::time(nullptr);
+    bool found = false;
+
+    // BEGIN IMMEDIATE takes the write lock at once, so no two workers claim the same job
+    execSQL(qDB, "BEGIN IMMEDIATE");
+    sqlite3_stmt *selStmt;
+    const char* selStr = "SELECT JobID, CSV, Seed, Noise, MaxTurns FROM Jobs "\
+                         "WHERE (Status = ?1) OR ((Status = ?2) AND (Claimed < ?3)) ORDER BY JobID LIMIT 1";
+    sqlite3_prepare_v2(qDB, selStr, -1, &selStmt, NULL);
+    sqlite3_bind_int(selStmt, 1, JobPending);
+    sqlite3_bind_int(selStmt, 2, JobClaimed);
+    sqlite3_bind_int64(selStmt, 3, now - leaseSec);
+    if (SQLITE_ROW == sqlite3_step(selStmt)) {
+        found = true;
+        job.id = sqlite3_column_int(selStmt, 0);
+        job.csvFile = (const char*)sqlite3_column_text(selStmt, 1);
+        job.seed = (uint64_t)sqlite3_column_int64(selStmt, 2);
+        job.noise = sqlite3_column_double(selStmt, 3);
+        job.maxTurns = sqlite3_column_int(selStmt, 4);
+    }
+    sqlite3_finalize(selStmt);
+
+    if (found) {
+        sqlite3_stmt *updStmt;
+        const char* updStr = "UPDATE Jobs SET Status = ?1, Worker = ?2, Claimed = ?3 WHERE JobID = ?4";
+        sqlite3_prepare_v2(qDB, updStr, -1, &updStmt, NULL);
+        sqlite3_bind_int(updStmt, 1, JobClaimed);
+        sqlite3_bind_text(updStmt, 2, workerID.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(updStmt, 3, now);
+        sqlite3_bind_int(updStmt, 4, job.id);
+        int rslt = sqlite3_step(updStmt);
+        assert(SQLITE_DONE == rslt);
+        sqlite3_finalize(updStmt);
+    }
+    execSQL(qDB, "COMMIT");
+    return found;
+}
+
+
+bool SMPJobQueue::finish(const SMPJobQueue::Job & job, string workerID, string shard, bool ok) {
+    // Only while this worker still holds the claim: if the lease lapsed and another
+    // worker took the job, that worker's result is the one recorded.
+    sqlite3_stmt *updStmt;
+    const char* updStr = "UPDATE Jobs SET Status = ?1, Shard = ?2, Finished = ?3 "\
+                         "WHERE (JobID = ?4) AND (Worker = ?5) AND (Status = ?6)";
+    sqlite3_prepare_v2(qDB, updStr, -1, &updStmt, NULL);
+    sqlite3_bind_int(updStmt, 1, ok ? JobDone : JobFailed);
+    sqlite3_bind_text(updStmt, 2, shard.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(updStmt, 3, std::time(nullptr));
+    sqlite3_bind_int(updStmt, 4, job.id);
+    sqlite3_bind_text(updStmt, 5, workerID.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(updStmt, 6, JobClaimed);
+    int rslt = sqlite3_step(updStmt);
+    assert(SQLITE_DONE == rslt);
+    const bool held = (1 == sqlite3_changes(qDB));
+    sqlite3_finalize(updStmt);
+    return held;
+}
+
+
+void SMPJobQueue::runJob(const SMPJobQueue::Job & job, const SMPScenario & sc, string shard) const {
+    const string sn = jobScenName(job.id);
+
+    // If this worker died part way through this job before, the shard holds
+    // some of its rows already. Clear them out, so the job is recorded just once.
+    auto sdb = openDB(shard);
+    for (auto tn : tableNames(sdb, "main")) {
+        execSQL(sdb, "DELETE FROM " + tn + " WHERE Scenario = '" + sn + "'");
+    }
+    sqlite3_close(sdb);
+    sdb = nullptr;
+
+    auto rng = new PRNG();
+    rng->setSeed(job.seed);
+    auto psc = sc.perturb(rng, job.noise, job.noise, job.noise);
+
+    auto md0 = SMPModel::initModel(psc, rng, sn, shard);
+    md0->rptLvl = ReportingLevel::Silent;
+    md0->stop = SMPModel::quietStop(job.maxTurns, 20.0);
+    md0->run();
+
+    // record the last actor posUtil table, and the whole history of positions
+    const unsigned int nState = md0->history.size();
+    auto lastState = ((SMPState*)(md0->history[nState - 1]));
+    lastState->setAUtil(-1, ReportingLevel::Silent);
+    md0->sqlAUtil(nState - 1);
+    md0->sqlVPHistory();
+
+    delete md0; // closes the shard
+    md0 = nullptr;
+    delete rng;
+    rng = nullptr;
+    return;
+}
+
+
+unsigned int SMPJobQueue::work(string workerID, string shardPrefix, unsigned int maxJobs) {
+    const string shard = shardPrefix + "-" + workerID + ".db";
+
+    // A worker restarted under the same name takes back its own unfinished jobs at once,
+    // rather than waiting for the lease to expire.
+    sqlite3_stmt *rlsStmt;
+    const char* rlsStr = "UPDATE Jobs SET Status = ?1 WHERE (Status = ?2) AND (Worker = ?3)";
+    sqlite3_prepare_v2(qDB, rlsStr, -1, &rlsStmt, NULL);
+    sqlite3_bind_int(rlsStmt, 1, JobPending);
+    sqlite3_bind_int(rlsStmt, 2, JobClaimed);
+    sqlite3_bind_text(rlsStmt, 3, workerID.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_step(rlsStmt);
+    sqlite3_finalize(rlsStmt);
+
+    // consecutive jobs usually share a scenario, so parse it only when it changes
+    string lastCSV = "";
+    auto sc = SMPScenario();
+
+    unsigned int numDone = 0;
+    auto job = Job();
+    while (((0 == maxJobs) || (numDone < maxJobs)) && claim(workerID, job)) {
+        printf("Worker %s starting job %u \n", workerID.c_str(), job.id);
+        cout << flush;
+        bool ok = true;
+        try {
+            if (job.csvFile != lastCSV) {
+                sc = SMPModel::parseScenario(job.csvFile);
+                lastCSV = job.csvFile;
+            }
+            runJob(job, sc, shard);
+        }
+        catch (KException & ke) {
+            printf("Worker %s failed job %u: %s \n", workerID.c_str(), job.id, ke.msg.c_str());
+            lastCSV = "";
+            ok = false;
+        }
+        catch (std::exception & e) {
+            printf("Worker %s failed job %u: %s \n", workerID.c_str(), job.id, e.what());
+            lastCSV = "";
+            ok = false;
+        }
+        if (finish(job, workerID, shard, ok)) {
+            numDone++;
+        }
+        else {
+            printf("Worker %s lost its lease on job %u, so its result is not recorded \n",
+                   workerID.c_str(), job.id);
+        }
+    }
+    printf("Worker %s completed %u jobs \n", workerID.c_str(), numDone);
+    return numDone;
+}
+
+
+tuple<unsigned int, unsigned int, unsigned int, unsigned int> SMPJobQueue::status() const {
+    unsigned int n[4] = { 0, 0, 0, 0 };
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(qDB, "SELECT Status, COUNT(*) FROM Jobs GROUP BY Status", -1, &stmt, NULL);
+    while (SQLITE_ROW == sqlite3_step(stmt)) {
+        int st = sqlite3_column_int(stmt, 0);
+        assert((JobPending <= st) && (st <= JobFailed));
+        n[st] = sqlite3_column_int(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return tuple<unsigned int, unsigned int, unsigned int, unsigned int>(n[0], n[1], n[2], n[3]);
+}
+
+
+void SMPJobQueue::showStatus() const {
+    auto st = status();
+    printf("Jobs pending: %u, claimed: %u, done: %u, failed: %u \n",
+           get<0>(st), get<1>(st), get<2>(st), get<3>(st));
+    cout << flush;
+    return;
+}
+
+
+void SMPJobQueue::merge(string qFile, string outDB) {
+    auto db = openDB(outDB);
+    execSQL(db, "PRAGMA synchronous = OFF");
+    execSQL1(db, "ATTACH DATABASE ?1 AS q", qFile);
+
+    auto shards = vector<string>();
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db, "SELECT DISTINCT Shard FROM q.Jobs WHERE Status = 2", -1, &stmt, NULL);
+    while (SQLITE_ROW == sqlite3_step(stmt)) {
+        shards.push_back((const char*)sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+
+    for (auto shard : shards) {
+        printf("Merging shard %s \n", shard.c_str());
+        cout << flush;
+        execSQL1(db, "ATTACH DATABASE ?1 AS s", shard);
+
+        // Only jobs finished in this shard. Merging twice replaces, rather than duplicates.
+        const string jobs = "(SELECT printf('Job-%06d', JobID) FROM q.Jobs "\
+                            "WHERE (Status = 2) AND (Shard = ?1))";
+
+        execSQL(db, "BEGIN TRANSACTION");
+        sqlite3_prepare_v2(db, "SELECT name, sql FROM s.sqlite_master WHERE type = 'table'", -1, &stmt, NULL);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            const string tn = (const char*)sqlite3_column_text(stmt, 0);
+            const string tSQL = (const char*)sqlite3_column_text(stmt, 1);
+            auto mtns = tableNames(db, "main");
+            if (mtns.end() == std::find(mtns.begin(), mtns.end(), tn)) {
+                execSQL(db, tSQL);
+            }
+            execSQL1(db, "DELETE FROM main." + tn + " WHERE Scenario IN " + jobs, shard);
+            execSQL1(db, "INSERT INTO main." + tn + " SELECT * FROM s." + tn + " WHERE Scenario IN " + jobs, shard);
+        }
+        sqlite3_finalize(stmt);
+        execSQL(db, "COMMIT");
+        execSQL(db, "DETACH DATABASE s");
+    }
+
+    execSQL(db, "DETACH DATABASE q");
+    sqlite3_close(db);
+    printf("Merged %u shards into %s \n", (unsigned int)shards.size(), outDB.c_str());
+    return;
+}
+
+
+}; // end of namespace
+
+// --------------------------------------------
+// Copyright KAPSARC. Open source MIT License.
+// --------------------------------------------
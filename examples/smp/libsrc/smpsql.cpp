@@ -55,7 +55,7 @@ string SMPModel::createSMPTableSQL(unsigned int tn)  {
     switch (tn) {
     case 0:
         // coordinates of each actor's position
-        sql = "create table VectorPosition ("  \
+        sql = "create table if not exists VectorPosition ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t		INTEGER NOT NULL DEFAULT 0, "\
               "Act_i		INTEGER NOT NULL DEFAULT 0, "\
@@ -66,7 +66,7 @@ string SMPModel::createSMPTableSQL(unsigned int tn)  {
 
     case 1:
         // salience to each actor of each dimension
-        sql = "create table SpatialSalience ("  \
+        sql = "create table if not exists SpatialSalience ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t		INTEGER NOT NULL DEFAULT 0, "\
               "Act_i		INTEGER NOT NULL DEFAULT 0, "\
@@ -77,7 +77,7 @@ string SMPModel::createSMPTableSQL(unsigned int tn)  {
 
     case 2:
         // scalar capability of each actor
-        sql = "create table SpatialCapability ("  \
+        sql = "create table if not exists SpatialCapability ("  \
               "Scenario	TEXT NOT NULL DEFAULT 'NoName', "\
               "Turn_t		INTEGER NOT NULL DEFAULT 0, "\
               "Act_i		INTEGER NOT NULL DEFAULT 0, "\
@@ -92,7 +92,7 @@ string SMPModel::createSMPTableSQL(unsigned int tn)  {
 }
 
 
-void SMPModel::sqlTest() {
+void SMPModel::sqlTest(string dbName) {
     // just a test to get linkages correct
 
     auto callBack = [](void *NotUsed, int argc, char **argv, char **azColName) {
@@ -108,8 +108,8 @@ void SMPModel::sqlTest() {
     char* zErrMsg = nullptr;
     string sql;
 
-    auto sOpen = [&db](unsigned int n) {
-        int rc = sqlite3_open("test.db", &db);
+    auto sOpen = [&db, dbName](unsigned int n) {
+        int rc = sqlite3_open(dbName.c_str(), &db);
         if (rc != SQLITE_OK) {
             fprintf(stdout, "Can't open database: %s\n", sqlite3_errmsg(db));
             exit(0);
@@ -144,7 +144,7 @@ void SMPModel::sqlTest() {
     sqlite3_exec(db, "PRAGMA journal_mode = MEMORY", NULL, NULL, &zErrMsg);
 
     // Create & execute SQL statements
-    for (unsigned int i = 0; i < 12; i++) {
+    for (unsigned int i = 0; i < 13; i++) {
         auto buff = newChars(50);
         sprintf(buff, "Created Model table %u successfully \n", i);
         sql = createTableSQL(i);
@@ -53,12 +53,14 @@ namespace DemoSMP {
   using SMPLib::SMPModel;
   using SMPLib::SMPActor;
   using SMPLib::SMPState;
+  using SMPLib::SMPScenario;
+  using SMPLib::SMPEnsemble;
 
   // -------------------------------------------------
   
 
   void demoEUSpatial(unsigned int numA, unsigned int sDim, uint64_t s, PRNG* rng) {
-    printf("Using PRNG seed: %020llu \n", s);
+    printf("Using PRNG seed: %020llu \n", (unsigned long long) s);
     rng->setSeed(s);
     if (0 == numA) {
       numA = 5 + (rng->uniform() % 6); // i.e. [5,10] inclusive
@@ -155,9 +157,9 @@ namespace DemoSMP {
       cout << "voting rule: " << vrName(ai->vr) << endl;
       cout << "Pos vector: ";
       VctrPstn * pi = ((VctrPstn*)(st0->pstns[i]));
-      trans(*pi).mPrintf(" %+7.4f ");
+      pi->tView().mPrintf(" %+7.4f ");
       cout << "Sal vector: ";
-      trans(ai->vSal).mPrintf(" %+7.4f ");
+      ai->vSal.tView().mPrintf(" %+7.4f ");
       printf("Capability: %.3f \n", ai->sCap);
       printf("Risk attitude: %+.4f \n", ri);
       cout << endl;
@@ -241,10 +243,37 @@ namespace DemoSMP {
     return;
   }
 
-  void readEUSpatial(uint64_t seed, string inputCSV, PRNG* rng) {
-    auto md0 = SMPModel::readCSV(inputCSV, rng);
+  // the input may be CSV, or a binary scenario file
+  void readEUSpatial(uint64_t seed, string inputCSV, string spillFile, string ckptFile,
+                     unsigned int ckptEvery, unsigned int maxIter, bool singlePrec, PRNG* rng) {
+    auto md0 = SMPModel::initModel(SMPModel::parseScenario(inputCSV), rng);
+    md0->singlePrec = singlePrec;
+    if (0 < spillFile.length()) {
+      md0->spillHistory(spillFile);
+    }
+    if (0 < ckptFile.length()) {
+      md0->ckptFile = ckptFile;
+      md0->ckptEvery = ckptEvery;
+    }
+    runEUSpatial(md0, maxIter);
+    return;
+  }
 
-    const unsigned int maxIter = 5;
+  // carry on from the checkpoint, saving new checkpoints to the same file
+  void resumeEUSpatial(string ckptFile, string spillFile, unsigned int ckptEvery,
+                       unsigned int maxIter, PRNG* rng) {
+    auto md0 = SMPModel::resume(ckptFile, rng);
+    if (0 < spillFile.length()) {
+      md0->spillHistory(spillFile);
+    }
+    md0->ckptFile = ckptFile;
+    md0->ckptEvery = ckptEvery;
+    runEUSpatial(md0, maxIter);
+    return;
+  }
+
+  // run until turn maxIter, show the history, and delete the model
+  void runEUSpatial(SMPModel* md0, unsigned int maxIter) {
     md0->stop = [maxIter](unsigned int iter, const State * s) {
       return (maxIter <= iter);
     };
@@ -252,6 +281,12 @@ namespace DemoSMP {
     cout << "Starting model run" << endl << flush;
     md0->run();
 
+    // record the last actor posUtil table
+    const unsigned int nState = md0->history.size();
+    auto lastState = ((SMPState*)(md0->history[nState - 1]));
+    lastState->setAUtil(-1, ReportingLevel::Low);
+    md0->sqlAUtil(nState - 1);
+
     cout << "Completed model run" << endl << endl;
 
     cout << "History of actor positions over time" << endl;
@@ -261,6 +296,62 @@ namespace DemoSMP {
     return;
   }
 
+  void ensembleEUSpatial(uint64_t seed, string inputCSV, unsigned int numRuns,
+                         unsigned int numThreads, double noise, string dbPrefix,
+                         string logPrefix, bool singlePrec, bool checkSP) {
+    auto sc = SMPModel::parseScenario(inputCSV);
+    auto ens = SMPEnsemble(sc, numRuns, seed);
+    ens.numThreads = numThreads;
+    ens.capNoise = noise;
+    ens.posNoise = noise;
+    ens.salNoise = noise;
+    ens.dbPrefix = dbPrefix;
+    ens.singlePrec = singlePrec;
+    if (checkSP) {
+      ens.checkSinglePrec();
+      return;
+    }
+    if (0 < logPrefix.length()) {
+      // many runs logging at once: let a background thread do the writing
+      ens.logPrefix = logPrefix;
+      ens.runRL = ReportingLevel::Medium;
+      KBase::Logger::setAsync(true);
+    }
+    ens.run();
+    KBase::Logger::setAsync(false);
+    ens.showResults();
+    return;
+  }
+
+  void convertCSV(string inputCSV, string outputBin) {
+    auto sc = SMPModel::parseCSV(inputCSV, ReportingLevel::Low);
+    sc.writeBinary(outputBin);
+    const auto sm = SMPLib::SMPScenarioMap(outputBin); // check that it reads back
+    printf("Wrote %u actors on %u dimensions to %s \n", sm.numAct(), sm.numDim(), outputBin.c_str());
+    return;
+  }
+
+  void queueEUSpatial(string queueFile, string jobCSV, unsigned int numJobs, uint64_t seed,
+                      double noise, string workerID, string shardPrefix, string mergeDB) {
+    auto q = new SMPLib::SMPJobQueue(queueFile);
+    if (0 < numJobs) {
+      const unsigned int maxTurns = 100;
+      q->addJobs(jobCSV, numJobs, seed, noise, maxTurns);
+      printf("Added %u jobs for %s \n", numJobs, jobCSV.c_str());
+    }
+    if (0 < workerID.length()) {
+      q->work(workerID, shardPrefix);
+    }
+    q->showStatus();
+    delete q;
+    q = nullptr;
+
+    if (0 < mergeDB.length()) {
+      SMPLib::SMPJobQueue::merge(queueFile, mergeDB);
+    }
+    return;
+  }
+
 } // end of namespace
 
 
@@ -276,6 +367,26 @@ int main(int ac, char **av) {
   bool euSmpP = false;
   bool csvP = false;
   string inputCSV = "";
+  unsigned int ensRuns = 0;
+  unsigned int ensThreads = 0;
+  double ensNoise = 0.0;
+  string ensDB = "";
+  string ensLog = "";
+  bool singlePrec = false;
+  bool checkSP = false;
+  string profCSV = "";
+  string queueFile = "";
+  string jobCSV = "";
+  unsigned int numJobs = 0;
+  string workerID = "";
+  string shardPrefix = "shard";
+  string mergeDB = "";
+  string binOut = "";
+  string spillFile = "";
+  unsigned int maxTurns = 5;
+  string ckptFile = "";
+  unsigned int ckptEvery = 0;
+  string resumeFile = "";
 
   cout << "smpApp version " << DemoSMP::appVersion << endl << endl;
 
@@ -285,9 +396,29 @@ int main(int ac, char **av) {
     printf("--help            print this message\n");
     printf("--euSMP           exp. util. of spatial model of politics\n");
     printf("--csv <f>         read a scenario from CSV\n");
+    printf("--bin <f>         read a scenario from a binary file, as written by --csv2bin\n");
+    printf("--csv2bin <c> <b> convert CSV scenario c to binary file b, then stop\n");
+    printf("--turns <n>       turns for the CSV run (default 5) \n");
+    printf("--ckpt <f> <n>    checkpoint the CSV run to file f every n turns\n");
+    printf("--resume <f>      carry on the run checkpointed in f, to --turns (uses --ckpt n)\n");
+    printf("--spill <f>       keep only the ends of the CSV run's history in memory, spilling the rest to f\n");
+    printf("--ens <n>         run the CSV (or binary) scenario n times, in parallel\n");
+    printf("--threads <n>     threads for the ensemble, 0 means all (default) \n");
+    printf("--noise <x>       relative noise in ensemble inputs (default 0) \n");
+    printf("--ensDB <p>       record ensemble run r to file <p>-r.db\n");
+    printf("--ensLog <p>      log ensemble run r to file <p>-r.log\n");
+    printf("--fp32            do the turn kernels of the CSV run or ensemble in single precision\n");
+    printf("--fp32check       run the ensemble in both precisions, and compare the results\n");
+    printf("--profile <f>     time the hot paths, writing totals per thread to CSV file f\n");
+    printf("                  (per-turn totals go to the TurnProfile table)\n");
+    printf("--queue <f>       use the SQLite job queue in file f, with one or more of\n");
+    printf("  --addJobs <f> <n>    add n jobs for the CSV or binary scenario (uses --seed and --noise)\n");
+    printf("  --worker <id>        run queued jobs, recording to shard <p>-<id>.db\n");
+    printf("  --shard <p>          shard prefix (default: shard) \n");
+    printf("  --merge <f>          merge all finished jobs from their shards into f\n");
     printf("--seed <n>        set a 64bit seed\n");
     printf("                  0 means truly random\n");
-    printf("                  default: %020llu \n", dSeed);
+    printf("                  default: %020llu \n", (unsigned long long) dSeed);
   };
 
   // tmp args
@@ -304,6 +435,87 @@ int main(int ac, char **av) {
         i++;
         inputCSV = av[i];
       }
+      else if (strcmp(av[i], "--bin") == 0) {
+        csvP = true;
+        i++;
+        inputCSV = av[i];
+      }
+      else if (strcmp(av[i], "--csv2bin") == 0) {
+        i++;
+        inputCSV = av[i];
+        i++;
+        binOut = av[i];
+      }
+      else if (strcmp(av[i], "--turns") == 0) {
+        i++;
+        maxTurns = std::stoul(av[i]);
+      }
+      else if (strcmp(av[i], "--ckpt") == 0) {
+        i++;
+        ckptFile = av[i];
+        i++;
+        ckptEvery = std::stoul(av[i]);
+      }
+      else if (strcmp(av[i], "--resume") == 0) {
+        i++;
+        resumeFile = av[i];
+      }
+      else if (strcmp(av[i], "--spill") == 0) {
+        i++;
+        spillFile = av[i];
+      }
+      else if (strcmp(av[i], "--ens") == 0) {
+        i++;
+        ensRuns = std::stoul(av[i]);
+      }
+      else if (strcmp(av[i], "--threads") == 0) {
+        i++;
+        ensThreads = std::stoul(av[i]);
+      }
+      else if (strcmp(av[i], "--noise") == 0) {
+        i++;
+        ensNoise = std::stod(av[i]);
+      }
+      else if (strcmp(av[i], "--ensDB") == 0) {
+        i++;
+        ensDB = av[i];
+      }
+      else if (strcmp(av[i], "--ensLog") == 0) {
+        i++;
+        ensLog = av[i];
+      }
+      else if (strcmp(av[i], "--fp32") == 0) {
+        singlePrec = true;
+      }
+      else if (strcmp(av[i], "--fp32check") == 0) {
+        checkSP = true;
+      }
+      else if (strcmp(av[i], "--profile") == 0) {
+        i++;
+        profCSV = av[i];
+      }
+      else if (strcmp(av[i], "--queue") == 0) {
+        i++;
+        queueFile = av[i];
+      }
+      else if (strcmp(av[i], "--addJobs") == 0) {
+        i++;
+        jobCSV = av[i];
+        i++;
+        numJobs = std::stoul(av[i]);
+      }
+      else if (strcmp(av[i], "--worker") == 0) {
+        i++;
+        workerID = av[i];
+      }
+      else if (strcmp(av[i], "--shard") == 0) {
+        i++;
+        shardPrefix = av[i];
+      }
+      else if (strcmp(av[i], "--merge") == 0) {
+        i++;
+        mergeDB = av[i];
+      }
       else if (strcmp(av[i], "--euSMP") == 0) {
         euSmpP = true;
       }
@@ -322,10 +534,25 @@ int main(int ac, char **av) {
     return 0;
   }
 
+  if (0 < binOut.length()) {
+    DemoSMP::convertCSV(inputCSV, binOut);
+    return 0;
+  }
+
+  // the job queue, or resuming a run, replaces the usual demos
+  if ((0 < queueFile.length()) || (0 < resumeFile.length())) {
+    euSmpP = false;
+    csvP = false;
+  }
+
+  if (0 < profCSV.length()) {
+    KBase::Profiler::setEnabled(true);
+  }
+
   PRNG * rng = new PRNG();
   seed = rng->setSeed(seed); // 0 == get a random number
-  printf("Using PRNG seed:  %020llu \n", seed);
-  printf("Same seed in hex:   0x%016llX \n", seed);
+  printf("Using PRNG seed:  %020llu \n", (unsigned long long) seed);
+  printf("Same seed in hex:   0x%016llX \n", (unsigned long long) seed);
 
   // note that we reset the seed every time, so that in case something
   // goes wrong, we need not scroll back too far to find the
@@ -334,12 +561,33 @@ int main(int ac, char **av) {
     cout << "-----------------------------------" << endl;
     DemoSMP::demoEUSpatial(0, 0, seed, rng);
   }
-  if (csvP) {
+  if (csvP && (0 == ensRuns)) {
+    cout << "-----------------------------------" << endl;
+    DemoSMP::readEUSpatial(seed, inputCSV, spillFile, ckptFile, ckptEvery, maxTurns, singlePrec, rng);
+  }
+  if (0 < resumeFile.length()) {
+    cout << "-----------------------------------" << endl;
+    DemoSMP::resumeEUSpatial(resumeFile, spillFile, ckptEvery, maxTurns, rng);
+  }
+  if (csvP && (0 < ensRuns)) {
     cout << "-----------------------------------" << endl;
-    DemoSMP::readEUSpatial(seed, inputCSV, rng);
+    DemoSMP::ensembleEUSpatial(seed, inputCSV, ensRuns, ensThreads, ensNoise, ensDB, ensLog,
+                               singlePrec, checkSP);
+  }
+  if (0 < queueFile.length()) {
+    cout << "-----------------------------------" << endl;
+    DemoSMP::queueEUSpatial(queueFile, jobCSV, numJobs, seed, ensNoise,
+                            workerID, shardPrefix, mergeDB);
   }
   cout << "-----------------------------------" << endl;
 
+  if (0 < profCSV.length()) {
+    cout << "Profile, all threads:" << endl;
+    KBase::Profiler::show(KBase::Profiler::totalStats());
+    KBase::Profiler::writeCSV(profCSV);
+    cout << "-----------------------------------" << endl;
+  }
+
 
   delete rng;
   KBase::displayProgramEnd(sTime);
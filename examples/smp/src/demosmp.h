@@ -49,6 +49,17 @@ const string appVersion = "0.1";
 
 void demoActorUtils(uint64_t s, PRNG* rng);
 void demoEUSpatial(unsigned int numA, unsigned int sDim, uint64_t s, PRNG* rng);
+void readEUSpatial(uint64_t seed, string inputCSV, string spillFile, string ckptFile,
+                   unsigned int ckptEvery, unsigned int maxIter, bool singlePrec, PRNG* rng);
+void resumeEUSpatial(string ckptFile, string spillFile, unsigned int ckptEvery,
+                     unsigned int maxIter, PRNG* rng);
+void runEUSpatial(SMPLib::SMPModel* md0, unsigned int maxIter);
+void convertCSV(string inputCSV, string outputBin);
+void ensembleEUSpatial(uint64_t seed, string inputCSV, unsigned int numRuns,
+                       unsigned int numThreads, double noise, string dbPrefix,
+                       string logPrefix, bool singlePrec, bool checkSP);
+void queueEUSpatial(string queueFile, string jobCSV, unsigned int numJobs, uint64_t seed,
+                    double noise, string workerID, string shardPrefix, string mergeDB);
 
 
 }; // end of namespace